@@ -2857,8 +2857,16 @@ void MainWindow::on_actionProfile_search_triggered()
         on_actionShow_search_profiler_triggered();
     }
     QStringList args;
-    args << "--cp-profiler"
-         << QString::number(conductor->getNextExecId()) + "," + QString::number(conductor->getListenPort());
+    auto sc = getCurrentSolverConfig();
+    auto localServer = conductor->getLocalServerName();
+    if (sc && sc->solverDefinition.stdFlags.contains("--cp-profiler-local") && !localServer.isEmpty()) {
+        // The solver runs on this machine: avoid the loopback TCP overhead
+        args << "--cp-profiler-local"
+             << QString::number(conductor->getNextExecId()) + "," + localServer;
+    } else {
+        args << "--cp-profiler"
+             << QString::number(conductor->getNextExecId()) + "," + QString::number(conductor->getListenPort());
+    }
     compileOrRun(CM_RUN, nullptr, QString(), QStringList(), QString(), args);
 }
 
@@ -3,6 +3,12 @@ SOURCES += \
     $$PWD/src/cpprofiler/command_line_parser.cpp \
     $$PWD/src/cpprofiler/name_map.cpp \
     $$PWD/src/cpprofiler/tcp_server.cpp \
+    $$PWD/src/cpprofiler/local_server.cpp \
+    $$PWD/src/cpprofiler/frame_capture.cpp \
+    $$PWD/src/cpprofiler/replay_thread.cpp \
+    $$PWD/src/cpprofiler/execution_export.cpp \
+    $$PWD/src/cpprofiler/headless_conductor.cpp \
+    $$PWD/src/cpprofiler/solver_listener.cpp \
     $$PWD/src/cpprofiler/receiver_thread.cpp \
     $$PWD/src/cpprofiler/receiver_worker.cpp \
     $$PWD/src/cpprofiler/conductor.cpp \
@@ -16,6 +22,11 @@ SOURCES += \
     $$PWD/src/cpprofiler/utils/path_utils.cpp \
     $$PWD/src/cpprofiler/utils/tree_utils.cpp \
     $$PWD/src/cpprofiler/utils/perf_helper.cpp \
+    $$PWD/src/cpprofiler/utils/debug_mutex.cpp \
+    $$PWD/src/cpprofiler/utils/byte_arena.cpp \
+    $$PWD/src/cpprofiler/utils/json_scanner.cpp \
+    $$PWD/src/cpprofiler/utils/byte_ring.cpp \
+    $$PWD/src/cpprofiler/utils/task_pool.cpp \
     $$PWD/src/cpprofiler/utils/array.cpp \
     $$PWD/src/cpprofiler/utils/std_ext.cpp \
     $$PWD/src/cpprofiler/utils/maybe_caller.cpp \
@@ -23,8 +34,12 @@ SOURCES += \
     $$PWD/src/cpprofiler/tree/structure.cpp \
     $$PWD/src/cpprofiler/tree/layout.cpp \
     $$PWD/src/cpprofiler/tree/layout_computer.cpp \
+    $$PWD/src/cpprofiler/tree/layout_worker.cpp \
     $$PWD/src/cpprofiler/tree/shape.cpp \
+    $$PWD/src/cpprofiler/tree/shape_pool.cpp \
+    $$PWD/src/cpprofiler/tree/extent_kernels.cpp \
     $$PWD/src/cpprofiler/tree/node_tree.cpp \
+    $$PWD/src/cpprofiler/tree/label_pool.cpp \
     $$PWD/src/cpprofiler/tree/node_id.cpp \
     $$PWD/src/cpprofiler/tree/node_info.cpp \
     $$PWD/src/cpprofiler/tree/visual_flags.cpp \
@@ -35,6 +50,7 @@ SOURCES += \
     $$PWD/src/cpprofiler/pixel_views/pixel_widget.cpp \
     $$PWD/src/cpprofiler/tree/tree_scroll_area.cpp \
     $$PWD/src/cpprofiler/tree/cursors/node_cursor.cpp \
+    $$PWD/src/cpprofiler/tree/cursors/contour_layout_cursor.cpp \
     $$PWD/src/cpprofiler/tree/cursors/drawing_cursor.cpp \
     $$PWD/src/cpprofiler/tree/cursors/layout_cursor.cpp \
     $$PWD/src/cpprofiler/tree/cursors/hide_failed_cursor.cpp \
@@ -51,6 +67,7 @@ SOURCES += \
     $$PWD/src/cpprofiler/tree/node_drawing.cpp \
     $$PWD/src/cpprofiler/db_handler.cpp \
     $$PWD/src/cpprofiler/solver_data.cpp \
+    $$PWD/src/cpprofiler/id_map.cpp \
     $$PWD/src/cpprofiler/nogood_dialog.cpp \
 
 HEADERS += \
@@ -61,6 +78,12 @@ HEADERS += \
     $$PWD/src/cpprofiler/settings.hh \
     $$PWD/src/cpprofiler/conductor.hh \
     $$PWD/src/cpprofiler/tcp_server.hh \
+    $$PWD/src/cpprofiler/local_server.hh \
+    $$PWD/src/cpprofiler/frame_capture.hh \
+    $$PWD/src/cpprofiler/replay_thread.hh \
+    $$PWD/src/cpprofiler/execution_export.hh \
+    $$PWD/src/cpprofiler/headless_conductor.hh \
+    $$PWD/src/cpprofiler/solver_listener.hh \
     $$PWD/src/cpprofiler/receiver_thread.hh \
     $$PWD/src/cpprofiler/receiver_worker.hh \
     $$PWD/src/cpprofiler/execution.hh \
@@ -74,6 +97,8 @@ HEADERS += \
     $$PWD/src/cpprofiler/utils/tree_utils.hh \
     $$PWD/src/cpprofiler/utils/perf_helper.hh \
     $$PWD/src/cpprofiler/utils/array.hh \
+    $$PWD/src/cpprofiler/utils/chunked_vector.hh \
+    $$PWD/src/cpprofiler/utils/atomic_value.hh \
     $$PWD/src/cpprofiler/utils/debug.hh \
     $$PWD/src/cpprofiler/utils/std_ext.hh \
     $$PWD/src/cpprofiler/utils/maybe_caller.hh \
@@ -81,8 +106,12 @@ HEADERS += \
     $$PWD/src/cpprofiler/tree/structure.hh \
     $$PWD/src/cpprofiler/tree/layout.hh \
     $$PWD/src/cpprofiler/tree/layout_computer.hh \
+    $$PWD/src/cpprofiler/tree/layout_worker.hh \
     $$PWD/src/cpprofiler/tree/shape.hh \
+    $$PWD/src/cpprofiler/tree/shape_pool.hh \
+    $$PWD/src/cpprofiler/tree/extent_kernels.hh \
     $$PWD/src/cpprofiler/tree/node_tree.hh \
+    $$PWD/src/cpprofiler/tree/label_pool.hh \
     $$PWD/src/cpprofiler/tree/node_id.hh \
     $$PWD/src/cpprofiler/tree/node_info.hh \
     $$PWD/src/cpprofiler/tree/node_stats.hh \
@@ -95,6 +124,7 @@ HEADERS += \
     $$PWD/src/cpprofiler/tree/tree_scroll_area.hh \
     $$PWD/src/cpprofiler/tree/subtree_view.hh \
     $$PWD/src/cpprofiler/tree/cursors/node_cursor.hh \
+    $$PWD/src/cpprofiler/tree/cursors/contour_layout_cursor.hh \
     $$PWD/src/cpprofiler/tree/cursors/drawing_cursor.hh \
     $$PWD/src/cpprofiler/tree/cursors/layout_cursor.hh \
     $$PWD/src/cpprofiler/tree/cursors/hide_failed_cursor.hh \
@@ -103,6 +133,11 @@ HEADERS += \
     $$PWD/src/cpprofiler/core.hh \
     $$PWD/src/cpprofiler/solver_id.hh \
     $$PWD/src/cpprofiler/utils/debug_mutex.hh \
+    $$PWD/src/cpprofiler/utils/byte_arena.hh \
+    $$PWD/src/cpprofiler/utils/json_scanner.hh \
+    $$PWD/src/cpprofiler/utils/byte_ring.hh \
+    $$PWD/src/cpprofiler/utils/task_pool.hh \
+    $$PWD/src/cpprofiler/utils/spsc_queue.hh \
     $$PWD/src/cpprofiler/analysis/similar_subtree_analysis.hh \
     $$PWD/src/cpprofiler/analysis/similar_subtree_window.hh \
     $$PWD/src/cpprofiler/analysis/merge_window.hh \
@@ -119,13 +154,17 @@ HEADERS += \
     $$PWD/src/cpprofiler/tree/node_drawing.hh \
     $$PWD/src/cpprofiler/db_handler.hh \
     $$PWD/src/cpprofiler/solver_data.hh \
+    $$PWD/src/cpprofiler/id_map.hh \
     $$PWD/src/cpprofiler/nogood_dialog.hh \
     $$PWD/src/cpprofiler/analysis/nogood_analysis_dialog.hh \
 
 SOURCES += \
     $$PWD/src/cpprofiler/tests/tree_test.cpp \
     $$PWD/src/cpprofiler/tests/execution_test.cpp \
+    $$PWD/src/cpprofiler/tests/headless_test.cpp \
 
 HEADERS += \
     $$PWD/src/cpprofiler/tests/tree_test.hh \
+    $$PWD/src/cpprofiler/tests/check.hh \
     $$PWD/src/cpprofiler/tests/execution_test.hh \
+    $$PWD/src/cpprofiler/tests/headless_test.hh \
@@ -1,6 +1,7 @@
 #include "merge_window.hh"
 
 #include "../tree/traditional_view.hh"
+#include "../tree/layout.hh"
 #include "merging/pentagon_list_widget.hh"
 #include "pentagon_counter.hpp"
 #include "../user_data.hh"
@@ -31,7 +32,7 @@ MergeWindow::MergeWindow(Execution &ex_l, Execution &ex_r, std::shared_ptr<tree:
 
     user_data_.reset(new UserData);
     solver_data_.reset(new SolverData);
-    view_.reset(new tree::TraditionalView(*nt_, *user_data_, *solver_data_));
+    view_.reset(new tree::TraditionalView(*nt_, *user_data_, *solver_data_, tree::LayoutMode::Shapes));
 
     view_->setScale(50);
 
@@ -395,7 +396,7 @@ void MergeWindow::runNogoodAnalysis() const
     for (auto item : res_builder.result())
     {
         const NogoodID id = item.first;
-        const auto &ng_str = ng_tree.getNogood(id);
+        const auto ng_str = ng_tree.getNogood(id);
         const auto *reasons_ptr = ng_tree.solver_data().getContribConstraints(id);
 
         std::vector<int> reasons = reasons_ptr ? *reasons_ptr : std::vector<int>{};
@@ -1,13 +1,17 @@
 #include "similar_subtree_analysis.hh"
 #include "../tree/node_tree.hh"
+#include "../tree/node_info.hh"
 #include "../tree/layout.hh"
 #include "../utils/tree_utils.hh"
 #include "../utils/perf_helper.hh"
 #include "../tree/shape.hh"
+#include "../tree/extent_kernels.hh"
 #include "../tree/visual_flags.hh"
 #include "../tree/layout_computer.hh"
 
+#include <numeric>
 #include <set>
+#include <unordered_map>
 
 namespace cpprofiler
 {
@@ -41,18 +45,16 @@ struct CompareShapes
         if (s1.height() > s2.height())
             return false;
 
-        for (int i = 0; i < s1.height(); ++i)
-        {
-            if (s1[i].l < s2[i].l)
-                return false;
-            if (s1[i].l > s2[i].l)
-                return true;
-            if (s1[i].r < s2[i].r)
-                return true;
-            if (s1[i].r > s2[i].r)
-                return false;
-        }
-        return false;
+        /// only the first depth at which the shapes differ matters
+        const auto i = tree::extent_kernels::first_mismatch(s1.lefts(), s1.rights(),
+                                                            s2.lefts(), s2.rights(), s1.height());
+        if (i == s1.height())
+            return false;
+
+        if (s1[i].l != s2[i].l)
+            return s1[i].l > s2[i].l;
+
+        return s1[i].r < s2[i].r;
     }
 };
 
@@ -159,40 +161,15 @@ static Partition initialPartition(const NodeTree &nt)
 {
     /// separate leaf nodes from internal
     /// NOTE: this assumes that branch nodes have at least one child!
-    Group failed_nodes;
-    Group solution_nodes;
-    Group branch_nodes;
-    {
-        auto nodes = utils::any_order(nt);
+    /// Note: other nodes are ignored for now
+    const auto &info = nt.node_info();
 
-        for (auto nid : nodes)
-        {
-            auto status = nt.getStatus(nid);
-            switch (status)
-            {
-            case NodeStatus::FAILED:
-            {
-                failed_nodes.push_back(nid);
-            }
-            break;
-            case NodeStatus::SOLVED:
-            {
-                solution_nodes.push_back(nid);
-            }
-            break;
-            case NodeStatus::BRANCH:
-            {
-                branch_nodes.push_back(nid);
-            }
-            break;
-            default:
-            {
-                /// ignore other nodes for now
-            }
-            break;
-            }
-        }
-    }
+    /// the bulk scan reads entries as plain bytes
+    utils::MutexLocker tree_lock(&nt.treeMutex(), "analysis: partition");
+
+    Group failed_nodes = info.nodesWithStatus(NodeStatus::FAILED);
+    Group solution_nodes = info.nodesWithStatus(NodeStatus::SOLVED);
+    Group branch_nodes = info.nodesWithStatus(NodeStatus::BRANCH);
 
     Partition result{{}, {}};
 
@@ -298,40 +275,85 @@ vector<SubtreePattern> runIdenticalSubtrees(const NodeTree &nt)
 
 /// SIMILAR SHAPE ANALYSIS
 
+/// Equal shapes are interned by the layout, so nodes are grouped by their
+/// shape objects first and only the distinct shapes need to be sorted
 std::vector<SubtreePattern> runSimilarShapes(const NodeTree &tree, const Layout &lo)
 {
 
-    std::multiset<ShapeInfo, CompareShapes> shape_set;
-
     auto node_order = utils::any_order(tree);
 
-    for (const auto nid : node_order)
+    std::unordered_map<const Shape *, int> shape_index;
+    std::vector<ShapeInfo> distinct;
+    /// positions (in `node_order`) of the nodes with each distinct shape
+    std::vector<std::vector<int>> positions;
+
+    for (auto pos = 0; pos < static_cast<int>(node_order.size()); ++pos)
     {
-        shape_set.insert({nid, *lo.getShape(nid)});
+        const auto nid = node_order[pos];
+        const auto shape = lo.getShape(nid);
+
+        const auto it = shape_index.find(shape);
+        if (it == shape_index.end())
+        {
+            shape_index.insert({shape, static_cast<int>(distinct.size())});
+            distinct.push_back({nid, *shape});
+            positions.push_back({pos});
+        }
+        else
+        {
+            positions[it->second].push_back(pos);
+        }
     }
 
+    std::vector<int> sorted(distinct.size());
+    std::iota(sorted.begin(), sorted.end(), 0);
+
+    const CompareShapes less;
+    std::stable_sort(sorted.begin(), sorted.end(), [&](int i1, int i2) {
+        return less(distinct[i1], distinct[i2]);
+    });
+
     auto sizes = utils::calc_subtree_sizes(tree);
 
     std::vector<SubtreePattern> shapes;
 
-    auto it = shape_set.begin();
-    auto end = shape_set.end();
+    auto it = sorted.begin();
+    auto end = sorted.end();
 
     while (it != end)
     {
-        auto upper = shape_set.upper_bound(*it);
+        /// shapes with the same extents (but different bounding boxes)
+        /// are interned separately and belong to the same pattern
+        auto upper = it + 1;
+        while (upper != end && !less(distinct[*it], distinct[*upper]))
+        {
+            ++upper;
+        }
 
-        const int height = it->shape.height();
+        std::vector<int> group = std::move(positions[*it]);
+
+        if (upper - it > 1)
+        {
+            for (auto other = it + 1; other != upper; ++other)
+            {
+                group.insert(group.end(), positions[*other].begin(), positions[*other].end());
+            }
+            std::sort(group.begin(), group.end());
+        }
+
+        const int height = distinct[*it].shape.height();
 
         SubtreePattern pattern(height);
-        for (; it != upper; ++it)
+        for (const auto pos : group)
         {
-            pattern.m_nodes.emplace_back(it->nid);
+            pattern.m_nodes.emplace_back(node_order[pos]);
         }
 
         pattern.setSize(sizes.at(pattern.first()));
 
         shapes.push_back(std::move(pattern));
+
+        it = upper;
     }
 
     return shapes;
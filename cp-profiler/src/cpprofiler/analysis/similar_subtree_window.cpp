@@ -354,6 +354,8 @@ void SimilarSubtreeWindow::analyse()
 {
 
     /// TODO: make sure building is finished
+    /// (until then, only consider the nodes published so far)
+    tree::SnapshotPin pin(tree_);
 
     result_.reset(new ss_analysis::Result);
 
@@ -453,8 +455,8 @@ static std::vector<Label> labelPath(NodeID nid, const tree::NodeTree &tree)
     std::vector<Label> label_path;
     while (nid != NodeID::NoNode)
     {
-        auto label = tree.getLabel(nid);
-        if (label != emptyLabel)
+        const auto &label = tree.getLabel(nid);
+        if (!label.empty())
         {
             label_path.push_back(label);
         }
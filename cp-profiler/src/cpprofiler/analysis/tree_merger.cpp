@@ -1,6 +1,7 @@
 #include "tree_merger.hh"
 #include "../execution.hh"
 #include "../tree/structure.hh"
+#include "../tree/label_pool.hh"
 #include "../core.hh"
 
 #include "../utils/utils.hh"
@@ -19,13 +20,15 @@ TreeMerger::TreeMerger(const Execution &ex_l_,
                        const Execution &ex_r_,
                        std::shared_ptr<tree::NodeTree> tree,
                        std::shared_ptr<analysis::MergeResult> res,
-                       std::shared_ptr<std::vector<OriginalLoc>> orig_locs)
+                       std::shared_ptr<std::vector<OriginalLoc>> orig_locs,
+                       bool with_labels)
     : ex_l(ex_l_), ex_r(ex_r_),
       tree_l(ex_l.tree()),
       tree_r(ex_r.tree()),
       res_tree(tree),
       merge_result(res),
-      orig_locs_(orig_locs)
+      orig_locs_(orig_locs),
+      with_labels_(with_labels)
 {
 
     connect(this, &QThread::finished, this, &QObject::deleteLater);
@@ -45,7 +48,8 @@ static void find_and_replace_all(std::string &str, std::string substr_old, std::
     }
 }
 
-static bool labelsEqual(std::string lhs, std::string rhs)
+/// The form in which labels from different solvers are compared
+static std::string normalised(std::string label)
 {
     /// NOTE(maxim): removes whitespaces before comparing;
     /// this will be necessary as long as Chuffed and Gecode don't agree
@@ -53,35 +57,62 @@ static bool labelsEqual(std::string lhs, std::string rhs)
     /// for parsing logbrancher while Chuffed uses them as a delimiter
     /// between literals)
 
-    if (lhs.substr(0, 3) == "[i]" || lhs.substr(0, 3) == "[f]")
+    if (label.substr(0, 3) == "[i]" || label.substr(0, 3) == "[f]")
     {
-        lhs = lhs.substr(3);
+        label = label.substr(3);
     }
 
-    if (rhs.substr(0, 3) == "[i]" || rhs.substr(0, 3) == "[f]")
-    {
-        rhs = rhs.substr(3);
-    }
+    label.erase(remove_if(label.begin(), label.end(), isspace), label.end());
 
-    lhs.erase(remove_if(lhs.begin(), lhs.end(), isspace), lhs.end());
-    rhs.erase(remove_if(rhs.begin(), rhs.end(), isspace), rhs.end());
+    find_and_replace_all(label, "==", "=");
 
-    find_and_replace_all(lhs, "==", "=");
-    find_and_replace_all(rhs, "==", "=");
+    return label;
+}
 
-    // qDebug() << "comparing: " << lhs.c_str() << " " << rhs.c_str();
+/// Labels of the two trees interned (in normalised form) into one pool:
+/// every distinct label of either tree is normalised once, after which
+/// comparing the labels of two nodes is an integer compare
+class LabelMatcher
+{
+    const NodeTree &nt_l_;
+    const NodeTree &nt_r_;
 
-    if (lhs.compare(rhs) != 0)
+    LabelPool common_;
+
+    /// Identifier in `common_` of every label id of either tree (-1 if not seen yet)
+    std::vector<LabelID> ids_l_;
+    std::vector<LabelID> ids_r_;
+
+    LabelID commonId(const NodeTree &nt, std::vector<LabelID> &ids, NodeID nid)
     {
-        return false;
+        const auto id = nt.getLabelId(nid);
+
+        if (id >= static_cast<LabelID>(ids.size()))
+        {
+            ids.resize(nt.labelPool().size(), -1);
+        }
+
+        if (ids[id] == -1)
+        {
+            ids[id] = common_.intern(normalised(nt.getLabel(nid)));
+        }
+
+        return ids[id];
     }
 
-    return true;
-}
+  public:
+    LabelMatcher(const NodeTree &nt_l, const NodeTree &nt_r) : nt_l_(nt_l), nt_r_(nt_r) {}
 
+    bool equal(NodeID n_l, NodeID n_r)
+    {
+        return commonId(nt_l_, ids_l_, n_l) == commonId(nt_r_, ids_r_, n_r);
+    }
+};
+
+/// Whether nodes `n1` and `n2` match (`labels` is null if labels are not compared)
 static bool compareNodes(NodeID n1, const NodeTree &nt1,
                          NodeID n2, const NodeTree &nt2,
-                         bool with_labels)
+                         LabelMatcher *labels)
 {
 
     if (n1 == NodeID::NoNode || n2 == NodeID::NoNode)
@@ -90,13 +121,8 @@ static bool compareNodes(NodeID n1, const NodeTree &nt1,
     if (nt1.getStatus(n1) != nt2.getStatus(n2))
         return false;
 
-    if (with_labels)
-    {
-        const auto &label1 = nt1.getLabel(n1);
-        const auto &label2 = nt2.getLabel(n2);
-        if (!labelsEqual(label1, label2))
-            return false;
-    }
+    if (labels && !labels->equal(n1, n2))
+        return false;
 
     return true;
 }
@@ -118,8 +144,7 @@ static void copy_tree_into(NodeTree &nt, NodeID nid, const NodeTree &nt_s, NodeI
         auto kids = nt_s.childrenCount(node_s);
         auto status = nt_s.getStatus(node_s);
 
-        /// TODO: make sure only the reference to a label is stored
-        auto label = nt_s.getLabel(node_s);
+        const auto &label = nt_s.getLabel(node_s);
 
         nt.promoteNode(node, kids, status, label);
 
@@ -158,10 +183,10 @@ void TreeMerger::run()
 
     print("Merging: running...");
 
-    /// It is quite unlikely, but this can dead-lock (needs consistent ordering)
-    utils::MutexLocker locker_l(&tree_l.treeMutex());
-    utils::MutexLocker locker_r(&tree_r.treeMutex());
-    utils::MutexLocker locker_res(&res_tree->treeMutex());
+    /// the source trees are only read (and may still be growing)
+    tree::SnapshotPin pin_l(tree_l);
+    tree::SnapshotPin pin_r(tree_r);
+    utils::MutexLocker locker_res(&res_tree->treeMutex(), "merger");
 
     QStack<NodeID> stack_l, stack_r, stack;
 
@@ -175,6 +200,13 @@ void TreeMerger::run()
 
     stack.push(root);
 
+    std::unique_ptr<LabelMatcher> labels;
+
+    if (with_labels_)
+    {
+        labels.reset(new LabelMatcher(tree_l, tree_r));
+    }
+
     while (stack_l.size() > 0)
     {
 
@@ -182,7 +214,7 @@ void TreeMerger::run()
         auto node_r = stack_r.pop();
         auto target = stack.pop();
 
-        bool equal = compareNodes(node_l, tree_l, node_r, tree_r, false);
+        bool equal = compareNodes(node_l, tree_l, node_r, tree_r, labels.get());
 
         if (equal)
         {
@@ -195,7 +227,7 @@ void TreeMerger::run()
 
             { /// The merged tree will always have the number of children of the 'larger' tree
                 auto status = tree_l.getStatus(node_l);
-                auto label = tree_l.getLabel(node_l);
+                const auto &label = tree_l.getLabel(node_l);
                 res_tree->promoteNode(target, max_kids, status, label);
             }
 
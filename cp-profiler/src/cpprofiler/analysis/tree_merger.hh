@@ -37,6 +37,9 @@ class TreeMerger : public QThread
 
   std::shared_ptr<std::vector<OriginalLoc>> orig_locs_;
 
+  /// Whether matching nodes must also have matching labels
+  const bool with_labels_;
+
 protected:
   void
   run() override;
@@ -46,7 +49,8 @@ public:
              const Execution &ex_r,
              std::shared_ptr<tree::NodeTree> tree,
              std::shared_ptr<analysis::MergeResult> res,
-             std::shared_ptr<std::vector<OriginalLoc>> orig_locs);
+             std::shared_ptr<std::vector<OriginalLoc>> orig_locs,
+             bool with_labels = false);
   ~TreeMerger();
 };
 
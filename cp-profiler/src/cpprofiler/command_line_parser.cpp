@@ -12,6 +12,12 @@ QCommandLineOption save_search{"save_search", "Process one execution and save it
 QCommandLineOption save_execution{"save_execution", "Process one execution and save it a database named <file_name>; terminate afterwards.", "file_name"};
 QCommandLineOption save_pixel_tree{"save_pixel_tree", "Process one execution and save it a database named <file_name>; terminate afterwards.", "file_name"};
 QCommandLineOption pixel_tree_compression{"pixel_tree_compression", "What compression factor to use for saved pixel tree. Default: 2", "2"};
+QCommandLineOption capture{"capture", "Record messages received from solvers (with their arrival times) to <file_name>.", "file_name"};
+QCommandLineOption replay{"replay", "Replay messages recorded with --capture from <file_name> at the recorded speed.", "file_name"};
+QCommandLineOption replay_fast{"replay_fast", "Replay messages as fast as possible."};
+QCommandLineOption headless{"headless", "Run without windows: process one execution, save the requested outputs and terminate."};
+QCommandLineOption contour_layout{"contour_layout", "Lay out trees using threaded contours instead of per-node shapes (less memory for deep trees)."};
+QCommandLineOption run_tests{"run_tests", "Run the built-in tests and terminate (aborting on the first failed check)."};
 } // namespace cl_options
 
 CommandLineParser::CommandLineParser()
@@ -24,6 +30,12 @@ CommandLineParser::CommandLineParser()
     cl_parser.addOption(cl_options::save_execution);
     cl_parser.addOption(cl_options::save_pixel_tree);
     cl_parser.addOption(cl_options::pixel_tree_compression);
+    cl_parser.addOption(cl_options::capture);
+    cl_parser.addOption(cl_options::replay);
+    cl_parser.addOption(cl_options::replay_fast);
+    cl_parser.addOption(cl_options::headless);
+    cl_parser.addOption(cl_options::contour_layout);
+    cl_parser.addOption(cl_options::run_tests);
 }
 
 void CommandLineParser::process(const QCoreApplication &app)
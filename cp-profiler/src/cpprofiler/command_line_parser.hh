@@ -14,6 +14,12 @@ extern QCommandLineOption save_search;
 extern QCommandLineOption save_execution;
 extern QCommandLineOption save_pixel_tree;
 extern QCommandLineOption pixel_tree_compression;
+extern QCommandLineOption capture;
+extern QCommandLineOption replay;
+extern QCommandLineOption replay_fast;
+extern QCommandLineOption headless;
+extern QCommandLineOption contour_layout;
+extern QCommandLineOption run_tests;
 } // namespace cl_options
 
 class CommandLineParser
@@ -1,6 +1,5 @@
 #include "conductor.hh"
-#include "tcp_server.hh"
-#include "receiver_thread.hh"
+#include "solver_listener.hh"
 #include <iostream>
 #include <thread>
 #include <QTreeView>
@@ -12,6 +11,7 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QApplication>
+#include <QTimer>
 #include "../cpp-integration/message.hpp"
 
 #include "execution.hh"
@@ -20,6 +20,7 @@
 #include "execution_window.hh"
 
 #include "tree/node_tree.hh"
+#include "tree/layout.hh"
 
 #include "analysis/merge_window.hh"
 #include "analysis/tree_merger.hh"
@@ -37,6 +38,7 @@
 
 #include "name_map.hh"
 #include "db_handler.hh"
+#include "execution_export.hh"
 
 namespace cpprofiler
 {
@@ -48,6 +50,9 @@ Conductor::Conductor(Options opt, QWidget* parent) : QMainWindow(parent), option
 
     // readSettings();
 
+    settings_.capture_path = options_.capture_path;
+    settings_.contour_layout = options_.contour_layout;
+
     auto layout = new QGridLayout();
 
     {
@@ -59,6 +64,12 @@ Conductor::Conductor(Options opt, QWidget* parent) : QMainWindow(parent), option
     execution_list_.reset(new ExecutionList);
     layout->addWidget(execution_list_->getWidget());
 
+    auto ingestStatsTimer = new QTimer(this);
+    connect(ingestStatsTimer, &QTimer::timeout, [this]() {
+        execution_list_->updateIngestStats();
+    });
+    ingestStatsTimer->start(INGEST_STATS_INTERVAL);
+
     auto showButton = new QPushButton("Show Tree");
     layout->addWidget(showButton);
     connect(showButton, &QPushButton::clicked, [this]() {
@@ -120,41 +131,41 @@ Conductor::Conductor(Options opt, QWidget* parent) : QMainWindow(parent), option
         }
     });
 
-    server_.reset(new TcpServer([this](intptr_t socketDesc) {
-        {
-            /// Initiate a receiver thread
-            auto receiver = new ReceiverThread(socketDesc, settings_);
-            /// Delete the receiver one the thread is finished
-            connect(receiver, &QThread::finished, receiver, &QObject::deleteLater);
-            /// Handle the start message in this connector
-            connect(receiver, &ReceiverThread::notifyStart, [this, receiver](const std::string &ex_name, int ex_id, bool restarts) {
-                handleStart(receiver, ex_name, ex_id, restarts);
-            });
+    auto lockStatsButton = new QPushButton("Lock Statistics");
+    layout->addWidget(lockStatsButton);
 
-            receiver->start();
-        }
-    }));
+    connect(lockStatsButton, &QPushButton::clicked, [this]() {
+        utils::lock_stats::dump();
 
-    listen_port_ = DEFAULT_PORT;
+        const auto fileName = QFileDialog::getSaveFileName(this, "Save Lock Statistics (JSON)").toStdString();
 
-    // See if the default port is available
-    auto res = server_->listen(QHostAddress::Any, listen_port_);
-    if (!res)
-    {
-        // If not, try any port
-        server_->listen(QHostAddress::Any, 0);
-        listen_port_ = server_->serverPort();
-    }
+        if (fileName == "")
+            return;
+
+        saveLockStats(fileName.c_str());
+    });
+
+    listener_.reset(new SolverListener(settings_, [this](ReceiverThread *receiver, const std::string &ex_name, int ex_id, bool restarts) {
+        handleStart(receiver, ex_name, ex_id, restarts);
+    }));
 
     QString listen_message;
     QTextStream ts(&listen_message);
     ts << "Listening on port "
-       << QString::number(listen_port_)
+       << QString::number(listener_->listenPort())
        << ".";
     auto portLabel = new QLabel(listen_message);
     layout->addWidget(portLabel);
 
-    std::cerr << "Ready to listen on: " << listen_port_ << std::endl;
+    if (options_.replay_path != "")
+    {
+        replayCapture(options_.replay_path, !options_.replay_fast);
+    }
+}
+
+void Conductor::replayCapture(const std::string &path, bool realtime)
+{
+    listener_->replayCapture(path, realtime);
 }
 
 static int getRandomExID()
@@ -214,7 +225,12 @@ void Conductor::setMetaData(int exec_id, const std::string &group_name,
 
 int Conductor::getListenPort() const
 {
-    return static_cast<int>(listen_port_);
+    return static_cast<int>(listener_->listenPort());
+}
+
+QString Conductor::getLocalServerName() const
+{
+    return listener_->localServerName();
 }
 
 Conductor::~Conductor() = default;
@@ -224,6 +240,8 @@ void Conductor::handleStart(ReceiverThread *receiver, const std::string &ex_name
 
     auto res = executions_.find(ex_id);
 
+    Execution *ex = nullptr;
+
     if (res == executions_.end() || ex_id == 0)
     {
 
@@ -239,7 +257,7 @@ void Conductor::handleStart(ReceiverThread *receiver, const std::string &ex_name
         }
 
         /// needs a new execution
-        auto ex = addNewExecution(ex_name_used, ex_id, restarts);
+        ex = addNewExecution(ex_name_used, ex_id, restarts);
         emit executionStart(ex);
 
         /// construct a name map
@@ -259,32 +277,21 @@ void Conductor::handleStart(ReceiverThread *receiver, const std::string &ex_name
         }
 
         /// The builder should only be created for a new execution
-        auto builderThread = new QThread();
-        auto builder = new TreeBuilder(*ex);
-
-        builders_[ex_id] = builder;
-        builder->moveToThread(builderThread);
+        auto builder = listener_->startBuilder(*ex, ex_id);
 
 	// onExecutionDone must be called on the same thread as the conductor
         connect(builder, &TreeBuilder::buildingDone, this, [this, ex]() {
             onExecutionDone(ex);
         });
-
-        /// is this the right time to delete the builder thread?
-        connect(builderThread, &QThread::finished, builderThread, &QObject::deleteLater);
-
-        builderThread->start();
+    }
+    else
+    {
+        ex = res->second.get();
     }
 
-    /// obtain the builder aready assigned to this execution
-    ///(either just now or by another connection)
-    auto builder = builders_[ex_id];
-
-    connect(receiver, &ReceiverThread::newNode,
-            builder, &TreeBuilder::handleNode);
-
-    connect(receiver, &ReceiverThread::doneReceiving,
-            builder, &TreeBuilder::finishBuilding);
+    /// feed the receiver to the builder already assigned to this execution
+    /// (either just now or by another connection)
+    listener_->attachReceiver(receiver, *ex, ex_id);
 }
 
 int Conductor::addNewExecution(std::shared_ptr<Execution> ex)
@@ -339,7 +346,8 @@ ExecutionWindow &Conductor::getExecutionWindow(Execution *e)
     /// create new one if doesn't already exist
     if (maybe_view == execution_windows_.end())
     {
-        execution_windows_[e] = new ExecutionWindow(*e, this);
+        const auto mode = settings_.contour_layout ? tree::LayoutMode::Contours : tree::LayoutMode::Shapes;
+        execution_windows_[e] = new ExecutionWindow(*e, mode, this);
 
         const auto ex_window = execution_windows_[e];
 
@@ -403,88 +411,34 @@ void Conductor::runNogoodAnalysis(Execution *e1, Execution *e2)
     merger->start();
 }
 
-void Conductor::savePixelTree(Execution *e, const char* path, int compression_factor) const {
-  const auto &nt = e->tree();
-  pixel_view::PtCanvas pc(nt);
-  auto pi = pc.get_pimage();
-  pc.setCompression(compression_factor);
-  int width  = pi->pixel_size()*pc.totalSlices();
-  int height = pi->pixel_size()*nt.node_stats().maxDepth();
-  pi->resize({width,height});
-  pc.redrawAll(true);
-  pi->raw_image().save(path);
+void Conductor::savePixelTree(Execution *e, const char *path, int compression_factor) const
+{
+    execution_export::save_pixel_tree(e, path, compression_factor);
 }
 
 void Conductor::saveSearch(Execution *e, const char *path) const
 {
+    execution_export::save_search(e, path);
+}
 
-    const auto &nt = e->tree();
+void Conductor::saveSearch(Execution *e) const
+{
 
-    const auto order = utils::pre_order(nt);
+    const auto file_path = QFileDialog::getSaveFileName(nullptr, "Save Search To a File").toStdString();
 
+    saveSearch(e, file_path.c_str());
+}
+
+void Conductor::saveLockStats(const char *path) const
+{
     QFile file(path);
     if (!file.open(QFile::WriteOnly | QFile::Truncate))
     {
-        print("Error: could not open \"{}\" to save search", path);
+        print("Error: could not open \"{}\" to save lock statistics", path);
         return;
     }
 
-    QTextStream file_stream(&file);
-
-    for (auto nid : order)
-    {
-
-        /// Making sure undefined/skipped nodes are not logged
-        {
-            const auto status = nt.getStatus(nid);
-            if (status == tree::NodeStatus::SKIPPED || status == tree::NodeStatus::UNDETERMINED)
-                continue;
-        }
-
-        // Note: not every child is logged (SKIPPED and UNDET are not)
-        int kids_logged = 0;
-
-        /// Note: this temporary stream is used so that children can be
-        /// traversed first, counted, but logged after their parent
-        std::stringstream children_stream;
-
-        const auto kids = nt.childrenCount(nid);
-
-        for (auto alt = 0; alt < kids; alt++)
-        {
-
-            const auto kid = nt.getChild(nid, alt);
-
-            /// Making sure undefined/skipped children are not logged
-            const auto status = nt.getStatus(kid);
-            if (status == tree::NodeStatus::SKIPPED || status == tree::NodeStatus::UNDETERMINED)
-                continue;
-
-            ++kids_logged;
-            /// TODO: use original names in labels
-            const auto label = nt.getLabel(kid);
-
-            children_stream << " " << kid << " " << label;
-        }
-
-        file_stream << nid << " " << kids_logged;
-
-        /// Unexplored node on the left branch (search timed out)
-        if ((kids == 0) && (nt.getStatus(nid) == tree::NodeStatus::BRANCH))
-        {
-            file_stream << " stop";
-        }
-
-        file_stream << children_stream.str().c_str() << '\n';
-    }
-}
-
-void Conductor::saveSearch(Execution *e) const
-{
-
-    const auto file_path = QFileDialog::getSaveFileName(nullptr, "Save Search To a File").toStdString();
-
-    saveSearch(e, file_path.c_str());
+    file.write(utils::lock_stats::toJson().c_str());
 }
 
 void Conductor::saveExecution(Execution *e)
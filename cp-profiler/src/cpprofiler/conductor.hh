@@ -19,12 +19,11 @@ namespace analysis
 class MergeWindow;
 }
 
-class TcpServer;
 class Execution;
 class ExecutionList;
 class ExecutionWindow;
 class ReceiverThread;
-class TreeBuilder;
+class SolverListener;
 class NameMap;
 
 struct ExecMeta
@@ -61,12 +60,23 @@ class Conductor : public QMainWindow
     void saveSearch(Execution *e, const char *path) const;
     void saveSearch(Execution *e) const;
 
+    /// Save lock contention statistics (per call site) as JSON
+    void saveLockStats(const char *path) const;
+
     void runNogoodAnalysis(Execution *e1, Execution *e2);
 
     ExecutionWindow &getExecutionWindow(Execution *e);
 
     int getListenPort() const;
 
+    /// Feed messages recorded in a capture file through the local server
+    /// (either at the recorded speed or as fast as possible)
+    void replayCapture(const std::string &path, bool realtime);
+
+    /// Name that solvers on this machine can connect to instead of the
+    /// TCP port (empty if the local server could not be started)
+    QString getLocalServerName() const;
+
     int getNextExecId() const;
 
     void setMetaData(int exec_id, const std::string &group_name,
@@ -94,22 +104,19 @@ class Conductor : public QMainWindow
 
     // void getSelectedExecutions
 
-    static constexpr quint16 DEFAULT_PORT = 6565;
+    /// How often (in ms) ingest statistics of executions are refreshed
+    static constexpr int INGEST_STATS_INTERVAL = 1000;
 
     Settings settings_;
 
-    /// Port number opened for solvers to connect to
-    quint16 listen_port_;
-
-    std::unique_ptr<TcpServer> server_;
-
     Options options_;
 
     /// a map from execution id to an execution
     std::unordered_map<int, std::shared_ptr<Execution>> executions_;
 
-    /// a map from exec_id to its builder
-    std::unordered_map<int, TreeBuilder *> builders_;
+    /// Receives from solvers into the executions' builders
+    /// (destroyed before the executions the builders refer to)
+    std::unique_ptr<SolverListener> listener_;
 
     std::unique_ptr<ExecutionList> execution_list_;
 
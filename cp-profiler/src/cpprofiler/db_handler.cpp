@@ -5,6 +5,7 @@
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include "execution.hh"
+#include "tree/structure.hh"
 #include "utils/tree_utils.hh"
 #include "utils/perf_helper.hh"
 
@@ -22,7 +23,14 @@ struct NodeData
     int alt;
     int kids;
     tree::NodeStatus status;
-    std::string label;
+    /// points into the tree's label storage (not owned)
+    const Label *label;
+};
+
+struct SolverIdItem
+{
+    NodeID nid;
+    SolverID sid;
 };
 
 struct BookmarkItem
@@ -56,7 +64,9 @@ static int count_nodes(QSqlDatabase *db)
 /// Reads all nodes from a database and builds the tree; returns `true` on success
 static bool read_nodes(QSqlDatabase *db, Execution &ex)
 {
-    const auto query = "select * from Nodes;";
+    /// nodes are added in the order of their ids (parents before children,
+    /// siblings in the order of their alternatives)
+    const auto query = "select * from Nodes ORDER BY NodeID;";
 
     QSqlQuery select_stmt (*db);
     select_stmt.prepare(query);
@@ -66,29 +76,64 @@ static bool read_nodes(QSqlDatabase *db, Execution &ex)
     const auto total_nodes = count_nodes(db);
     print("We have {} nodes", total_nodes);
 
-    tree.db_initialize(total_nodes);
-
     bool success = select_stmt.exec();
 
     if(!success) return false;
 
-    while (select_stmt.next())
+    /// the tree is published (and views notified) once all nodes are read
+    try
     {
-        const auto nid = NodeID(select_stmt.value(0).toInt());
-        const auto pid = NodeID(select_stmt.value(1).toInt());
-        const auto alt = select_stmt.value(2).toInt();
-        const auto kids = select_stmt.value(3).toInt();
-        const auto status = tree::NodeStatus(select_stmt.value(4).toInt());
-        const auto label = select_stmt.value(5).toString().toStdString();
-
-        if (pid == NodeID::NoNode)
-        {
-            tree.db_createRoot(nid, label);
-        }
-        else
-        {
-            tree.db_addChild(nid, pid, alt, status, label);
-        }
+        tree.applyBatch([&]() {
+            while (select_stmt.next())
+            {
+                const auto nid = NodeID(select_stmt.value(0).toInt());
+                const auto pid = NodeID(select_stmt.value(1).toInt());
+                const auto alt = select_stmt.value(2).toInt();
+                const auto kids = select_stmt.value(3).toInt();
+                const auto status = tree::NodeStatus(select_stmt.value(4).toInt());
+                const auto label = select_stmt.value(5).toString().toStdString();
+
+                if (pid == NodeID::NoNode)
+                {
+                    tree.db_createRoot(nid, label);
+                }
+                else
+                {
+                    tree.db_addChild(nid, pid, alt, status, label);
+                }
+            }
+        });
+    }
+    catch (const tree::invalid_tree &)
+    {
+        print("ERROR: nodes are not stored parents first");
+        return false;
+    }
+
+    return success;
+}
+
+/// Read the solver ids of all nodes from the database
+static bool read_solver_ids(QSqlDatabase *db, Execution &ex)
+{
+    const auto query = "select * from SolverIds;";
+    QSqlQuery select_sid(*db);
+    select_sid.prepare(query);
+
+    /// files saved by older versions have no solver ids
+    bool success = select_sid.exec();
+    if(!success) return false;
+
+    auto &sd = ex.solver_data();
+
+    while (select_sid.next())
+    {
+        const auto nid = NodeID(select_sid.value(0).toInt());
+        const auto sol_nid = select_sid.value(1).toInt();
+        const auto rid = select_sid.value(2).toInt();
+        const auto tid = select_sid.value(3).toInt();
+
+        sd.setNodeId({sol_nid, rid, tid}, nid);
     }
 
     return success;
@@ -162,7 +207,7 @@ static bool read_nogoods(QSqlDatabase *db, Execution &ex)
     return success;
 }
 
-static void insert_node(QSqlQuery *stmt, NodeData nd)
+static void insert_node(QSqlQuery *stmt, const NodeData &nd)
 {
     stmt->finish();
 
@@ -171,7 +216,7 @@ static void insert_node(QSqlQuery *stmt, NodeData nd)
     stmt->addBindValue(static_cast<int>(nd.alt));
     stmt->addBindValue(static_cast<int>(nd.kids));
     stmt->addBindValue(static_cast<int>(nd.status));
-    stmt->addBindValue(nd.label.c_str());
+    stmt->addBindValue(nd.label->c_str());
 
     if (!stmt->exec())
     {
@@ -201,9 +246,9 @@ static void save_nodes(QSqlDatabase *db, const Execution *ex)
         const auto alt = tree.getAlternative(nid);
         const auto kids = tree.childrenCount(nid);
         const auto status = tree.getStatus(nid);
-        const auto label = tree.getLabel(nid);
+        const auto &label = tree.getLabel(nid);
 
-        insert_node(&insert_bm, {nid, pid, alt, kids, status, label});
+        insert_node(&insert_bm, {nid, pid, alt, kids, status, &label});
 
         if (i % TRANSACTION_SIZE == TRANSACTION_SIZE - 1)
         {
@@ -214,6 +259,49 @@ static void save_nodes(QSqlDatabase *db, const Execution *ex)
     db->commit();
 }
 
+static void insert_solver_id(QSqlQuery *stmt, SolverIdItem si)
+{
+    stmt->finish();
+
+    stmt->addBindValue(static_cast<int>(si.nid));
+    stmt->addBindValue(si.sid.nid);
+    stmt->addBindValue(si.sid.rid);
+    stmt->addBindValue(si.sid.tid);
+
+    if (!stmt->exec())
+    {
+        print("ERROR: could not execute DB statement");
+    }
+}
+
+static void save_solver_ids(QSqlDatabase *db, const Execution *ex)
+{
+    const char *query = "INSERT INTO SolverIds \
+                         (NodeID, SolverNodeID, RestartID, ThreadID) \
+                         VALUES (?,?,?,?);";
+
+    QSqlQuery insert_sid_stmt(*db);
+    insert_sid_stmt.prepare(query);
+
+    const auto &nt = ex->tree();
+    const auto &sd = ex->solver_data();
+
+    const auto nodes = utils::any_order(nt);
+
+    db->transaction();
+    for (const auto n : nodes)
+    {
+        const auto sid = sd.getSolverID(n);
+
+        /// nodes created by the profiler itself (e.g. the restart root) have none
+        if (sid.nid != -1)
+        {
+            insert_solver_id(&insert_sid_stmt, {n, sid});
+        }
+    }
+    db->commit();
+}
+
 static void insert_bookmark(QSqlQuery *stmt, BookmarkItem bi)
 {
     stmt->finish();
@@ -344,6 +432,13 @@ static bool create_db(QSqlDatabase* db)
       Label varchar(256) \
       );";
 
+    const auto create_solver_ids = "CREATE TABLE SolverIds( \
+        NodeID INTEGER PRIMARY KEY, \
+        SolverNodeID int NOT NULL, \
+        RestartID int NOT NULL, \
+        ThreadID int NOT NULL \
+        );";
+
     const auto create_bookmarks = "Create TABLE Bookmarks( \
         NodeID INTEGER PRIMARY KEY, \
         Bookmark varchar(8) \
@@ -362,6 +457,7 @@ static bool create_db(QSqlDatabase* db)
     QSqlQuery query (*db);
 
     if(!query.exec(create_nodes)) return false;
+    if(!query.exec(create_solver_ids)) return false;
     if(!query.exec(create_bookmarks)) return false;
     if(!query.exec(create_nogoods)) return false;
     if(!query.exec(create_info)) return false;
@@ -393,6 +489,8 @@ void save_execution(const Execution *ex, const char *path)
 
     save_nodes(&db, ex);
 
+    save_solver_ids(&db, ex);
+
     save_user_data(&db, ex);
 
     const auto &sd = ex->solver_data();
@@ -422,6 +520,8 @@ std::shared_ptr<Execution> load_execution(const char *path, ExecID eid)
 
     read_nodes(&db, *ex);
 
+    read_solver_ids(&db, *ex);
+
     read_bookmarks(&db, *ex);
 
     read_nogoods(&db, *ex);
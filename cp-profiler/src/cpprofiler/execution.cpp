@@ -23,7 +23,7 @@ Execution::Execution(const std::string &name, ExecID id, bool restarts)
     if (restarts)
     {
         print("restart execution!");
-        tree_->createRoot(0, "root");
+        tree_->createRestartRoot();
     }
 }
 
@@ -5,6 +5,8 @@
 #include "tree/node.hh"
 #include "tree/node_tree.hh"
 #include "user_data.hh"
+#include "utils/atomic_value.hh"
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -13,6 +15,22 @@
 namespace cpprofiler
 {
 
+/// Gauges of how node messages from the solver flow into the tree
+struct IngestStats
+{
+    /// Node messages waiting for the builder, summed over its shards
+    /// (sampled whenever a shard drains its queue)
+    std::atomic<int> queue_depth{0};
+    /// Capacity of the queues between the receiver and the builder's shards
+    std::atomic<int> queue_capacity{0};
+    /// Node messages received from the solver(s)
+    std::atomic<uint64_t> nodes_received{0};
+    /// Whether reading from the solver is paused for the builder to catch up
+    utils::AtomicValue<bool> throttled;
+    /// Total time reading was paused
+    std::atomic<uint64_t> throttled_ms{0};
+};
+
 class Execution
 {
 
@@ -31,6 +49,8 @@ class Execution
     /// Whether the execution contains restarts
     bool m_is_restarts;
 
+    IngestStats ingest_stats_;
+
   public:
     std::string name();
 
@@ -53,6 +73,9 @@ class Execution
 
     const NameMap *nameMap() const { return name_map_.get(); }
 
+    IngestStats &ingestStats() { return ingest_stats_; }
+    const IngestStats &ingestStats() const { return ingest_stats_; }
+
     bool doesRestarts() const;
 };
 
@@ -0,0 +1,96 @@
+#include "execution_export.hh"
+#include "execution.hh"
+
+#include "pixel_views/pt_canvas.hh"
+#include "utils/debug.hh"
+#include "utils/tree_utils.hh"
+
+#include <QFile>
+#include <QImage>
+#include <QTextStream>
+#include <sstream>
+
+namespace cpprofiler
+{
+namespace execution_export
+{
+
+void save_pixel_tree(const Execution *e, const char *path, int compression_factor)
+{
+    const auto &nt = e->tree();
+    pixel_view::PtCanvas pc(nt);
+    auto pi = pc.get_pimage();
+    pc.setCompression(compression_factor);
+    int width = pi->pixel_size() * pc.totalSlices();
+    int height = pi->pixel_size() * nt.node_stats().maxDepth();
+    pi->resize({width, height});
+    pc.redrawAll(true);
+    pi->raw_image().save(path);
+}
+
+void save_search(const Execution *e, const char *path)
+{
+
+    const auto &nt = e->tree();
+
+    const auto order = utils::pre_order(nt);
+
+    QFile file(path);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate))
+    {
+        print("Error: could not open \"{}\" to save search", path);
+        return;
+    }
+
+    QTextStream file_stream(&file);
+
+    for (auto nid : order)
+    {
+
+        /// Making sure undefined/skipped nodes are not logged
+        {
+            const auto status = nt.getStatus(nid);
+            if (status == tree::NodeStatus::SKIPPED || status == tree::NodeStatus::UNDETERMINED)
+                continue;
+        }
+
+        // Note: not every child is logged (SKIPPED and UNDET are not)
+        int kids_logged = 0;
+
+        /// Note: this temporary stream is used so that children can be
+        /// traversed first, counted, but logged after their parent
+        std::stringstream children_stream;
+
+        const auto kids = nt.childrenCount(nid);
+
+        for (auto alt = 0; alt < kids; alt++)
+        {
+
+            const auto kid = nt.getChild(nid, alt);
+
+            /// Making sure undefined/skipped children are not logged
+            const auto status = nt.getStatus(kid);
+            if (status == tree::NodeStatus::SKIPPED || status == tree::NodeStatus::UNDETERMINED)
+                continue;
+
+            ++kids_logged;
+            /// TODO: use original names in labels
+            const auto &label = nt.getLabel(kid);
+
+            children_stream << " " << kid << " " << label;
+        }
+
+        file_stream << nid << " " << kids_logged;
+
+        /// Unexplored node on the left branch (search timed out)
+        if ((kids == 0) && (nt.getStatus(nid) == tree::NodeStatus::BRANCH))
+        {
+            file_stream << " stop";
+        }
+
+        file_stream << children_stream.str().c_str() << '\n';
+    }
+}
+
+} // namespace execution_export
+} // namespace cpprofiler
@@ -0,0 +1,20 @@
+#pragma once
+
+namespace cpprofiler
+{
+
+class Execution;
+
+/// Writing executions to files other than databases (see `db_handler`)
+namespace execution_export
+{
+
+/// Save the search tree of `ex` (one line per node listing its children)
+void save_search(const Execution *ex, const char *path);
+
+/// Render the pixel tree of `ex` to an image file at `path`
+void save_pixel_tree(const Execution *ex, const char *path, int compression_factor = 2);
+
+} // namespace execution_export
+
+} // namespace cpprofiler
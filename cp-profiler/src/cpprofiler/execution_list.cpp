@@ -19,16 +19,52 @@ Execution *ExecutionItem::get_execution()
 namespace cpprofiler
 {
 
-ExecutionList::ExecutionList()
+ExecutionList::ExecutionList() : m_last_update(std::chrono::steady_clock::now())
 {
-    m_tree_view.setHeaderHidden(true);
+    m_execution_tree_model.setHorizontalHeaderLabels({"Execution", "Nodes/s", "Queue", "Throttled"});
     m_tree_view.setModel(&m_execution_tree_model);
+    m_tree_view.setRootIsDecorated(false);
     m_tree_view.setSelectionMode(QAbstractItemView::MultiSelection);
+    m_tree_view.setSelectionBehavior(QAbstractItemView::SelectRows);
 }
 
 void ExecutionList::addExecution(Execution &e)
 {
-    m_execution_tree_model.appendRow(new ExecutionItem{e});
+    IngestRow row{&e, new QStandardItem(), new QStandardItem(), new QStandardItem(), 0};
+
+    QList<QStandardItem *> items{new ExecutionItem{e}, row.rate, row.queue, row.throttled};
+
+    for (auto item : items)
+    {
+        item->setEditable(false);
+    }
+
+    m_execution_tree_model.appendRow(items);
+    m_ingest_rows.push_back(row);
+}
+
+void ExecutionList::updateIngestStats()
+{
+    const auto now = std::chrono::steady_clock::now();
+    const auto seconds = std::chrono::duration<double>(now - m_last_update).count();
+    m_last_update = now;
+
+    for (auto &row : m_ingest_rows)
+    {
+        const auto &stats = row.execution->ingestStats();
+
+        const uint64_t received = stats.nodes_received;
+        const auto rate = seconds > 0 ? (received - row.last_received) / seconds : 0.0;
+        row.last_received = received;
+
+        row.rate->setText(QString::number(static_cast<qint64>(rate)));
+        row.queue->setText(QString("%1/%2").arg(stats.queue_depth.load()).arg(stats.queue_capacity.load()));
+
+        const bool throttled = stats.throttled;
+        const double throttled_s = stats.throttled_ms / 1000.0;
+        row.throttled->setText(QString("%1s%2").arg(throttled_s, 0, 'f', 1).arg(throttled ? " (now)" : ""));
+        row.throttled->setForeground(throttled ? QBrush(Qt::red) : QBrush());
+    }
 }
 
 std::vector<Execution *> ExecutionList::getSelected()
@@ -3,6 +3,8 @@
 
 #include <QStandardItemModel>
 #include <QTreeView>
+#include <chrono>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -26,6 +28,21 @@ class ExecutionList
     QTreeView m_tree_view;
     QStandardItemModel m_execution_tree_model;
 
+    /// Items showing how fast nodes of an execution are received
+    struct IngestRow
+    {
+        Execution *execution;
+        QStandardItem *rate;
+        QStandardItem *queue;
+        QStandardItem *throttled;
+        /// nodes received as of the last update
+        uint64_t last_received;
+    };
+
+    std::vector<IngestRow> m_ingest_rows;
+
+    std::chrono::steady_clock::time_point m_last_update;
+
   public:
     ExecutionList();
 
@@ -34,6 +51,9 @@ class ExecutionList
     void addExecution(Execution &e);
 
     std::vector<Execution *> getSelected();
+
+    /// Refresh ingest rate, queue depth and throttled time of every execution
+    void updateIngestStats();
 };
 
 } // namespace cpprofiler
@@ -24,6 +24,7 @@
 #include <QToolButton>
 
 #include "tree/node_tree.hh"
+#include "tree/layout.hh"
 
 #include "utils/maybe_caller.hh"
 
@@ -56,11 +57,11 @@ LanternMenu::LanternMenu() : QWidget()
     });
 }
 
-ExecutionWindow::ExecutionWindow(Execution &ex, QWidget* parent)
+ExecutionWindow::ExecutionWindow(Execution &ex, tree::LayoutMode mode, QWidget* parent)
     : QMainWindow(parent), execution_(ex)
 {
     const auto &tree = ex.tree();
-    traditional_view_.reset(new tree::TraditionalView(tree, ex.userData(), ex.solver_data()));
+    traditional_view_.reset(new tree::TraditionalView(tree, ex.userData(), ex.solver_data(), mode));
 
     connect(traditional_view_.get(), &tree::TraditionalView::nodeSelected,
             this, &ExecutionWindow::nodeSelected);
@@ -75,7 +76,7 @@ ExecutionWindow::ExecutionWindow(Execution &ex, QWidget* parent)
 
     statusBar()->showMessage("Ready");
 
-    auto stats_bar = new NodeStatsBar(this, tree.node_stats());
+    auto stats_bar = new NodeStatsBar(this, tree.node_stats(), ex.ingestStats());
     statusBar()->addPermanentWidget(stats_bar);
 
     resize(500, 700);
@@ -112,6 +113,9 @@ ExecutionWindow::ExecutionWindow(Execution &ex, QWidget* parent)
         });
 
         {
+            connect(&execution_.tree(), &tree::NodeTree::structureUpdated,
+                    stats_bar, &NodeStatsBar::setOutdated);
+
             auto statsUpdateTimer = new QTimer(this);
             connect(statsUpdateTimer, &QTimer::timeout, stats_bar, &NodeStatsBar::update);
             statsUpdateTimer->start(16);
@@ -434,11 +438,17 @@ void ExecutionWindow::removeSelectedNode()
     const auto pid = execution_.tree().getParent(nid);
     execution_.userData().setSelectedNode(pid);
 
-    execution_.tree().removeNode(nid);
-
-    if (pid != NodeID::NoNode)
     {
-        traditional_view_->dirtyUp(pid);
+        /// the painter and the layout worker must not see the children
+        /// of `pid` change under them
+        utils::DebugMutexLocker layout_lock(&traditional_view_->layout().getMutex(), "window: remove node");
+
+        execution_.tree().removeNode(nid);
+
+        if (pid != NodeID::NoNode)
+        {
+            traditional_view_->dirtyUp(pid);
+        }
     }
 
     traditional_view_->setLayoutOutdated();
@@ -19,6 +19,7 @@ class MaybeCaller;
 namespace tree
 {
 class TraditionalView;
+enum class LayoutMode;
 }
 
 namespace pixel_view
@@ -78,7 +79,7 @@ public:
   /// Show a window with all bookmarks
   void showBookmarks() const;
 
-  ExecutionWindow(Execution &ex, QWidget* parent = nullptr);
+  ExecutionWindow(Execution &ex, tree::LayoutMode mode, QWidget* parent = nullptr);
   ~ExecutionWindow();
 
   Execution& execution()
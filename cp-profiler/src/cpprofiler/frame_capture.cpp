@@ -0,0 +1,60 @@
+#include "frame_capture.hh"
+
+#include <cstring>
+
+namespace cpprofiler
+{
+
+static const char CAPTURE_MAGIC[8] = {'C', 'P', 'P', 'C', 'A', 'P', '0', '1'};
+
+CaptureWriter::CaptureWriter(const std::string &path)
+    : m_out(path, std::ios::binary | std::ios::trunc)
+{
+    m_out.write(CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+}
+
+void CaptureWriter::write(const char *data, int32_t size)
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    if (!m_started)
+    {
+        m_start = now;
+        m_started = true;
+    }
+
+    const int64_t time_us = std::chrono::duration_cast<std::chrono::microseconds>(now - m_start).count();
+
+    m_out.write(reinterpret_cast<const char *>(&time_us), sizeof(time_us));
+    m_out.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    m_out.write(data, size);
+}
+
+CaptureReader::CaptureReader(const std::string &path)
+    : m_in(path, std::ios::binary)
+{
+    char magic[sizeof(CAPTURE_MAGIC)];
+
+    m_valid = m_in.read(magic, sizeof(magic)) && std::memcmp(magic, CAPTURE_MAGIC, sizeof(magic)) == 0;
+}
+
+bool CaptureReader::next(int64_t &time_us, std::vector<char> &frame)
+{
+    if (!m_valid)
+        return false;
+
+    int32_t size;
+
+    if (!m_in.read(reinterpret_cast<char *>(&time_us), sizeof(time_us)) ||
+        !m_in.read(reinterpret_cast<char *>(&size), sizeof(size)) || size < 0)
+    {
+        return false;
+    }
+
+    frame.resize(static_cast<std::size_t>(size));
+
+    /// a truncated last record (e.g. the profiler was killed) is ignored
+    return static_cast<bool>(m_in.read(frame.data(), size));
+}
+
+} // namespace cpprofiler
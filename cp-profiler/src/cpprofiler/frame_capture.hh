@@ -0,0 +1,54 @@
+#ifndef CPPROFILER_FRAME_CAPTURE_HH
+#define CPPROFILER_FRAME_CAPTURE_HH
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/// A capture file records the raw messages received from a solver: it starts
+/// with `CAPTURE_MAGIC`, followed by one record per message consisting of
+/// its arrival time (int64, microseconds since the first message), its size
+/// (int32) and the serialized message itself (as it appeared on the wire)
+
+namespace cpprofiler
+{
+
+class CaptureWriter
+{
+    std::ofstream m_out;
+
+    std::chrono::steady_clock::time_point m_start;
+
+    bool m_started = false;
+
+  public:
+    explicit CaptureWriter(const std::string &path);
+
+    /// Whether the file could be created
+    bool isOpen() const { return m_out.is_open(); }
+
+    /// Record a message that has just arrived
+    void write(const char *data, int32_t size);
+};
+
+class CaptureReader
+{
+    std::ifstream m_in;
+
+    bool m_valid = false;
+
+  public:
+    explicit CaptureReader(const std::string &path);
+
+    /// Whether the file exists and is a capture file
+    bool isValid() const { return m_valid; }
+
+    /// Read the next message into `frame` (false if there are no more)
+    bool next(int64_t &time_us, std::vector<char> &frame);
+};
+
+} // namespace cpprofiler
+
+#endif
@@ -0,0 +1,100 @@
+#include "headless_conductor.hh"
+
+#include "db_handler.hh"
+#include "execution.hh"
+#include "execution_export.hh"
+#include "name_map.hh"
+#include "solver_listener.hh"
+#include "tree_builder.hh"
+
+#include "utils/debug.hh"
+
+#include <QCoreApplication>
+
+namespace cpprofiler
+{
+
+HeadlessConductor::HeadlessConductor(Options opt) : options_(opt)
+{
+    settings_.capture_path = options_.capture_path;
+
+    listener_.reset(new SolverListener(settings_, [this](ReceiverThread *receiver, const std::string &ex_name, int ex_id, bool restarts) {
+        handleStart(receiver, ex_name, ex_id, restarts);
+    }));
+
+    if (options_.replay_path != "")
+    {
+        listener_->replayCapture(options_.replay_path, !options_.replay_fast);
+    }
+}
+
+HeadlessConductor::~HeadlessConductor() = default;
+
+void HeadlessConductor::handleStart(ReceiverThread *receiver, const std::string &ex_name, int ex_id, bool restarts)
+{
+    auto res = executions_.find(ex_id);
+
+    Execution *ex = nullptr;
+
+    if (res == executions_.end())
+    {
+        auto execution = std::make_shared<Execution>(ex_name, ex_id, restarts);
+        executions_[ex_id] = execution;
+        ex = execution.get();
+
+        print("EXECUTION_ID: {}", ex_id);
+
+        if (options_.paths != "" && options_.mzn != "")
+        {
+            auto nm = std::make_shared<NameMap>();
+            if (nm->initialize(options_.paths, options_.mzn))
+            {
+                ex->setNameMap(nm);
+            }
+        }
+
+        auto builder = listener_->startBuilder(*ex, ex_id);
+
+        connect(builder, &TreeBuilder::buildingDone, this, [this, ex]() {
+            onExecutionDone(ex);
+        });
+    }
+    else
+    {
+        ex = res->second.get();
+    }
+
+    listener_->attachReceiver(receiver, *ex, ex_id);
+}
+
+void HeadlessConductor::onExecutionDone(Execution *e)
+{
+    e->tree().setDone();
+
+    print("execution done: {} nodes", e->tree().nodeCount());
+
+    if (options_.save_search_path != "")
+    {
+        print("saving search to: {}", options_.save_search_path);
+        execution_export::save_search(e, options_.save_search_path.c_str());
+    }
+
+    if (options_.save_execution_db != "")
+    {
+        print("saving execution to db: {}", options_.save_execution_db);
+        db_handler::save_execution(e, options_.save_execution_db.c_str());
+    }
+
+    if (options_.save_pixel_tree_path != "")
+    {
+        print("saving pixel tree to file: {}", options_.save_pixel_tree_path);
+        execution_export::save_pixel_tree(e, options_.save_pixel_tree_path.c_str(), options_.pixel_tree_compression);
+    }
+
+    /// the event loop is left with no thread still working on the execution
+    listener_->stop();
+
+    QCoreApplication::quit();
+}
+
+} // namespace cpprofiler
@@ -0,0 +1,49 @@
+#ifndef CPPROFILER_HEADLESS_CONDUCTOR_HH
+#define CPPROFILER_HEADLESS_CONDUCTOR_HH
+
+#include <QObject>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "options.hh"
+#include "settings.hh"
+
+namespace cpprofiler
+{
+
+class Execution;
+class ReceiverThread;
+class SolverListener;
+
+/// Counterpart of `Conductor` for batch use: receives executions from
+/// solvers and writes the outputs requested in `Options` (search, database,
+/// pixel tree) without creating any windows, then quits once an execution
+/// is done (after stopping the threads receiving and building it)
+class HeadlessConductor : public QObject
+{
+    Q_OBJECT
+
+    Options options_;
+
+    Settings settings_;
+
+    /// a map from execution id to an execution
+    std::unordered_map<int, std::shared_ptr<Execution>> executions_;
+
+    /// (destroyed before the executions its builders refer to)
+    std::unique_ptr<SolverListener> listener_;
+
+    void handleStart(ReceiverThread *receiver, const std::string &ex_name, int ex_id, bool restarts);
+
+    void onExecutionDone(Execution *e);
+
+  public:
+    explicit HeadlessConductor(Options opt);
+
+    ~HeadlessConductor();
+};
+
+} // namespace cpprofiler
+
+#endif
@@ -0,0 +1,141 @@
+#include "id_map.hh"
+
+#include <algorithm>
+
+namespace cpprofiler
+{
+
+const IdMap::Lane *IdMap::findLane(int32_t rid, int32_t tid) const
+{
+    const auto key = laneKey(rid, tid);
+
+    if (last_lane_ != -1 && key == last_key_)
+    {
+        return &lanes_[last_lane_];
+    }
+
+    const auto it = lane_idx_.find(key);
+
+    if (it == lane_idx_.end())
+        return nullptr;
+    return &lanes_[it->second];
+}
+
+IdMap::Lane &IdMap::getLane(int32_t rid, int32_t tid)
+{
+    const auto key = laneKey(rid, tid);
+
+    if (last_lane_ != -1 && key == last_key_)
+    {
+        return lanes_[last_lane_];
+    }
+
+    const auto res = lane_idx_.insert({key, static_cast<int>(lanes_.size())});
+
+    if (res.second)
+    {
+        lanes_.emplace_back();
+    }
+
+    last_key_ = key;
+    last_lane_ = res.first->second;
+
+    return lanes_[last_lane_];
+}
+
+void IdMap::Lane::growDense(int32_t size)
+{
+    dense.resize(size, NodeID::NoNode);
+
+    if (size <= sparse_low)
+        return;
+
+    sparse_low = INT32_MAX;
+
+    for (auto it = sparse.begin(); it != sparse.end();)
+    {
+        if (it->first >= 0 && it->first < size)
+        {
+            dense[it->first] = it->second;
+            it = sparse.erase(it);
+        }
+        else
+        {
+            if (it->first >= 0)
+                sparse_low = std::min(sparse_low, it->first);
+            ++it;
+        }
+    }
+}
+
+void IdMap::addPair(SolverID sid, NodeID nid)
+{
+    auto &lane = getLane(sid.rid, sid.tid);
+
+    const int dense_size = lane.dense.size();
+
+    if (sid.nid >= 0 && sid.nid < dense_size)
+    {
+        lane.dense[sid.nid] = nid;
+    }
+    else if (sid.nid >= 0 && sid.nid < 2 * dense_size + MAX_GAP)
+    {
+        lane.growDense(sid.nid + 1);
+        lane.dense[sid.nid] = nid;
+    }
+    else
+    {
+        lane.sparse[sid.nid] = nid;
+
+        if (sid.nid >= 0)
+            lane.sparse_low = std::min(lane.sparse_low, sid.nid);
+    }
+
+    if (static_cast<int>(nid) >= nid2uid_.size())
+    {
+        nid2uid_.resize(nid + 1, {-1, -1, -1});
+    }
+
+    nid2uid_[nid] = sid;
+
+    uid_count_ = nid2uid_.size();
+}
+
+NodeID IdMap::get(SolverID sid) const
+{
+    const auto lane = findLane(sid.rid, sid.tid);
+
+    if (!lane)
+        return NodeID::NoNode;
+
+    if (sid.nid >= 0 && sid.nid < static_cast<int>(lane->dense.size()))
+    {
+        return lane->dense[sid.nid];
+    }
+
+    if (lane->sparse.empty())
+        return NodeID::NoNode;
+
+    const auto it = lane->sparse.find(sid.nid);
+
+    if (it != lane->sparse.end())
+    {
+        return it->second;
+    }
+    else
+    {
+        return NodeID::NoNode;
+    }
+}
+
+SolverID IdMap::getUID(NodeID nid) const
+{
+    if (nid < 0 || nid >= uid_count_)
+    {
+        return {-1, -1, -1};
+    }
+
+    return nid2uid_[nid];
+}
+
+} // namespace cpprofiler
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "core.hh"
+#include "solver_id.hh"
+#include "utils/atomic_value.hh"
+#include "utils/chunked_vector.hh"
+
+namespace cpprofiler
+{
+
+/// Maps solver node ids (nid, rid, tid) to NodeIDs and back.
+///
+/// Solver ids are dense within one (restart, thread) pair, so each pair gets
+/// a vector indexed by the solver's nid; ids far beyond the ones seen so far
+/// (or negative) go to a per-pair hash map instead. The reverse direction is
+/// a column indexed by NodeID.
+///
+/// Only the thread building the tree may modify the map or look up NodeIDs;
+/// solver ids of nodes already published by the tree may be read by any thread.
+class IdMap
+{
+    /// Ids of one (restart, thread) pair
+    struct Lane
+    {
+        /// NodeID of every solver nid below `dense.size()` (NoNode for gaps)
+        std::vector<NodeID> dense;
+        /// Ids that would make `dense` mostly empty (always negative
+        /// or beyond `dense`: they move there when it grows past them)
+        std::unordered_map<int32_t, NodeID> sparse;
+        /// Smallest non-negative id in `sparse` (INT32_MAX if none)
+        int32_t sparse_low = INT32_MAX;
+
+        /// Grow `dense` to `size`, taking over the sparse ids it now covers
+        void growDense(int32_t size);
+    };
+
+    /// Allowed growth of a dense vector beyond doubling its size
+    static constexpr int MAX_GAP = 1024;
+
+    std::vector<Lane> lanes_;
+
+    /// Index into `lanes_` by (rid, tid)
+    std::unordered_map<uint64_t, int> lane_idx_;
+
+    /// The most recently used lane (consecutive ids tend to share it)
+    uint64_t last_key_ = 0;
+    int last_lane_ = -1;
+
+    /// Solver id of every node (nid = -1 if unknown)
+    utils::ChunkedVector<SolverID> nid2uid_;
+
+    /// Size of `nid2uid_` as seen by other threads
+    utils::AtomicValue<int> uid_count_{0};
+
+    static uint64_t laneKey(int32_t rid, int32_t tid)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(rid)) << 32) | static_cast<uint32_t>(tid);
+    }
+
+    /// Lane for (rid, tid) or nullptr if no id from it has been seen
+    const Lane *findLane(int32_t rid, int32_t tid) const;
+
+    Lane &getLane(int32_t rid, int32_t tid);
+
+  public:
+    void addPair(SolverID, NodeID);
+
+    NodeID get(SolverID) const;
+
+    SolverID getUID(NodeID nid) const;
+};
+
+} // namespace cpprofiler
@@ -0,0 +1,14 @@
+#include "local_server.hh"
+
+namespace cpprofiler
+{
+
+LocalServer::LocalServer(std::function<void(intptr_t)> callback)
+    : QLocalServer{}, m_callback(callback) {}
+
+void LocalServer::incomingConnection(quintptr handle)
+{
+    m_callback(static_cast<intptr_t>(handle));
+}
+
+} // namespace cpprofiler
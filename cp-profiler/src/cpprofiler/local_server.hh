@@ -0,0 +1,27 @@
+#ifndef CPPROFILER_LOCAL_SERVER_HH
+#define CPPROFILER_LOCAL_SERVER_HH
+
+#include <QLocalServer>
+#include <functional>
+#include <cstdint>
+
+namespace cpprofiler
+{
+
+/// Accepts solvers running on the same machine (over a Unix domain
+/// socket, or a named pipe on Windows), avoiding the loopback TCP stack
+class LocalServer : public QLocalServer
+{
+    Q_OBJECT
+  public:
+    LocalServer(std::function<void(intptr_t)> callback);
+
+  private:
+    void incomingConnection(quintptr socketDesc) override;
+
+    std::function<void(intptr_t)> m_callback;
+};
+
+} // namespace cpprofiler
+
+#endif
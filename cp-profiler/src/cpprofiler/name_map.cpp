@@ -3,23 +3,25 @@
 #include "utils/string_utils.hh"
 #include "utils/path_utils.hh"
 
+#include "utils/perf_helper.hh"
+
 #include <QDebug>
+#include <QFile>
 #include <QString>
 #include <QStringList>
+#include <algorithm>
+#include <climits>
+#include <cstring>
 #include <fstream>
-#include <regex>
+#include <thread>
 #include <utility>
 
-using std::stoi;
 using std::string;
 using std::vector;
 
 namespace cpprofiler
 {
 
-static const std::regex var_name_regex("[A-Za-z][A-Za-z0-9_]*");
-static const std::regex assignment_regex("[A-Za-z][A-Za-z0-9_]*=[0-9]*");
-
 static vector<string> read_file_by_lines(const string &file)
 {
     std::ifstream model_file(file, std::ifstream::in);
@@ -47,41 +49,128 @@ std::ostream &operator<<(std::ostream &os, const Location &l)
     return os << l.sl << " " << l.sc << " " << l.el << " " << l.ec;
 }
 
-/// extract location and whether it is final from a paths line
-static std::pair<Location, bool> getLocation(const string &path)
+/// Parse a (non-negative or negative) integer at `pos` advancing `pos` past it;
+/// fails if there are no digits or the number does not fit into an int
+static bool parse_int(const char *&pos, const char *end, int &value)
 {
+    const bool negative = pos < end && *pos == '-';
+    if (negative)
+        ++pos;
 
-    auto model_name = path.substr(0, path.find(utils::minor_sep));
+    /// the magnitude of the most negative int
+    const long long limit = negative ? -static_cast<long long>(INT_MIN) : INT_MAX;
 
-    auto name_pos = path.rfind(model_name);
-    auto end_elm = path.find(utils::major_sep, name_pos);
+    const char *digits = pos;
+    long long res = 0;
 
-    auto element = path.substr(name_pos, end_elm - name_pos);
+    while (pos < end && *pos >= '0' && *pos <= '9')
+    {
+        /// stop accumulating once out of range (the digits are still consumed)
+        if (res <= limit)
+            res = res * 10 + (*pos - '0');
+        ++pos;
+    }
 
-    auto loc_parts = utils::split(element, utils::minor_sep);
+    if (pos == digits || res > limit)
+        return false;
 
-    auto loc = Location(stoi(loc_parts[1]), stoi(loc_parts[2]),
-                        stoi(loc_parts[3]), stoi(loc_parts[4]));
+    value = static_cast<int>(negative ? -res : res);
+    return true;
+}
 
-    bool is_final = false;
+/// Extract the location from a path: the location is in the last
+/// element of the path that refers to the model, which looks like
+/// <model>|<sl>|<sc>|<el>|<ec>|...;
+static bool parse_location(utils::StringRef path, Location &loc)
+{
+    const char *const begin = path.data;
+    const char *const end = path.data + path.size;
 
-    if (end_elm == path.size() - 1)
+    const auto name_len = static_cast<std::size_t>(std::find(begin, end, utils::minor_sep) - begin);
+
+    if (name_len == 0 || name_len == path.size)
+        return false;
+
+    /// the last occurrence of the model name
+    auto name_pos = path.size - name_len;
+    while (std::memcmp(begin + name_pos, begin, name_len) != 0)
     {
-        is_final = true;
+        --name_pos;
     }
-    else
+
+    const char *pos = begin + name_pos + name_len;
+    const char *const elm_end = std::find(pos, end, utils::major_sep);
+
+    int values[4];
+
+    for (auto &value : values)
     {
-        auto rem = path.substr(end_elm + 1);
-        auto loc_parts = utils::split(rem, utils::minor_sep, true);
+        if (pos == elm_end || *pos != utils::minor_sep)
+            return false;
+        ++pos;
+
+        if (!parse_int(pos, elm_end, value))
+            return false;
+    }
+
+    loc = Location(values[0], values[1], values[2], values[3]);
+    return true;
+}
+
+/// Paths files are split into chunks of at least this many bytes
+/// (each parsed by its own thread)
+static constexpr std::size_t MIN_CHUNK_SIZE = 1 << 20;
 
-        if (stoi(loc_parts[1]) == 0 && stoi(loc_parts[2]) == 0 &&
-            stoi(loc_parts[3]) == 0 && stoi(loc_parts[4]) == 0)
+/// A line of the paths file
+struct PathsLine
+{
+    utils::StringRef id;
+    utils::StringRef nice_name;
+    utils::StringRef path;
+    Location location;
+};
+
+/// Parse the lines of a paths file that start in [begin, end) (`begin`
+/// must be at the beginning of a line); returns `false` if a line is invalid
+static bool parse_paths_lines(const char *begin, const char *end, std::vector<PathsLine> &lines)
+{
+    const char *pos = begin;
+
+    while (pos < end)
+    {
+        const char *line_end = std::find(pos, end, '\n');
+        const char *next = line_end == end ? end : line_end + 1;
+
+        if (line_end > pos && line_end[-1] == '\r')
+            --line_end;
+
+        /// the first three (non-empty) tab-separated columns
+        utils::StringRef columns[3];
+        int n_columns = 0;
+
+        for (const char *col = pos; col < line_end && n_columns < 3;)
+        {
+            const char *col_end = std::find(col, line_end, '\t');
+            if (col_end != col)
+            {
+                columns[n_columns++] = {col, static_cast<std::size_t>(col_end - col)};
+            }
+            col = col_end == line_end ? line_end : col_end + 1;
+        }
+
+        if (n_columns > 0)
         {
-            is_final = true;
+            Location loc;
+            if (n_columns < 3 || !parse_location(columns[2], loc))
+                return false;
+
+            lines.push_back({columns[0], columns[1], columns[2], loc});
         }
+
+        pos = next;
     }
 
-    return std::make_pair(loc, is_final);
+    return true;
 }
 
 static const Location empty_location{};
@@ -103,7 +192,7 @@ static const string findPath(const SymbolTable &st, const string &ident)
     auto it = st.find(ident);
     if (it != st.end())
     {
-        return it->second.path;
+        return it->second.path.str();
     }
     return empty_string;
 }
@@ -124,68 +213,71 @@ static string getPathUntilDecomp(const string &path)
     return path.substr(0, end_pos);
 }
 
-/// expression (template) element
-struct TElem
+static bool is_ident_start(char ch)
 {
-    string str;
-    bool is_id;
-};
+    return (ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z');
+}
 
-std::ostream &operator<<(std::ostream &os, const TElem &el)
+static bool is_ident_char(char ch)
 {
-    return os << el.str << (el.is_id ? "(id)" : "");
+    return is_ident_start(ch) || (ch >= '0' && ch <= '9') || ch == '_';
 }
 
-using Expression = vector<TElem>;
-
-std::string NameMap::replaceNames(const std::string &text, bool expand) const
+/// Identifiers are of the form [A-Za-z][A-Za-z0-9_]*; every one
+/// found in `text` is replaced by its nice name
+std::string NameMap::replaceNames(const std::string &text, bool) const
 {
+    std::string res;
+    res.reserve(text.size());
 
-    const auto var_names_begin =
-        std::sregex_iterator(text.begin(), text.end(), var_name_regex);
-    const auto var_names_end = std::sregex_iterator();
+    const char *pos = text.data();
+    const char *const end = pos + text.size();
 
-    size_t pos = 0;
+    while (pos < end)
+    {
+        const char *begin = pos;
+        while (pos < end && !is_ident_start(*pos))
+            ++pos;
 
-    Expression expr;
+        res.append(begin, pos);
 
-    /// this might require some caching
+        if (pos == end)
+            break;
 
-    for (auto it = var_names_begin; it != var_names_end; ++it)
-    {
-        auto match = *it;
-        auto str = text.substr(pos, static_cast<size_t>(match.position()) - pos);
+        begin = pos;
+        while (pos < end && is_ident_char(*pos))
+            ++pos;
 
-        if (match.position() != 0)
-        {
-            const auto non_id =
-                text.substr(pos, static_cast<size_t>(match.position()) - pos);
-            expr.push_back({non_id, false});
-        }
+        const auto nice_name = getNiceName({begin, static_cast<std::size_t>(pos - begin)});
+        res.append(nice_name.data, nice_name.size);
+    }
 
-        const auto id = match.str();
-        expr.push_back({id, true});
+    return res;
+}
 
-        pos = static_cast<size_t>(match.position() + match.length());
-    }
+std::string NameMap::replaceNamesCached(const std::string &text) const
+{
+    utils::MutexLocker lock(&cache_mutex_, "name map: cache");
 
-    expr.push_back({text.substr(pos), false});
+    const auto it = cache_index_.find(text);
 
-    std::stringstream ss;
+    if (it != cache_index_.end())
+    {
+        /// move to the front
+        cache_.splice(cache_.begin(), cache_, it->second);
+        return it->second->second;
+    }
 
-    for (const auto &el : expr)
+    if (cache_.size() == CACHE_CAPACITY)
     {
-        if (el.is_id)
-        {
-            ss << getNiceName(el.str);
-        }
-        else
-        {
-            ss << el.str;
-        }
+        cache_index_.erase(cache_.back().first);
+        cache_.pop_back();
     }
 
-    return ss.str();
+    cache_.emplace_front(text, replaceNames(text));
+    cache_index_.insert({cache_.front().first, cache_.begin()});
+
+    return cache_.front().second;
 }
 
 // static string replaceAssignments(const string& path, const string&
@@ -231,32 +323,111 @@ void NameMap::addIdExpressionToMap(const vector<string> &model,
     // replaceAssignments(path_until, expression);
 }
 
+constexpr std::size_t NameMap::CACHE_CAPACITY;
+
 NameMap::NameMap() {}
 
+NameMap::~NameMap() {}
+
+bool NameMap::readPathsFile(const std::string &path_filename, utils::StringRef &contents)
+{
+    paths_file_.reset(new QFile(QString::fromStdString(path_filename)));
+
+    if (!paths_file_->open(QIODevice::ReadOnly))
+    {
+        print("ERROR: cannot open paths file: {}", path_filename);
+        return false;
+    }
+
+    const auto size = paths_file_->size();
+
+    if (size == 0)
+        return false;
+
+    const auto data = paths_file_->map(0, size);
+
+    if (data)
+    {
+        contents = {reinterpret_cast<const char *>(data), static_cast<std::size_t>(size)};
+    }
+    else
+    {
+        paths_buffer_ = paths_file_->readAll().toStdString();
+        contents = paths_buffer_;
+    }
+
+    return true;
+}
+
 bool NameMap::initialize(const std::string &path_filename,
                          const std::string &model_filename)
 {
+    perf_helper::Timer timer;
+    timer.begin();
+
     vector<string> model_lines = read_file_by_lines(model_filename);
-    vector<string> paths_lines = read_file_by_lines(path_filename);
 
-    if (model_lines.size() == 0 || paths_lines.size() == 0)
+    utils::StringRef contents;
+
+    if (model_lines.size() == 0 || !readPathsFile(path_filename, contents))
         return false;
 
-    try
+    const char *const begin = contents.data;
+    const char *const end = contents.data + contents.size;
+
+    /// split the file into chunks of whole lines, one per thread
+    const auto max_threads = std::max(1u, std::thread::hardware_concurrency());
+    const auto n_chunks = static_cast<int>(std::min<std::size_t>(max_threads, contents.size / MIN_CHUNK_SIZE + 1));
+
+    std::vector<const char *> bounds{begin};
+    for (auto i = 1; i < n_chunks; ++i)
+    {
+        const char *pos = std::max(bounds.back(), begin + contents.size * i / n_chunks);
+        pos = std::find(pos, end, '\n');
+        bounds.push_back(pos == end ? end : pos + 1);
+    }
+    bounds.push_back(end);
+
+    std::vector<std::vector<PathsLine>> chunks(n_chunks);
+    std::unique_ptr<bool[]> valid{new bool[n_chunks]};
+
     {
+        std::vector<std::thread> workers;
+
+        for (auto i = 1; i < n_chunks; ++i)
+        {
+            workers.emplace_back([&, i]() {
+                valid[i] = parse_paths_lines(bounds[i], bounds[i + 1], chunks[i]);
+            });
+        }
+
+        valid[0] = parse_paths_lines(bounds[0], bounds[1], chunks[0]);
 
-        for (auto &line : paths_lines)
+        for (auto &worker : workers)
         {
-            const auto parts = utils::split(line, '\t');
+            worker.join();
+        }
+    }
 
-            const auto id = parts.at(0);
-            const auto nice_name = parts.at(1);
-            const auto path = parts.at(2);
-            const auto loc = getLocation(parts.at(2));
+    std::size_t total = 0;
+    for (auto i = 0; i < n_chunks; ++i)
+    {
+        if (!valid[i])
+        {
+            print("ERROR: invalid name map");
+            return false;
+        }
+        total += chunks[i].size();
+    }
 
-            id_map_.insert({id, SymbolRecord(nice_name, path, loc.first)});
+    /// insert in the file order (the first line for an id is used)
+    id_map_.reserve(total);
 
-            const auto is_final = loc.second;
+    for (const auto &chunk : chunks)
+    {
+        for (const auto &line : chunk)
+        {
+            id_map_.insert({line.id, SymbolRecord(line.nice_name, line.path, line.location)});
 
             /// TODO: handle complex expressions
 
@@ -268,17 +439,15 @@ bool NameMap::initialize(const std::string &path_filename,
             //   // addDecompIdExpressionToMap(s[0], modelText);
             // }
         }
-
-        return true;
-    }
-    catch (std::exception &e)
-    {
-        qDebug() << "ERR: invalid name map";
-        return false;
     }
+
+    print("name map: {} symbols ({} bytes, {} threads) loaded in {}ms",
+          id_map_.size(), contents.size, n_chunks, timer.end());
+
+    return true;
 }
 
-const NiceName &NameMap::getNiceName(const std::string &ident) const
+utils::StringRef NameMap::getNiceName(utils::StringRef ident) const
 {
     auto it = id_map_.find(ident);
     if (it != id_map_.end())
@@ -286,16 +455,16 @@ const NiceName &NameMap::getNiceName(const std::string &ident) const
         return it->second.nice_name;
     }
 
-    return empty_string;
+    return {};
 }
 
-const Path &NameMap::getPath(const std::string &ident) const
+Path NameMap::getPath(const std::string &ident) const
 {
 
     auto it = id_map_.find(ident);
     if (it != id_map_.end())
     {
-        return it->second.path;
+        return it->second.path.str();
     }
 
     return empty_string;
@@ -1,10 +1,17 @@
 #pragma once
 
+#include <list>
+#include <memory>
 #include <string>
 #include <QString>
 #include <vector>
 #include <unordered_map>
 
+#include "utils/debug_mutex.hh"
+#include "utils/string_utils.hh"
+
+class QFile;
+
 //// Name Map should get the paths file and model and generate a mapping from UGLY to NICE names
 
 /// A line in a paths file consists of three columns:
@@ -25,19 +32,22 @@ struct Location
     Location(int sl_, int sc_, int el_, int ec_) : sl(sl_), sc(sc_), el(el_), ec(ec_) {}
 };
 
+/// Names and paths refer to the (memory-mapped) paths file
 struct SymbolRecord
 {
 
-    std::string nice_name;
-    std::string path;
+    utils::StringRef nice_name;
+    utils::StringRef path;
     Location location;
 
     SymbolRecord() = default;
-    SymbolRecord(const std::string &nname, const std::string &p, const Location &loc)
+    SymbolRecord(utils::StringRef nname, utils::StringRef p, const Location &loc)
         : nice_name(nname), path(p), location(loc) {}
 };
 
-using SymbolTable = std::unordered_map<std::string, SymbolRecord>;
+/// Symbols indexed by their names in the paths file, so that
+/// identifiers can be looked up in place
+using SymbolTable = std::unordered_map<utils::StringRef, SymbolRecord, utils::StringRefHash>;
 using ExpressionTable = std::unordered_map<std::string, std::string>;
 
 using NiceName = std::string;
@@ -46,28 +56,53 @@ using Path = std::string;
 class NameMap
 {
 
+    /// The paths file (mapped into memory while the map exists)
+    std::unique_ptr<QFile> paths_file_;
+    /// Contents of the paths file if it could not be mapped
+    std::string paths_buffer_;
+
     SymbolTable id_map_;
     ExpressionTable expression_map_;
 
-    const NiceName &getNiceName(const std::string &ident) const;
+    /// Texts renamed by `replaceNamesCached` (most recently used first)
+    using CacheList = std::list<std::pair<std::string, std::string>>;
+
+    static constexpr std::size_t CACHE_CAPACITY = 4096;
+
+    mutable CacheList cache_;
+    /// Entries of `cache_` indexed by (references to) their original text
+    mutable std::unordered_map<utils::StringRef, CacheList::iterator, utils::StringRefHash> cache_index_;
+    mutable utils::Mutex cache_mutex_;
+
+    /// Map the paths file into memory (or read it if that fails)
+    bool readPathsFile(const std::string &path_filename, utils::StringRef &contents);
+
+    utils::StringRef getNiceName(utils::StringRef ident) const;
     void addIdExpressionToMap(const std::vector<std::string> &model, const std::string &ident);
 
   public:
 
     NameMap();
 
-    /// Read paths and the model files to construct name mapping;
+    ~NameMap();
+
+    /// The symbol table and the cache refer to the map's own strings
+    NameMap(const NameMap &) = delete;
+    NameMap &operator=(const NameMap &) = delete;
+
+    /// Read paths and the model files to construct name mapping
+    /// (the paths file is parsed by several threads in parallel);
     /// Returns `true` if successful -- `false` otherwise
     bool initialize(const std::string &path_filename, const std::string &model_filename);
 
     std::string replaceNames(const std::string &text, bool expand = false) const;
 
+    /// Same as `replaceNames`, but remembers recent results; meant for
+    /// texts renamed on display (e.g. nogoods) that are shown repeatedly
+    std::string replaceNamesCached(const std::string &text) const;
 
-    const Path& getPath(const std::string &ident) const;
-
-
-
-
+    /// Path of the symbol `ident` (empty if not known)
+    Path getPath(const std::string &ident) const;
 };
 
 } // namespace cpprofiler
\ No newline at end of file
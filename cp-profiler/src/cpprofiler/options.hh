@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string>
+
 namespace cpprofiler
 {
 
@@ -10,7 +12,13 @@ struct Options
     std::string save_search_path;
     std::string save_execution_db;
     std::string save_pixel_tree_path;
-    int pixel_tree_compression;
+    int pixel_tree_compression = 2;
+    std::string capture_path;
+    std::string replay_path;
+    /// replay as fast as possible (rather than at the recorded speed)
+    bool replay_fast = false;
+    /// lay out trees with threaded contours rather than per-node shapes
+    bool contour_layout = false;
 };
 
 } // namespace cpprofiler
@@ -121,17 +121,15 @@ std::vector<PixelItem> PtCanvas::constructPixelTree() const
 {
 
     print("pt: construct tree");
-    /// TODO: tree mutex
+    tree::SnapshotPin pin(tree_);
     auto root = tree_.getRoot();
 
     std::stack<NodeID> stack;
-    std::stack<int> depth_stack;
 
     std::vector<PixelItem> pixel_seq;
     pixel_seq.reserve(tree_.nodeCount());
 
     stack.push(root);
-    depth_stack.push(1);
 
     while (!stack.empty())
     {
@@ -139,18 +137,14 @@ std::vector<PixelItem> PtCanvas::constructPixelTree() const
         auto n = stack.top();
         stack.pop();
 
-        auto depth = depth_stack.top();
-        depth_stack.pop();
-
         /// add pixel data
-        pixel_seq.push_back({n, depth});
+        pixel_seq.push_back({n, tree_.getDepth(n)});
 
         int kids = tree_.childrenCount(n);
 
         for (auto i = kids - 1; i >= 0; --i)
         {
             stack.push(tree_.getChild(n, i));
-            depth_stack.push(depth + 1);
         }
     }
 
@@ -6,6 +6,7 @@
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <QLocalSocket>
 #include <QTcpSocket>
 #include "utils/debug.hh"
 
@@ -14,17 +15,29 @@ namespace cpprofiler
 
 class Message;
 
-ReceiverThread::ReceiverThread(intptr_t socket_desc, const Settings &s)
-    : m_socket_desc(socket_desc), m_settings(s)
+ReceiverThread::ReceiverThread(intptr_t socket_desc, const Settings &s, Transport transport)
+    : m_socket_desc(socket_desc), m_transport(transport), m_settings(s)
 {
     std::cerr << "socket descriptor: " << socket_desc << std::endl;
 }
 
 void ReceiverThread::run()
 {
+    if (m_transport == Transport::Local)
+    {
+        QLocalSocket socket;
+        receive(socket);
+    }
+    else
+    {
+        QTcpSocket socket;
+        receive(socket);
+    }
+}
 
-    QTcpSocket socket;
-
+template <typename Socket>
+void ReceiverThread::receive(Socket &socket)
+{
     m_worker.reset(new ReceiverWorker{socket, m_settings});
 
     /// propagate the signal further upwards;
@@ -33,8 +46,8 @@ void ReceiverThread::run()
     connect(m_worker.get(), &ReceiverWorker::notifyStart,
             this, &ReceiverThread::notifyStart, Qt::BlockingQueuedConnection);
 
-    connect(m_worker.get(), &ReceiverWorker::newNode,
-            this, &ReceiverThread::newNode);
+    connect(m_worker.get(), &ReceiverWorker::nodesAvailable,
+            this, &ReceiverThread::nodesAvailable);
 
     connect(m_worker.get(), &ReceiverWorker::doneReceiving,
             this, &ReceiverThread::doneReceiving);
@@ -48,14 +61,27 @@ void ReceiverThread::run()
         return;
     }
 
-    connect(&socket, &QTcpSocket::readyRead, m_worker.get(), &ReceiverWorker::doRead);
+    connect(&socket, &Socket::readyRead, m_worker.get(), &ReceiverWorker::doRead);
+
+    /// bound the socket's buffer so that unread data stays with the OS
+    /// (and flow control kicks in) while the receiver is throttled
+    socket.setReadBufferSize(SOCKET_BUFFER_SIZE);
+
+    /// messages may still be waiting when the solver disconnects
+    connect(&socket, &Socket::disconnected,
+            m_worker.get(), &ReceiverWorker::finishReading);
 
-    connect(&socket, &QTcpSocket::disconnected, [this]() {
+    connect(m_worker.get(), &ReceiverWorker::readingFinished, [this]() {
         this->quit();
     });
 
     exec();
 }
 
+void ReceiverThread::setIngestStats(IngestStats *stats)
+{
+    m_worker->setIngestStats(stats);
+}
+
 ReceiverThread::~ReceiverThread() = default;
 } // namespace cpprofiler
\ No newline at end of file
@@ -5,33 +5,55 @@
 #include <memory>
 #include <QThread>
 
+#include "tree_builder.hh"
+
 namespace cpprofiler
 {
 
 class Conductor;
-class Message;
 class Execution;
 class ReceiverWorker;
 class Settings;
+struct IngestStats;
+
+/// How a solver is connected to the profiler
+enum class Transport
+{
+    Tcp,
+    /// Unix domain socket (named pipe on Windows)
+    Local
+};
 
 class ReceiverThread : public QThread
 {
     Q_OBJECT
     const intptr_t m_socket_desc;
+    const Transport m_transport;
     std::unique_ptr<ReceiverWorker> m_worker;
 
     const Settings &m_settings;
 
+    /// maximum number of bytes the socket reads ahead of the worker
+    static constexpr int SOCKET_BUFFER_SIZE = 1 << 20;
+
     void run() override;
 
+    /// Receive messages from `socket` (QTcpSocket or QLocalSocket)
+    /// until the solver disconnects
+    template <typename Socket>
+    void receive(Socket &socket);
+
   signals:
 
     void notifyStart(const std::string &ex_name, int ex_id, bool restarts);
-    void newNode(Message *node);
+    void nodesAvailable(std::shared_ptr<cpprofiler::NodeQueue> queue);
     void doneReceiving();
 
   public:
-    ReceiverThread(intptr_t socket_desc, const Settings &s);
+    ReceiverThread(intptr_t socket_desc, const Settings &s, Transport transport = Transport::Tcp);
+
+    /// Report ingestion to `stats` (from a slot connected to `notifyStart`)
+    void setIngestStats(IngestStats *stats);
     ~ReceiverThread();
 };
 
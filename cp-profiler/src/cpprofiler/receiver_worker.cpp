@@ -1,13 +1,17 @@
 #include "receiver_worker.hh"
 #include "conductor.hh"
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <string>
 #include <thread>
-#include <QTcpSocket>
+#include <QIODevice>
+#include <QTimer>
 #include <QJsonObject>
 #include <QJsonDocument>
 
 #include "execution.hh"
+#include "frame_capture.hh"
 #include "utils/utils.hh"
 
 #include "tree/node.hh"
@@ -16,73 +20,245 @@
 namespace cpprofiler
 {
 
-ReceiverWorker::ReceiverWorker(QTcpSocket &socket, const Settings &s)
-    : m_socket(socket), m_settings(s)
+/// The first connection is recorded to `base`, further ones to `base`.1,
+/// `base`.2 etc.
+static std::string capturePath(const std::string &base)
 {
+    static std::atomic<int> n_captures{0};
+
+    const int idx = n_captures++;
+
+    return idx == 0 ? base : base + "." + std::to_string(idx);
 }
 
-static int32_t ArrayToInt(const QByteArray &ba)
+ReceiverWorker::ReceiverWorker(QIODevice &socket, const Settings &s)
+    : m_buffer(BUFFER_SIZE), m_socket(socket),
+      m_queues(TreeBuilder::shardCount(s)), m_queue_unnotified(m_queues.size(), 0), m_settings(s)
 {
-    const char *p = ba.data();
-    return *(reinterpret_cast<const quint32 *>(p));
+    qRegisterMetaType<std::shared_ptr<NodeQueue>>();
+
+    m_resume_timer = new QTimer(this);
+    m_resume_timer->setInterval(RESUME_INTERVAL);
+    connect(m_resume_timer, &QTimer::timeout, this, &ReceiverWorker::doRead);
+
+    if (m_settings.capture_path != "")
+    {
+        const auto path = capturePath(m_settings.capture_path);
+        m_capture.reset(new CaptureWriter(path));
+
+        if (!m_capture->isOpen())
+        {
+            print("ERROR: cannot record to {}", path);
+            m_capture.reset();
+        }
+    }
 }
 
-void ReceiverWorker::doRead()
+ReceiverWorker::~ReceiverWorker() = default;
+
+void ReceiverWorker::setIngestStats(IngestStats *stats)
+{
+    m_ingest = stats;
+}
+
+NodeQueue &ReceiverWorker::queueFor(int32_t tid)
+{
+    const auto shard = TreeBuilder::shardOf(tid, m_queues.size());
+
+    auto &queue = m_queues[shard];
+
+    if (!queue)
+    {
+        queue = std::make_shared<NodeQueue>(QUEUE_CAPACITY, shard);
+    }
+
+    return *queue;
+}
+
+bool ReceiverWorker::throttle()
 {
-    // are there enough bytes to read something
-    bool can_read_more = true;
+    int depth = 0;
+
+    for (const auto &queue : m_queues)
+    {
+        if (queue)
+            depth = std::max(depth, queue->size());
+    }
+
+    if (!m_throttled && depth >= HIGH_WATER_MARK)
+    {
+        m_throttled = true;
+        m_throttled_since = std::chrono::steady_clock::now();
+        m_resume_timer->start();
+
+        /// make sure the builder is working on the backlog
+        notifyBuilder();
+
+        if (m_ingest)
+            m_ingest->throttled = true;
+    }
+    else if (m_throttled && depth <= LOW_WATER_MARK)
+    {
+        m_throttled = false;
+        m_resume_timer->stop();
+
+        if (m_ingest)
+        {
+            const auto duration = std::chrono::steady_clock::now() - m_throttled_since;
+            m_ingest->throttled_ms += std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+            m_ingest->throttled = false;
+        }
+    }
+
+    return m_throttled;
+}
 
-    while (m_socket.bytesAvailable() > 0 || can_read_more)
+void ReceiverWorker::fillBuffer()
+{
+    while (m_socket.bytesAvailable() > 0)
     {
+        std::size_t len;
+        char *dest = m_buffer.writePtr(len);
+
+        if (len == 0)
+            return;
 
-        if (m_socket.bytesAvailable() > 0)
-            can_read_more = true;
+        const auto n = m_socket.read(dest, static_cast<qint64>(len));
+
+        if (n <= 0)
+            return;
+
+        m_buffer.commit(static_cast<std::size_t>(n));
+    }
+}
 
-        m_buffer.append(m_socket.readAll());
+void ReceiverWorker::processMessages()
+{
+    while (!m_failed)
+    {
+        /// leave the remaining messages until the builder catches up
+        if (throttle())
+            return;
 
         // read the size of the next field if haven't already
         if (!m_state.size_read)
         {
+            if (m_buffer.size() < FIELD_SIZE_NBYTES)
+                return;
 
-            if (m_buffer.size() < m_state.bytes_read + FIELD_SIZE_NBYTES)
+            int32_t size;
+            m_buffer.copyOut(reinterpret_cast<char *>(&size), FIELD_SIZE_NBYTES);
+            m_buffer.consume(FIELD_SIZE_NBYTES);
+
+            if (size <= 0 || size > MAX_MESSAGE_SIZE)
             {
-                /// can't read, need to wait for more bytes
-                can_read_more = false;
-                continue;
+                print("ERROR: invalid message size: {}", size);
+                abortReading();
+                return;
             }
 
-            /// enough bytes to read size
-            m_state.msg_size = ArrayToInt(m_buffer.mid(m_state.bytes_read, 4));
-            m_state.bytes_read += 4;
+            m_state.msg_size = size;
             m_state.size_read = true;
         }
-        else
+
+        const auto msg_size = static_cast<std::size_t>(m_state.msg_size);
+
+        if (m_buffer.size() < msg_size)
         {
+            /// make sure the whole message will fit
+            m_buffer.reserve(msg_size);
+            return;
+        }
 
-            if (m_buffer.size() < m_state.bytes_read + m_state.msg_size)
-            {
-                /// can't read, need to wait for more bytes
-                can_read_more = false;
-                continue;
-            }
+        char *data = m_buffer.peek(msg_size);
 
-            marshalling.deserialize(m_buffer.data() + m_state.bytes_read, m_state.msg_size);
+        if (!data)
+        {
+            /// slow path: the message wraps around the end of the buffer
+            m_frame.resize(msg_size);
+            m_buffer.copyOut(m_frame.data(), msg_size);
+            data = m_frame.data();
+        }
 
-            auto msg = marshalling.get_msg();
-            handleMessage(msg);
+        if (m_capture)
+        {
+            m_capture->write(data, m_state.msg_size);
+        }
 
-            m_state.bytes_read += m_state.msg_size;
-            m_state.size_read = false;
+        marshalling.deserialize(data, m_state.msg_size);
 
-            m_state.msg_processed++;
+        auto msg = marshalling.get_msg();
+        handleMessage(msg);
 
-            /// reset the buffer every MSG_PER_BUFFER messages
-            if (m_state.msg_processed == MSG_PER_BUFFER)
-            {
-                m_state.msg_processed = 0;
-                m_buffer.remove(0, m_state.bytes_read);
-                m_state.bytes_read = 0;
-            }
+        m_buffer.consume(msg_size);
+        m_state.size_read = false;
+    }
+}
+
+void ReceiverWorker::abortReading()
+{
+    m_failed = true;
+
+    notifyBuilder();
+    emit doneReceiving();
+
+    print("closing the connection");
+    m_disconnected = true;
+    m_socket.close();
+}
+
+void ReceiverWorker::doRead()
+{
+    /// The buffer may fill up before the socket is drained. While throttled,
+    /// data is left in the socket (whose buffer is bounded), so that TCP flow
+    /// control slows the solver down; the resume timer calls this again.
+    do
+    {
+        if (throttle())
+            break;
+
+        fillBuffer();
+        processMessages();
+    } while (m_socket.bytesAvailable() > 0 && !m_throttled);
+
+    notifyBuilder();
+
+    if (m_disconnected && !m_throttled && m_socket.bytesAvailable() == 0)
+    {
+        emit readingFinished();
+    }
+}
+
+void ReceiverWorker::finishReading()
+{
+    m_disconnected = true;
+    doRead();
+}
+
+void ReceiverWorker::notifyBuilder()
+{
+    if (m_unnotified == 0)
+        return;
+
+    if (m_ingest)
+        m_ingest->nodes_received += m_unnotified;
+
+    m_unnotified = 0;
+
+    /// pairs with the fence in BuilderShard::handleNodes: either the builder
+    /// sees the new nodes while draining, or we see that it is not notified
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    for (auto i = 0u; i < m_queues.size(); ++i)
+    {
+        if (m_queue_unnotified[i] == 0)
+            continue;
+
+        m_queue_unnotified[i] = 0;
+
+        if (!m_queues[i]->notified.exchange(true))
+        {
+            emit nodesAvailable(m_queues[i]);
         }
     }
 }
@@ -154,22 +330,38 @@ void ReceiverWorker::handleMessage(const Message &msg)
     {
     case cpprofiler::MsgType::NODE:
 
-        try
+    {
+        auto &queue = queueFor(msg.nodeUID().tid);
+
+        Message *slot;
+
+        /// the builder is falling behind: wait for it to free some slots
+        while (!(slot = queue.back()))
         {
-            /// NOTE(maxim): the messae will be deleted by the builder thread
-            auto node_msg = new Message{msg};
-            emit newNode(node_msg);
+            notifyBuilder();
+            utils::sleep_for_ms(1);
         }
-        catch (std::exception &e)
+
+        /// assignment reuses the memory of the slot's strings
+        *slot = msg;
+        queue.push();
+
+        ++m_queue_unnotified[queue.shard];
+
+        if (++m_unnotified >= NOTIFY_BATCH_SIZE)
         {
+            notifyBuilder();
         }
 
         break;
+    }
     case cpprofiler::MsgType::START:
         print("message: start");
+        notifyBuilder();
         handleStart(msg);
         break;
     case cpprofiler::MsgType::DONE:
+        notifyBuilder();
         emit doneReceiving();
         print("message: done");
         break;
@@ -2,11 +2,16 @@
 #define CPPROFILER_RECEIVER_WORKER_HH
 
 #include <QObject>
+#include <chrono>
 #include <memory>
+#include <vector>
 
 #include "../cpp-integration/message.hpp"
+#include "tree_builder.hh"
+#include "utils/byte_ring.hh"
 
-class QTcpSocket;
+class QIODevice;
+class QTimer;
 
 namespace cpprofiler
 {
@@ -15,20 +20,38 @@ class Conductor;
 class Execution;
 class Message;
 class Settings;
+class CaptureWriter;
+struct IngestStats;
 
 class ReceiverWorker : public QObject
 {
     Q_OBJECT
 
-    /// number of messages to read before resetting the buffer
-    static constexpr int MSG_PER_BUFFER = 10000;
+    /// initial capacity of the read buffer (grows only for larger messages)
+    static constexpr int BUFFER_SIZE = 1 << 22;
     /// the number of bytes per field size
     static constexpr int FIELD_SIZE_NBYTES = 4;
-
-    /// read buffer
-    QByteArray m_buffer;
-
-    QTcpSocket &m_socket;
+    /// the largest message accepted (a larger size means the stream is corrupt)
+    static constexpr int MAX_MESSAGE_SIZE = 1 << 27;
+    /// capacity of each queue of node messages for the builder
+    static constexpr int QUEUE_CAPACITY = 1 << 15;
+    /// number of node messages after which the builder is notified
+    static constexpr int NOTIFY_BATCH_SIZE = 1000;
+    /// stop reading from the socket when this many messages are queued...
+    static constexpr int HIGH_WATER_MARK = QUEUE_CAPACITY / 4 * 3;
+    /// ...and continue once the builder has brought it down to this many
+    static constexpr int LOW_WATER_MARK = QUEUE_CAPACITY / 4;
+    /// how often to check whether reading can continue (ms)
+    static constexpr int RESUME_INTERVAL = 2;
+
+    /// read buffer (the socket is read directly into it)
+    utils::ByteRing m_buffer;
+
+    /// a copy of the current message if it wraps around the end of `m_buffer`
+    std::vector<char> m_frame;
+
+    /// a TCP or a local socket
+    QIODevice &m_socket;
 
     struct ReadState
     {
@@ -36,12 +59,56 @@ class ReceiverWorker : public QObject
         bool size_read = false;
         // size of the current message in bytes
         int msg_size = 0;
-        /// messages processed since last buffer reset
-        int msg_processed = 0;
-        /// where to read next from in the buffer
-        int bytes_read = 0;
     } m_state;
 
+    /// read from the socket as much as fits into the buffer
+    void fillBuffer();
+
+    /// handle all complete messages in the buffer
+    void processMessages();
+
+    /// node messages for each builder shard (created on first use)
+    std::vector<std::shared_ptr<NodeQueue>> m_queues;
+
+    /// node messages pushed to each queue since the builder was last notified
+    std::vector<int> m_queue_unnotified;
+
+    /// node messages pushed since the builder was last notified
+    int m_unnotified = 0;
+
+    /// the queue for nodes of solver thread `tid`
+    NodeQueue &queueFor(int32_t tid);
+
+    /// tell the builder about new node messages (unless it already knows)
+    void notifyBuilder();
+
+    /// statistics of the current execution (set on its start)
+    IngestStats *m_ingest = nullptr;
+
+    /// whether reading is paused because the builder is falling behind
+    bool m_throttled = false;
+    /// when reading was paused
+    std::chrono::steady_clock::time_point m_throttled_since;
+    /// retries reading while throttled
+    QTimer *m_resume_timer;
+
+    /// whether the solver has closed the connection
+    bool m_disconnected = false;
+
+    /// whether an invalid message size was read (nothing is read after it)
+    bool m_failed = false;
+
+    /// give up on a corrupt stream: finish the execution with the nodes
+    /// received so far and close the connection
+    void abortReading();
+
+    /// records received messages (if enabled in settings)
+    std::unique_ptr<CaptureWriter> m_capture;
+
+    /// pause/resume reading depending on the queue depth;
+    /// returns whether reading is paused
+    bool throttle();
+
     // Execution* execution;
 
     cpprofiler::MessageMarshalling marshalling;
@@ -55,13 +122,25 @@ class ReceiverWorker : public QObject
   signals:
 
     void notifyStart(const std::string &ex_name, int ex_id, bool restarts);
-    void newNode(Message *node);
+    void nodesAvailable(std::shared_ptr<cpprofiler::NodeQueue> queue);
     void doneReceiving();
+    /// all messages have been read after the connection was closed
+    void readingFinished();
 
   public:
-    ReceiverWorker(QTcpSocket &socket, const Settings &s);
+    ReceiverWorker(QIODevice &socket, const Settings &s);
+
+    ~ReceiverWorker();
+
+    /// Report ingestion of the current execution to `stats` (must be called
+    /// while the worker's thread is blocked, e.g. during `notifyStart`)
+    void setIngestStats(IngestStats *stats);
+
   public slots:
     void doRead();
+
+    /// read whatever is left after the solver closed the connection
+    void finishReading();
 };
 
 } // namespace cpprofiler
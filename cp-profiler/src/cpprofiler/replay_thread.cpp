@@ -0,0 +1,74 @@
+#include "replay_thread.hh"
+#include "frame_capture.hh"
+
+#include "utils/debug.hh"
+#include "utils/perf_helper.hh"
+
+#include <QLocalSocket>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace cpprofiler
+{
+
+ReplayThread::ReplayThread(const std::string &path, const QString &server_name, bool realtime)
+    : m_path(path), m_server_name(server_name), m_realtime(realtime) {}
+
+void ReplayThread::run()
+{
+    CaptureReader reader(m_path);
+
+    if (!reader.isValid())
+    {
+        print("ERROR: not a capture file: {}", m_path);
+        return;
+    }
+
+    QLocalSocket socket;
+    socket.connectToServer(m_server_name);
+
+    if (!socket.waitForConnected())
+    {
+        print("ERROR: replay could not connect to the profiler: {}", socket.errorString().toStdString());
+        return;
+    }
+
+    perf_helper::Timer timer;
+    timer.begin();
+
+    const auto start = std::chrono::steady_clock::now();
+
+    int64_t time_us;
+    std::vector<char> frame;
+    int n_messages = 0;
+
+    /// (interrupted if the profiler stops before the end)
+    while (!isInterruptionRequested() && reader.next(time_us, frame))
+    {
+        if (m_realtime)
+        {
+            std::this_thread::sleep_until(start + std::chrono::microseconds(time_us));
+        }
+
+        const auto size = static_cast<int32_t>(frame.size());
+        socket.write(reinterpret_cast<const char *>(&size), sizeof(size));
+        socket.write(frame.data(), size);
+        ++n_messages;
+
+        /// let the receiver (and its flow control) set the pace
+        while (socket.bytesToWrite() > MAX_PENDING_BYTES)
+        {
+            socket.waitForBytesWritten();
+        }
+    }
+
+    while (socket.bytesToWrite() > 0 && socket.waitForBytesWritten())
+        ;
+
+    socket.disconnectFromServer();
+
+    print("replayed {} messages in {}ms", n_messages, timer.end());
+}
+
+} // namespace cpprofiler
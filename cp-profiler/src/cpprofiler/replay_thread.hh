@@ -0,0 +1,37 @@
+#ifndef CPPROFILER_REPLAY_THREAD_HH
+#define CPPROFILER_REPLAY_THREAD_HH
+
+#include <QString>
+#include <QThread>
+#include <string>
+
+namespace cpprofiler
+{
+
+/// Plays the part of a solver: sends the messages of a capture file to the
+/// profiler's local server, so that they go through the same receiver and
+/// builder as the original ones; stops early if interrupted
+/// (`QThread::requestInterruption`)
+class ReplayThread : public QThread
+{
+    Q_OBJECT
+
+    const std::string m_path;
+
+    const QString m_server_name;
+
+    /// whether to keep the recorded gaps between messages
+    const bool m_realtime;
+
+    /// maximum number of bytes waiting to be sent
+    static constexpr qint64 MAX_PENDING_BYTES = 1 << 20;
+
+    void run() override;
+
+  public:
+    ReplayThread(const std::string &path, const QString &server_name, bool realtime);
+};
+
+} // namespace cpprofiler
+
+#endif
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string>
+
 namespace cpprofiler
 {
 
@@ -9,6 +11,14 @@ public:
     /// delay in ms after receiving a new message
     int receiver_delay = 0;
     int auto_hide_failed = true;
+    /// most threads building a tree, each started once needed (0: one per core)
+    int builder_shards = 0;
+    /// record raw solver messages to this file (with a numeric suffix
+    /// added for every further connection); empty if not recording
+    std::string capture_path;
+    /// lay out trees with threaded contours (memory linear in the number
+    /// of nodes, however deep the tree) rather than per-node shapes
+    bool contour_layout = false;
 };
 
 } // namespace cpprofiler
@@ -1,77 +1,134 @@
 #include "solver_data.hh"
 
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
+#include "utils/json_scanner.hh"
 
 namespace cpprofiler
 {
 
-/// convert json array to std::vector
-static std::vector<int> parse_reasons_json(QJsonValue &json_arr)
+/// read the constraint ids from an array of `reasons`
+static void parse_reasons(utils::JsonScanner &scanner, std::vector<int> &res)
 {
-    std::vector<int> res;
-
-    auto arr = json_arr.toArray();
-
-    for (auto el : arr)
+    while (scanner.nextElement())
     {
-
-        if (el.isDouble())
+        int cid;
+        if (scanner.readInt(cid))
+        {
+            res.push_back(cid);
+        }
+        else
         {
-            res.push_back(el.toInt());
+            scanner.skipValue();
         }
     }
-
-    return res;
 }
 
-/// convert json array to std::vector
-static std::vector<SolverID> parse_nogoods_json(QJsonValue &json_arr)
+/// read solver ids from an array of `nogoods`
+static void parse_nogoods(utils::JsonScanner &scanner, std::vector<SolverID> &res)
 {
-    std::vector<SolverID> res;
+    while (scanner.nextElement())
+    {
+        if (!scanner.beginObject())
+        {
+            scanner.skipValue();
+            continue;
+        }
 
-    auto arr = json_arr.toArray();
+        /// object should be of the form {"nid":<>, "rid":<>, "tid":<>}
+        SolverID sid{-1, -1, -1};
+        int found = 0;
 
-    for (auto el : arr)
-    {
+        const char *key;
+        int len;
 
-        if (!el.isArray())
+        while (scanner.nextMember(key, len))
         {
-            const auto obj = el.toObject();
-            /// object should be of the form {"nid":<>, "rid":<>, "tid":<>}
+            int32_t *field = nullptr;
 
-            auto nid_obj = obj.value("nid");
-            auto rid_obj = obj.value("rid");
-            auto tid_obj = obj.value("tid");
+            if (utils::JsonScanner::keyIs(key, len, "nid"))
+                field = &sid.nid;
+            else if (utils::JsonScanner::keyIs(key, len, "rid"))
+                field = &sid.rid;
+            else if (utils::JsonScanner::keyIs(key, len, "tid"))
+                field = &sid.tid;
 
-            if (nid_obj.isDouble() && rid_obj.isDouble() && tid_obj.isDouble())
+            int value;
+            if (field && scanner.readInt(value))
+            {
+                *field = value;
+                ++found;
+            }
+            else
             {
+                scanner.skipValue();
+            }
+        }
+
+        if (found == 3)
+        {
+            res.push_back(sid);
+        }
+    }
+}
 
-                const auto nid = nid_obj.toInt();
-                const auto rid = rid_obj.toInt();
-                const auto tid = tid_obj.toInt();
+void SolverData::scanInfo(const std::string &info_str, ParsedInfo &res)
+{
+    /// Info is scanned in place: only `reasons` and `nogoods` are decoded,
+    /// the rest is kept as raw text until somebody asks for it
+    utils::JsonScanner scanner(info_str.data(), info_str.data() + info_str.size());
+
+    res.clear();
 
-                res.push_back({nid, rid, tid});
+    bool empty = true;
+
+    if (scanner.beginObject())
+    {
+        const char *key;
+        int len;
+
+        while (scanner.nextMember(key, len))
+        {
+            empty = false;
+
+            if (utils::JsonScanner::keyIs(key, len, "reasons") && scanner.beginArray())
+            {
+                res.has_reasons = true;
+                parse_reasons(scanner, res.constraints);
+            }
+            else if (utils::JsonScanner::keyIs(key, len, "nogoods") && scanner.beginArray())
+            {
+                res.has_nogoods = true;
+                parse_nogoods(scanner, res.nogoods);
+            }
+            else
+            {
+                scanner.skipValue();
             }
         }
     }
+    else if (scanner.skipValue())
+    {
+        empty = false;
+    }
 
-    return res;
+    if (!scanner.atEnd())
+    {
+        res.status = ParsedInfo::Status::Invalid;
+    }
+    else
+    {
+        res.status = empty ? ParsedInfo::Status::Empty : ParsedInfo::Status::Valid;
+    }
 }
 
-void SolverData::processInfo(NodeID nid, const std::string &info_str)
+void SolverData::storeInfo(NodeID nid, const std::string &info_str, ParsedInfo &parsed)
 {
-    auto info_bytes = QByteArray::fromStdString(info_str);
-    QJsonParseError json_err;
-    auto json_doc = QJsonDocument::fromJson(info_bytes, &json_err);
-
-    if (json_err.error != QJsonParseError::NoError) {
-        print("QJsonDocument::fromJson() error: {}\ninfo_str:\n {}\n", json_err.errorString(), info_str);
+    if (parsed.status == ParsedInfo::Status::Invalid)
+    {
+        print("could not parse info of node {}:\n {}\n", nid, info_str);
         return;
     }
 
-    if (json_doc.isNull() || json_doc.isEmpty())
+    if (parsed.status == ParsedInfo::Status::Empty)
     {
         print("no info for node {}", nid);
         return;
@@ -79,32 +136,21 @@ void SolverData::processInfo(NodeID nid, const std::string &info_str)
 
     setInfo(nid, info_str);
 
-    QJsonObject json_obj = json_doc.object();
-
-    if (json_obj.isEmpty())
+    if (parsed.has_reasons)
     {
-        return;
-    }
-
-    auto reasons = json_obj.value("reasons");
-    if (reasons.isArray())
-    {
-        auto constraints = parse_reasons_json(reasons);
         // print("constraints for {}: {}", nid, constraints);
-        contrib_cs_.insert({nid, std::move(constraints)});
+        contrib_cs_.insert({nid, std::move(parsed.constraints)});
     }
 
-    auto nogoods_json = json_obj.value("nogoods");
-    if (nogoods_json.isArray())
+    if (parsed.has_nogoods)
     {
-        auto nogoods = parse_nogoods_json(nogoods_json);
-
         /// Nogoods contributing to the failure at `nid`
         std::vector<NodeID> c_nogoods;
+        c_nogoods.reserve(parsed.nogoods.size());
 
-        for (const auto sid : nogoods)
+        for (const auto &sid : parsed.nogoods)
         {
-            auto ng_nid = getNodeId(sid);
+            const auto ng_nid = getNodeId(sid);
 
             if (ng_nid != NodeID::NoNode)
             {
@@ -118,28 +164,11 @@ void SolverData::processInfo(NodeID nid, const std::string &info_str)
     }
 }
 
-void IdMap::addPair(SolverID sid, tree::NodeID nid)
-{
-    QWriteLocker locker(&m_lock);
-
-    uid2id_.insert({sid, nid});
-    nid2uid_.insert({nid, sid});
-}
-
-tree::NodeID IdMap::get(SolverID sid) const
+void SolverData::processInfo(NodeID nid, const std::string &info_str)
 {
-    QReadLocker locker(&m_lock);
-
-    const auto it = uid2id_.find(sid);
-
-    if (it != uid2id_.end())
-    {
-        return it->second;
-    }
-    else
-    {
-        return NodeID::NoNode;
-    }
+    ParsedInfo parsed;
+    scanInfo(info_str, parsed);
+    storeInfo(nid, info_str, parsed);
 }
 
 } // namespace cpprofiler
\ No newline at end of file
@@ -1,10 +1,11 @@
 #pragma once
 
-#include <QReadWriteLock>
 #include <unordered_map>
 
 #include "core.hh"
 
+#include "id_map.hh"
+#include "utils/byte_arena.hh"
 #include "solver_id.hh"
 
 namespace cpprofiler
@@ -12,42 +13,53 @@ namespace cpprofiler
 
 class NameMap;
 
-class IdMap
+/// Reasons and contributing nogoods found in the info of a node
+struct ParsedInfo
 {
+    enum class Status
+    {
+        Valid,
+        /// no info at all
+        Empty,
+        /// not valid JSON
+        Invalid
+    };
 
-    mutable QReadWriteLock m_lock;
-
-    std::unordered_map<SolverID, NodeID> uid2id_;
+    Status status = Status::Empty;
 
-    std::unordered_map<NodeID, SolverID> nid2uid_;
+    bool has_reasons = false;
+    bool has_nogoods = false;
 
-  public:
-    void addPair(SolverID, NodeID);
+    /// constraint ids
+    std::vector<int> constraints;
+    /// solver ids of contributing nogoods (resolved when stored)
+    std::vector<SolverID> nogoods;
 
-    NodeID get(SolverID) const;
-
-    SolverID getUID(NodeID nid) const
+    void clear()
     {
-        auto it = nid2uid_.find(nid);
-
-        if (it != nid2uid_.end())
-        {
-            return nid2uid_.at(nid);
-        }
-        else
-        {
-            return {-1, -1, -1};
-        }
+        status = Status::Empty;
+        has_reasons = has_nogoods = false;
+        constraints.clear();
+        nogoods.clear();
     }
 };
 
 class SolverData
 {
 
-    /// TODO:save/load id map to/from DB
     IdMap m_id_map;
 
-    std::unordered_map<NodeID, Info> info_map_;
+    /// Raw info of a node (stored in `info_arena_`)
+    struct InfoRef
+    {
+        const char *data;
+        int size;
+    };
+
+    /// Raw info strings of all nodes, kept undecoded until asked for
+    utils::ByteArena info_arena_;
+
+    std::unordered_map<NodeID, InfoRef> info_map_;
 
     std::unordered_map<NodeID, Nogood> nogood_map_;
 
@@ -97,12 +109,7 @@ class SolverData
         return &(it->second);
     }
 
-    /// Associate nogood `ng` with node `nid`
-    void setNogood(NodeID nid, const std::string &orig, const std::string &renamed)
-    {
-        nogood_map_.insert({nid, Nogood(orig, renamed)});
-    }
-
+    /// Associate nogood `orig` with node `nid`
     void setNogood(NodeID nid, const std::string &orig)
     {
         nogood_map_.insert({nid, Nogood(orig)});
@@ -123,7 +130,8 @@ class SolverData
 
     void setInfo(NodeID nid, const std::string &orig)
     {
-        info_map_.insert({nid, Info(orig)});
+        const auto data = info_arena_.append(orig.data(), orig.size());
+        info_map_.insert({nid, InfoRef{data, static_cast<int>(orig.size())}});
     }
 
     Info getInfo(NodeID nid) const
@@ -131,7 +139,7 @@ class SolverData
         auto it = info_map_.find(nid);
         if (it != info_map_.end())
         {
-            return it->second;
+            return Info(it->second.data, it->second.size);
         }
         else
         {
@@ -142,6 +150,14 @@ class SolverData
     /// Process node info looking for reasons, contributing nogoods for failed nodes etc.
     void processInfo(NodeID nid, const std::string &info_str);
 
+    /// The first half of `processInfo`: only reads `info_str`, so (unlike
+    /// storing the result) it can run concurrently with other modifications
+    static void scanInfo(const std::string &info_str, ParsedInfo &res);
+
+    /// The second half of `processInfo`: store the info of node `nid`
+    /// scanned into `parsed` (whose contents may be moved from)
+    void storeInfo(NodeID nid, const std::string &info_str, ParsedInfo &parsed);
+
     /// Whether the data stores at least one no-good
     bool hasNogoods() const
     {
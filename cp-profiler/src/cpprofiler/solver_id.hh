@@ -1,3 +1,8 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
 namespace cpprofiler
 {
 
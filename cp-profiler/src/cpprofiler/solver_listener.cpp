@@ -0,0 +1,182 @@
+#include "solver_listener.hh"
+
+#include "execution.hh"
+#include "local_server.hh"
+#include "receiver_thread.hh"
+#include "replay_thread.hh"
+#include "tcp_server.hh"
+#include "tree_builder.hh"
+
+#include "utils/debug.hh"
+
+#include <QCoreApplication>
+#include <QThread>
+#include <algorithm>
+#include <iostream>
+
+namespace cpprofiler
+{
+
+constexpr quint16 SolverListener::DEFAULT_PORT;
+
+SolverListener::SolverListener(const Settings &settings, StartHandler on_start)
+    : settings_(settings), on_start_(std::move(on_start))
+{
+    server_.reset(new TcpServer([this](intptr_t socketDesc) {
+        startReceiver(socketDesc, Transport::Tcp);
+    }));
+
+    listen_port_ = DEFAULT_PORT;
+
+    // See if the default port is available
+    if (!server_->listen(QHostAddress::Any, listen_port_))
+    {
+        // If not, try any port
+        server_->listen(QHostAddress::Any, 0);
+        listen_port_ = server_->serverPort();
+    }
+
+    std::cerr << "Ready to listen on: " << listen_port_ << std::endl;
+
+    /// Solvers on the same machine can avoid the loopback TCP overhead
+    local_server_.reset(new LocalServer([this](intptr_t socketDesc) {
+        startReceiver(socketDesc, Transport::Local);
+    }));
+
+    const auto local_name = QString("cpprofiler-%1").arg(QCoreApplication::applicationPid());
+
+    /// a stale socket file could be left by a crashed instance
+    QLocalServer::removeServer(local_name);
+
+    if (local_server_->listen(local_name))
+    {
+        std::cerr << "Ready to listen on: " << local_server_->fullServerName().toStdString() << std::endl;
+    }
+    else
+    {
+        print("could not start local server: {}", local_server_->errorString().toStdString());
+    }
+}
+
+SolverListener::~SolverListener()
+{
+    stop();
+
+    for (auto &entry : builder_threads_)
+    {
+        delete entry.first;
+        delete entry.second;
+    }
+}
+
+QString SolverListener::localServerName() const
+{
+    if (!local_server_->isListening())
+        return QString();
+
+    return local_server_->fullServerName();
+}
+
+void SolverListener::addIoThread(QThread *thread)
+{
+    /// forget the threads deleted since
+    io_threads_.erase(std::remove_if(io_threads_.begin(), io_threads_.end(),
+                                     [](const QPointer<QThread> &t) { return t.isNull(); }),
+                      io_threads_.end());
+
+    io_threads_.push_back(thread);
+}
+
+void SolverListener::replayCapture(const std::string &path, bool realtime)
+{
+    const auto server_name = localServerName();
+
+    if (server_name.isEmpty())
+    {
+        print("ERROR: cannot replay {}: local server is not running", path);
+        return;
+    }
+
+    auto replay = new ReplayThread(path, server_name, realtime);
+    connect(replay, &QThread::finished, replay, &QObject::deleteLater);
+    addIoThread(replay);
+    replay->start();
+}
+
+void SolverListener::startReceiver(intptr_t socketDesc, Transport transport)
+{
+    /// Initiate a receiver thread
+    auto receiver = new ReceiverThread(socketDesc, settings_, transport);
+    /// Delete the receiver once the thread is finished
+    connect(receiver, &QThread::finished, receiver, &QObject::deleteLater);
+    /// Handle the start message on the listener's thread
+    connect(receiver, &ReceiverThread::notifyStart, this, [this, receiver](const std::string &ex_name, int ex_id, bool restarts) {
+        on_start_(receiver, ex_name, ex_id, restarts);
+    });
+
+    addIoThread(receiver);
+    receiver->start();
+}
+
+TreeBuilder *SolverListener::startBuilder(Execution &ex, int ex_id)
+{
+    auto builderThread = new QThread();
+    auto builder = new TreeBuilder(ex, TreeBuilder::shardCount(settings_));
+
+    builders_[ex_id] = builder;
+    builder_threads_.push_back({builder, builderThread});
+    builder->moveToThread(builderThread);
+
+    builderThread->start();
+
+    return builder;
+}
+
+void SolverListener::attachReceiver(ReceiverThread *receiver, Execution &ex, int ex_id)
+{
+    /// safe: the receiver is blocked until the start handler returns
+    receiver->setIngestStats(&ex.ingestStats());
+
+    const auto it = builders_.find(ex_id);
+
+    if (it == builders_.end())
+    {
+        print("ERROR: no builder for execution {}: ignoring its solver", ex_id);
+        return;
+    }
+
+    auto builder = it->second;
+
+    connect(receiver, &ReceiverThread::nodesAvailable,
+            builder, &TreeBuilder::handleNodes);
+
+    connect(receiver, &ReceiverThread::doneReceiving,
+            builder, &TreeBuilder::finishBuilding);
+}
+
+void SolverListener::stop()
+{
+    server_->close();
+    local_server_->close();
+
+    /// receivers first: they pass nodes on to the builders
+    for (auto &thread : io_threads_)
+    {
+        if (!thread)
+            continue;
+
+        thread->requestInterruption();
+        thread->quit();
+        thread->wait();
+    }
+
+    io_threads_.clear();
+
+    for (auto &entry : builder_threads_)
+    {
+        entry.second->quit();
+        entry.second->wait();
+    }
+}
+
+} // namespace cpprofiler
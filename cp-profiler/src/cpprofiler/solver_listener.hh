@@ -0,0 +1,104 @@
+#ifndef CPPROFILER_SOLVER_LISTENER_HH
+#define CPPROFILER_SOLVER_LISTENER_HH
+
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class QThread;
+
+namespace cpprofiler
+{
+
+class Execution;
+class LocalServer;
+class ReceiverThread;
+class Settings;
+class TcpServer;
+class TreeBuilder;
+enum class Transport;
+
+/// Accepts solvers (over TCP and, on the same machine, the local socket) and
+/// feeds their messages to the builders of their executions; used by both
+/// `Conductor` and `HeadlessConductor`, which decide how executions are
+/// created and what happens to them once built
+class SolverListener : public QObject
+{
+    Q_OBJECT
+
+  public:
+    /// Called (on the listener's thread) when a solver starts an execution;
+    /// expected to end with `attachReceiver`
+    using StartHandler = std::function<void(ReceiverThread *receiver, const std::string &ex_name,
+                                            int ex_id, bool restarts)>;
+
+  private:
+    const Settings &settings_;
+
+    StartHandler on_start_;
+
+    /// Port number opened for solvers to connect to
+    quint16 listen_port_;
+
+    std::unique_ptr<TcpServer> server_;
+
+    std::unique_ptr<LocalServer> local_server_;
+
+    /// a map from execution id to its builder
+    std::unordered_map<int, TreeBuilder *> builders_;
+
+    /// every builder created so far along with its thread
+    std::vector<std::pair<TreeBuilder *, QThread *>> builder_threads_;
+
+    /// receiver and replay threads (null once they have finished and
+    /// been deleted)
+    std::vector<QPointer<QThread>> io_threads_;
+
+    static constexpr quint16 DEFAULT_PORT = 6565;
+
+    /// Start receiving from a newly connected solver
+    void startReceiver(intptr_t socketDesc, Transport transport);
+
+    /// Keep track of `thread` (a receiver or a replay) until it is deleted
+    void addIoThread(QThread *thread);
+
+  public:
+    /// Start listening; `settings` must outlive the listener
+    SolverListener(const Settings &settings, StartHandler on_start);
+
+    /// Stops (see `stop`) and deletes the builders
+    ~SolverListener();
+
+    quint16 listenPort() const { return listen_port_; }
+
+    /// Name that solvers on this machine can connect to instead of the
+    /// TCP port (empty if the local server could not be started)
+    QString localServerName() const;
+
+    /// Feed messages recorded in a capture file through the local server
+    /// (either at the recorded speed or as fast as possible)
+    void replayCapture(const std::string &path, bool realtime);
+
+    /// Create the builder of execution `ex` (with id `ex_id`) and start
+    /// its thread
+    TreeBuilder *startBuilder(Execution &ex, int ex_id);
+
+    /// Feed the messages of `receiver` to the builder of execution `ex`
+    /// (created by `startBuilder` for this or another connection)
+    void attachReceiver(ReceiverThread *receiver, Execution &ex, int ex_id);
+
+    /// Stop accepting solvers, wait for the receivers and replays to finish
+    /// (interrupting them) and stop the builders' threads
+    void stop();
+};
+
+} // namespace cpprofiler
+
+#endif
@@ -2,6 +2,7 @@
 #include <QLabel>
 #include <thread>
 
+#include "execution.hh"
 #include "tree/node_tree.hh"
 #include "tree/node_widget.hh"
 
@@ -12,6 +13,7 @@ class NodeStatsBar : public QWidget
 {
 
     const tree::NodeStats &stats;
+    const IngestStats &ingest;
     /// Status bar label for maximum depth indicator
     QLabel *depthLabel;
     /// Status bar label for number of solutions
@@ -24,9 +26,18 @@ class NodeStatsBar : public QWidget
     QLabel *choicesLabel;
     /// Status bar label for number of open nodes
     QLabel *openLabel;
+    /// Status bar label for the number of node messages waiting for the builder
+    QLabel *queueLabel;
+
+    /// Queue depth currently shown
+    int shownQueueDepth = -1;
+
+    /// Whether the stats changed since the labels were last updated
+    bool outdated_ = true;
 
   public:
-    NodeStatsBar(QWidget *parent, const tree::NodeStats &ns) : QWidget(parent), stats(ns)
+    NodeStatsBar(QWidget *parent, const tree::NodeStats &ns, const IngestStats &is)
+        : QWidget(parent), stats(ns), ingest(is)
     {
 
         using namespace tree;
@@ -57,12 +68,30 @@ class NodeStatsBar : public QWidget
         openLabel = new QLabel("0");
         hbl->addWidget(new NodeWidget(NodeStatus::UNDETERMINED));
         hbl->addWidget(openLabel);
+
+        hbl->addWidget(new QLabel("Queue:"));
+        queueLabel = new QLabel("0");
+        queueLabel->setToolTip("Node messages received but not yet added to the tree");
+        hbl->addWidget(queueLabel);
     }
 
   public slots:
 
+    /// Note that the stats have changed (once per node or per batch of nodes)
+    void setOutdated()
+    {
+        outdated_ = true;
+    }
+
     void update()
     {
+        updateQueueDepth();
+
+        if (!outdated_)
+            return;
+
+        outdated_ = false;
+
         depthLabel->setNum(stats.maxDepth());
         openLabel->setNum(stats.undeterminedCount());
         solvedLabel->setNum(stats.solvedCount());
@@ -70,6 +99,22 @@ class NodeStatsBar : public QWidget
         skippedLabel->setNum(stats.skippedCount());
         choicesLabel->setNum(stats.branchCount());
     }
+
+    /// Show the queue depth (in red when the builder is falling behind)
+    void updateQueueDepth()
+    {
+        const int depth = ingest.queue_depth;
+
+        if (depth == shownQueueDepth)
+            return;
+
+        shownQueueDepth = depth;
+
+        queueLabel->setNum(depth);
+
+        const bool behind = 2 * depth > ingest.queue_capacity;
+        queueLabel->setStyleSheet(behind ? "color: red" : "");
+    }
 };
 
 } // namespace cpprofiler
\ No newline at end of file
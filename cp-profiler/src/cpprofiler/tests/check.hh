@@ -0,0 +1,25 @@
+#ifndef CPPROFILER_TESTS_CHECK_HH
+#define CPPROFILER_TESTS_CHECK_HH
+
+#include "../utils/debug.hh"
+
+#include <cstdlib>
+
+namespace cpprofiler
+{
+namespace tests
+{
+
+inline void check_failed(const char *cond, const char *file, int line)
+{
+    print("check failed: {} ({}:{})", cond, file, line);
+    std::abort();
+}
+
+} // namespace tests
+} // namespace cpprofiler
+
+/// Like `assert`, but also checked in release (NDEBUG) builds
+#define CHECK(cond) ((cond) ? (void)0 : cpprofiler::tests::check_failed(#cond, __FILE__, __LINE__))
+
+#endif
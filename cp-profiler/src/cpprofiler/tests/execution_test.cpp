@@ -368,7 +368,7 @@ void restart_tree(Conductor &c)
 
     auto &tree = ex->tree();
 
-    utils::MutexLocker locker(&tree.treeMutex());
+    utils::MutexLocker locker(&tree.treeMutex(), "test: restarts");
 
     auto root = tree.createRoot(0);
 
@@ -424,12 +424,12 @@ static void db_create_tree(Conductor &c)
     auto ex = c.addNewExecution("Created as in DB");
     auto &tree = ex->tree();
 
-    tree.db_initialize(100);
+    tree.applyBatch([&tree]() {
+        tree.db_createRoot(NodeID{0});
 
-    tree.db_createRoot(NodeID{0});
-
-    tree.db_addChild(NodeID{1}, NodeID{0}, 0, tree::NodeStatus::BRANCH, "a");
-    tree.db_addChild(NodeID{2}, NodeID{0}, 1, tree::NodeStatus::BRANCH, "b");
+        tree.db_addChild(NodeID{1}, NodeID{0}, 0, tree::NodeStatus::BRANCH, "a");
+        tree.db_addChild(NodeID{2}, NodeID{0}, 1, tree::NodeStatus::BRANCH, "b");
+    });
 }
 
 static void save_search(Conductor &c)
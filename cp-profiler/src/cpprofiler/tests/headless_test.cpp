@@ -0,0 +1,105 @@
+#include "headless_test.hh"
+
+#include "../headless_conductor.hh"
+#include "../frame_capture.hh"
+#include "../options.hh"
+#include "../../cpp-integration/message.hpp"
+
+#include "check.hh"
+
+#include <QCoreApplication>
+#include <QTimer>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace cpprofiler
+{
+namespace tests
+{
+namespace headless_test
+{
+
+/// How long an execution may take before the test gives up
+static constexpr int TIMEOUT_MS = 30000;
+
+/// A replayed execution is saved without any windows, after which the
+/// conductor leaves the event loop (having stopped its threads)
+void replayed_execution()
+{
+    const char *capture_file = "headless_test_capture.bin";
+    const char *search_file = "headless_test_search.txt";
+
+    {
+        CaptureWriter writer(capture_file);
+        CHECK(writer.isOpen());
+
+        MessageMarshalling marshalling;
+
+        auto record = [&]() {
+            const auto buffer = marshalling.serialize();
+            writer.write(buffer.data(), static_cast<int32_t>(buffer.size()));
+        };
+
+        marshalling.makeStart("{\"name\": \"headless\", \"has_restarts\": false, \"execution_id\": 7}");
+        record();
+        marshalling.makeNode({0, 0, 0}, {-1, 0, 0}, 0, 2, BRANCH);
+        record();
+        marshalling.makeNode({1, 0, 0}, {0, 0, 0}, 0, 0, SOLVED);
+        record();
+        marshalling.makeNode({2, 0, 0}, {0, 0, 0}, 1, 0, FAILED);
+        record();
+        marshalling.makeDone();
+        record();
+    }
+
+    Options options;
+    options.replay_path = capture_file;
+    options.replay_fast = true;
+    options.save_search_path = search_file;
+
+    bool timed_out = false;
+
+    {
+        HeadlessConductor conductor(options);
+
+        QTimer timeout;
+        timeout.setSingleShot(true);
+        QObject::connect(&timeout, &QTimer::timeout, [&timed_out]() {
+            timed_out = true;
+            QCoreApplication::quit();
+        });
+        timeout.start(TIMEOUT_MS);
+
+        QCoreApplication::exec();
+    }
+
+    CHECK(!timed_out);
+
+    /// one line per (solved or failed) node
+    {
+        std::ifstream search(search_file);
+        CHECK(search.is_open());
+
+        int lines = 0;
+        for (std::string line; std::getline(search, line);)
+        {
+            ++lines;
+        }
+
+        CHECK(lines == 3);
+    }
+
+    std::remove(capture_file);
+    std::remove(search_file);
+}
+
+void run()
+{
+    replayed_execution();
+}
+
+} // namespace headless_test
+} // namespace tests
+} // namespace cpprofiler
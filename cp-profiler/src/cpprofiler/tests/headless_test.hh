@@ -0,0 +1,21 @@
+#ifndef CPPROFILER_TESTS_HEADLESS_TEST_HH
+#define CPPROFILER_TESTS_HEADLESS_TEST_HH
+
+namespace cpprofiler
+{
+
+namespace tests
+{
+
+/// Runs a `HeadlessConductor` (needs a `QCoreApplication`, whose event
+/// loop it enters)
+namespace headless_test
+{
+void run();
+}
+
+} // namespace tests
+
+} // namespace cpprofiler
+
+#endif
@@ -0,0 +1,125 @@
+#include "tree_bench.hh"
+
+#include "../tree/node_tree.hh"
+#include "../tree/structure.hh"
+#include "../tree/shape.hh"
+#include "../tree/extent_kernels.hh"
+
+#include "../utils/debug.hh"
+#include "../utils/perf_helper.hh"
+
+#include <random>
+
+namespace cpprofiler
+{
+namespace tests
+{
+namespace tree_bench
+{
+
+/// Building a chain should take linear time (node depth
+/// used to be recomputed by walking up to the root)
+void deep_chain()
+{
+
+    const int n = 1000000;
+
+    perf_helper::Timer timer;
+    timer.begin();
+
+    tree::NodeTree nt;
+    auto nid = nt.createRoot(1);
+
+    for (auto i = 0; i < n; ++i)
+    {
+        nid = nt.promoteNode(nid, 0, 1, tree::NodeStatus::BRANCH);
+    }
+
+    const auto ms = timer.end();
+    print("deep chain of {} nodes (depth {}) built in {}ms", nt.nodeCount(), nt.depth(), ms);
+}
+
+/// Memory used by two child lists that keep moving past each other in the arena
+void wide_children()
+{
+    tree::Structure str;
+
+    auto root = str.createRoot(2);
+    auto left = str.getChild(root, 0);
+    auto right = str.getChild(root, 1);
+
+    const int kids = 100000;
+
+    for (auto i = 0; i < kids; ++i)
+    {
+        str.addExtraChild(left);
+        str.addExtraChild(right);
+    }
+
+    print("wide children: structure uses {} bytes per node", str.bytesPerNode());
+}
+
+/// Distance between the right contour of one deep shape
+/// and the left contour of another, for every kernel available
+void extent_kernels()
+{
+    namespace ek = tree::extent_kernels;
+
+    const auto best = ek::best_isa();
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> values(-1000, 1000);
+
+    const auto height = 100000;
+    const auto repeats = 2000;
+
+    tree::Shape s1(height), s2(height);
+    for (auto depth = 0; depth < height; ++depth)
+    {
+        const auto w = values(rng) & 0xFF;
+        s1.setExtent(depth, {-w, w});
+        s2.setExtent(depth, {-w - 1, w + 1});
+    }
+
+    int64_t scalar_ms = 0;
+
+    for (const auto isa : {ek::Isa::Scalar, ek::Isa::SSE41, ek::Isa::AVX2})
+    {
+        if (!ek::supported(isa))
+            continue;
+
+        ek::use_isa(isa);
+
+        perf_helper::Timer timer;
+        timer.begin();
+
+        auto total = 0ll;
+        for (auto i = 0; i < repeats; ++i)
+        {
+            total += ek::max_difference(s1.rights(), s2.lefts(), height - i);
+        }
+
+        const auto ms = timer.end();
+        if (isa == ek::Isa::Scalar)
+            scalar_ms = ms;
+
+        print("{} distance kernel: {}ms for {} shapes of height {} (checksum {}, speedup {})", ek::isa_name(isa), ms,
+              repeats, height, total, ms > 0 ? static_cast<double>(scalar_ms) / ms : 0.0);
+    }
+
+    ek::use_isa(best);
+}
+
+void run()
+{
+
+    deep_chain();
+
+    wide_children();
+
+    extent_kernels();
+}
+
+} // namespace tree_bench
+} // namespace tests
+} // namespace cpprofiler
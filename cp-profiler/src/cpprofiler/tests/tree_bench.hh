@@ -0,0 +1,20 @@
+#ifndef CPPROFILER_TESTS_TREE_BENCH_HH
+#define CPPROFILER_TESTS_TREE_BENCH_HH
+
+namespace cpprofiler
+{
+
+namespace tests
+{
+
+/// Timings and memory figures (built separately from the tests: see tree_bench.pro)
+namespace tree_bench
+{
+void run();
+}
+
+} // namespace tests
+
+} // namespace cpprofiler
+
+#endif
@@ -1,10 +1,33 @@
 #include "../tree/node_tree.hh"
 #include "../tree/structure.hh"
+#include "../tree/node_info.hh"
+#include "../tree/shape_pool.hh"
+#include "../tree/extent_kernels.hh"
+#include "../tree/layout.hh"
+#include "../tree/layout_computer.hh"
+#include "../tree/visual_flags.hh"
+#include "../id_map.hh"
+#include "../solver_data.hh"
+#include "../name_map.hh"
+#include "../frame_capture.hh"
+#include "../execution.hh"
+#include "../tree_builder.hh"
 
 #include "../utils/array.hh"
+#include "../utils/byte_ring.hh"
+#include "../utils/spsc_queue.hh"
+#include "../utils/task_pool.hh"
 #include "../utils/debug.hh"
 
-#include <cassert>
+#include "check.hh"
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <thread>
 
 namespace cpprofiler
 {
@@ -78,18 +101,1451 @@ void growing_tree()
 
     auto n1 = str.addExtraChild(root);
 
-    assert(n1 == str.getChild(root, 0));
+    CHECK(n1 == str.getChild(root, 0));
 
     auto n2 = str.addExtraChild(root);
 
-    assert(n1 == str.getChild(root, 0));
-    assert(n2 == str.getChild(root, 1));
+    CHECK(n1 == str.getChild(root, 0));
+    CHECK(n2 == str.getChild(root, 1));
+
+    auto n3 = str.addExtraChild(root);
+
+    CHECK(n1 == str.getChild(root, 0));
+    CHECK(n2 == str.getChild(root, 1));
+    CHECK(n3 == str.getChild(root, 2));
+}
+
+void interleaved_children()
+{
+
+    tree::Structure str;
+
+    auto root = str.createRoot(0);
+
+    auto n1 = str.addExtraChild(root);
+    str.addChildren(n1, 2);
+
+    /// root's children are no longer consecutive nodes
+    auto n2 = str.addExtraChild(root);
+    str.addChildren(n2, 3);
 
     auto n3 = str.addExtraChild(root);
 
-    assert(n1 == str.getChild(root, 0));
-    assert(n2 == str.getChild(root, 1));
-    assert(n3 == str.getChild(root, 2));
+    CHECK(str.childrenCount(root) == 3);
+    CHECK(n1 == str.getChild(root, 0));
+    CHECK(n2 == str.getChild(root, 1));
+    CHECK(n3 == str.getChild(root, 2));
+    CHECK(str.getAlternative(n3) == 2);
+    CHECK(str.getParent(n3) == root);
+
+    CHECK(str.childrenCount(n2) == 3);
+    for (auto alt = 0; alt < 3; ++alt)
+    {
+        const auto kid = str.getChild(n2, alt);
+        CHECK(str.getParent(kid) == n2);
+        CHECK(str.getAlternative(kid) == alt);
+    }
+}
+
+void wide_children()
+{
+    tree::Structure str;
+
+    auto root = str.createRoot(2);
+    auto left = str.getChild(root, 0);
+    auto right = str.getChild(root, 1);
+
+    const int kids = 100000;
+
+    /// the two child lists keep moving past each other in the arena
+    for (auto i = 0; i < kids; ++i)
+    {
+        str.addExtraChild(left);
+        str.addExtraChild(right);
+    }
+
+    CHECK(str.childrenCount(left) == kids && str.childrenCount(right) == kids);
+
+    for (auto alt = 0; alt < kids; ++alt)
+    {
+        const auto kid = str.getChild(right, alt);
+        CHECK(str.getParent(kid) == right);
+        CHECK(str.getAlternative(kid) == alt);
+    }
+
+    /// with geometric growth the arena holds a few times the children at most
+    CHECK(str.bytesPerNode() < 64);
+}
+
+void removing_children()
+{
+
+    tree::Structure str;
+
+    auto root = str.createRoot(3);
+
+    auto n0 = str.getChild(root, 0);
+    auto n2 = str.getChild(root, 2);
+
+    str.removeChild(root, 1);
+
+    CHECK(str.childrenCount(root) == 2);
+    CHECK(n0 == str.getChild(root, 0));
+    CHECK(n2 == str.getChild(root, 1));
+    CHECK(str.getAlternative(n2) == 1);
+
+    str.removeChild(root, 0);
+
+    CHECK(str.childrenCount(root) == 1);
+    CHECK(n2 == str.getChild(root, 0));
+    CHECK(str.getAlternative(n2) == 0);
+
+    /// a reader walking the children while they are removed (and added)
+    /// sees children of the node only
+    tree::Structure wide;
+    const auto top = wide.createRoot(2000);
+
+    std::atomic<bool> removing{true};
+
+    std::thread reader([&]() {
+        while (removing)
+        {
+            const auto kids = wide.childrenCount(top);
+
+            for (auto alt = 0; alt < kids; ++alt)
+            {
+                try
+                {
+                    const auto kid = wide.getChild(top, alt);
+                    CHECK(wide.getParent(kid) == top);
+                    CHECK(wide.getAlternative(kid) >= 0);
+                }
+                catch (const tree::no_child &)
+                {
+                    /// removed since the children were counted
+                    break;
+                }
+            }
+        }
+    });
+
+    for (auto i = 0; i < 1500; ++i)
+    {
+        wide.removeChild(top, i % wide.childrenCount(top));
+
+        if (i % 3 == 0)
+            wide.addExtraChild(top);
+    }
+
+    removing = false;
+    reader.join();
+
+    CHECK(wide.childrenCount(top) == 1000);
+
+    for (auto alt = 0; alt < 1000; ++alt)
+    {
+        CHECK(wide.getAlternative(wide.getChild(top, alt)) == alt);
+    }
+}
+
+void node_info_bulk()
+{
+
+    tree::NodeInfo info;
+
+    /// 21 nodes: every third one failed, the rest branch nodes
+    const int n = 21;
+    for (auto i = 0; i < n; ++i)
+    {
+        const auto nid = NodeID{i};
+        info.addEntry(nid);
+        info.setStatus(nid, i % 3 == 0 ? tree::NodeStatus::FAILED : tree::NodeStatus::BRANCH);
+    }
+
+    info.setHasSolvedChildren(NodeID{4}, true);
+    info.setHasSolvedChildren(NodeID{17}, true);
+
+    const auto failed = info.nodesWithStatus(tree::NodeStatus::FAILED);
+    CHECK(failed.size() == 7);
+    CHECK(failed.back() == NodeID{18});
+
+    /// flags and statuses share the same byte
+    CHECK(info.getStatus(NodeID{17}) == tree::NodeStatus::BRANCH);
+    CHECK(info.hasOpenChildren(NodeID{17}));
+
+    info.setHasOpenChildren(NodeID{17}, false);
+    CHECK(!info.hasOpenChildren(NodeID{17}));
+    CHECK(info.hasSolvedChildren(NodeID{17}));
+    CHECK(info.getStatus(NodeID{17}) == tree::NodeStatus::BRANCH);
+
+    const auto branch = info.nodesWithStatus(tree::NodeStatus::BRANCH);
+    CHECK(branch.size() == 14);
+    CHECK(branch.front() == NodeID{1});
+}
+
+void interned_labels()
+{
+
+    tree::NodeTree nt;
+
+    const auto root = nt.createRoot(3, "root");
+    nt.promoteNode(root, 0, 0, tree::NodeStatus::FAILED, "x[17]<=4");
+    nt.promoteNode(root, 1, 0, tree::NodeStatus::FAILED, "x[17]>4");
+    nt.promoteNode(root, 2, 0, tree::NodeStatus::SOLVED, "x[17]<=4");
+
+    const auto kid0 = nt.getChild(root, 0);
+    const auto kid1 = nt.getChild(root, 1);
+    const auto kid2 = nt.getChild(root, 2);
+
+    /// equal labels are stored once
+    CHECK(nt.getLabelId(kid0) == nt.getLabelId(kid2));
+    CHECK(nt.getLabelId(kid0) != nt.getLabelId(kid1));
+    CHECK(nt.labelPool().size() == 4);
+
+    /// labels are returned by reference into the pool
+    CHECK(&nt.getLabel(kid0) == &nt.getLabel(kid2));
+    CHECK(nt.getLabel(kid1) == "x[17]>4");
+
+    tree::NodeTree nt2;
+    nt2.createRoot(0);
+    CHECK(nt2.getLabelId(nt2.getRoot()) == tree::LabelPool::EMPTY);
+    CHECK(nt2.getLabel(nt2.getRoot()).empty());
+}
+
+static tree::ShapeUniqPtr make_shape(std::initializer_list<tree::Extent> extents, tree::BoundingBox bb)
+{
+    tree::ShapeUniqPtr shape(new tree::Shape(static_cast<int>(extents.size())));
+
+    auto depth = 0;
+    for (const auto &extent : extents)
+    {
+        shape->setExtent(depth++, extent);
+    }
+    shape->setBoundingBox(bb);
+
+    return shape;
+}
+
+void interned_shapes()
+{
+    tree::ShapePool pool;
+
+    auto a = pool.intern(make_shape({{-10, 10}, {-20, 20}}, {-20, 20}));
+    auto b = pool.intern(make_shape({{-10, 10}, {-20, 20}}, {-20, 20}));
+    auto c = pool.intern(make_shape({{-10, 10}, {-20, 25}}, {-20, 25}));
+
+    /// equal shapes are stored once
+    CHECK(a.get() == b.get());
+    CHECK(a.get() != c.get());
+    CHECK(pool.size() == 2);
+    CHECK((*c.get())[1].r == 25);
+
+    /// the shared leaf shape is copied rather than taken over
+    auto leaf = pool.intern(tree::ShapeUniqPtr(&tree::Shape::leaf));
+    CHECK(leaf.get() != &tree::Shape::leaf);
+    CHECK(tree::Shape::leaf.height() == 1);
+    CHECK(pool.size() == 3);
+
+    /// shapes are freed with their last handle (and their entries reused)
+    a.reset();
+    CHECK(pool.size() == 3);
+    b = std::move(c);
+    CHECK(pool.size() == 2);
+
+    auto d = pool.intern(make_shape({{-10, 10}, {-20, 20}}, {-20, 20}));
+    CHECK(d.get() != b.get());
+    CHECK(pool.size() == 3);
+}
+
+/// Every kernel available on this CPU must agree with the scalar one
+/// (including the tails left over by the vector loops)
+void extent_kernels()
+{
+    namespace ek = tree::extent_kernels;
+
+    const auto best = ek::best_isa();
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> values(-1000, 1000);
+
+    for (auto n = 0; n <= 40; ++n)
+    {
+        std::vector<int> a(n), b(n);
+        for (auto i = 0; i < n; ++i)
+        {
+            a[i] = values(rng);
+            b[i] = values(rng);
+        }
+
+        auto max = INT_MIN;
+        for (auto i = 0; i < n; ++i)
+        {
+            max = std::max(max, a[i] - b[i]);
+        }
+
+        for (const auto isa : {ek::Isa::Scalar, ek::Isa::SSE41, ek::Isa::AVX2})
+        {
+            if (!ek::supported(isa))
+                continue;
+
+            ek::use_isa(isa);
+            CHECK(ek::current_isa() == isa);
+
+            CHECK(ek::max_difference(a.data(), b.data(), n) == max);
+
+            std::vector<int> dst(n);
+            ek::shifted_copy(a.data(), 7, dst.data(), n);
+            for (auto i = 0; i < n; ++i)
+                CHECK(dst[i] == a[i] + 7);
+
+            auto lo = b, hi = b;
+            ek::min_shifted(lo.data(), a.data(), -3, n);
+            ek::max_shifted(hi.data(), a.data(), -3, n);
+            for (auto i = 0; i < n; ++i)
+            {
+                CHECK(lo[i] == std::min(b[i], a[i] - 3));
+                CHECK(hi[i] == std::max(b[i], a[i] - 3));
+            }
+
+            /// a mismatch at every position (in either array)
+            CHECK(ek::first_mismatch(a.data(), b.data(), a.data(), b.data(), n) == n);
+            for (auto i = 0; i < n; ++i)
+            {
+                auto c = a, d = b;
+                c[i] += 1;
+                d[i] += 1;
+                CHECK(ek::first_mismatch(a.data(), b.data(), c.data(), b.data(), n) == i);
+                CHECK(ek::first_mismatch(a.data(), b.data(), a.data(), d.data(), n) == i);
+            }
+        }
+    }
+
+    ek::use_isa(best);
+}
+
+/// Laying out with threaded contours must place every node where laying
+/// out with shapes does: binary (rounded) and n-ary nodes, with and without
+/// labels shown, hidden subtrees and lanterns
+void contour_layout()
+{
+    tree::NodeTree nt;
+    const auto root = nt.createRoot(3);
+
+    std::mt19937 rng(11);
+    std::vector<tree::NodeID> open{nt.getChild(root, 0), nt.getChild(root, 1), nt.getChild(root, 2)};
+
+    tree::VisualFlags vf;
+
+    while (nt.nodeCount() < 50000 && !open.empty())
+    {
+        const auto i = rng() % open.size();
+        const auto nid = open[i];
+        open[i] = open.back();
+        open.pop_back();
+
+        static const int kid_counts[] = {0, 1, 2, 2, 2, 3, 5};
+        const auto kids = kid_counts[rng() % 7];
+        const auto label = std::string(rng() % 6, 'x');
+
+        nt.promoteNode(nt.getParent(nid), nt.getAlternative(nid), kids,
+                       kids > 0 ? tree::NodeStatus::BRANCH : tree::NodeStatus::FAILED, label);
+
+        for (auto alt = 0; alt < kids; ++alt)
+        {
+            open.push_back(nt.getChild(nid, alt));
+        }
+
+        if (rng() % 4 == 0)
+            vf.setLabelShown(nid, true);
+    }
+
+    const auto same_in_both_modes = [&]() {
+        tree::Layout shapes(tree::LayoutMode::Shapes);
+        tree::LayoutComputer(nt, shapes, vf).compute();
+
+        tree::Layout contours(tree::LayoutMode::Contours);
+        tree::LayoutComputer(nt, contours, vf).compute();
+
+        auto compared = 0;
+
+        for (auto i = 0; i < nt.nodeCount(); ++i)
+        {
+            const tree::NodeID nid(i);
+
+            /// (nodes under hidden ones are not laid out)
+            if (!shapes.getLayoutDone(nid))
+                continue;
+
+            CHECK(contours.getLayoutDone(nid));
+            CHECK(contours.getOffset(nid) == shapes.getOffset(nid));
+            CHECK(contours.getHeight(nid) == shapes.getHeight(nid));
+
+            const auto &bb = contours.getBoundingBox(nid);
+            CHECK(bb.left == shapes.getBoundingBox(nid).left);
+            CHECK(bb.right == shapes.getBoundingBox(nid).right);
+
+            ++compared;
+        }
+
+        CHECK(compared > 1000);
+    };
+
+    same_in_both_modes();
+
+    /// hidden subtrees, some of them lanterns (with and without labels)
+    for (auto n = 0; n < 300; ++n)
+    {
+        const tree::NodeID nid(static_cast<int>(rng() % nt.nodeCount()));
+
+        if (nid == root || nt.childrenCount(nid) == 0)
+            continue;
+
+        vf.setHidden(nid, true);
+
+        if (n % 2 == 0)
+            vf.setLanternSize(nid, static_cast<int>(rng() % 128));
+    }
+
+    same_in_both_modes();
+}
+
+/// Laying out on several threads must give the same shapes and offsets
+/// as on one, also when the top of the tree is made of paths long enough
+/// for the split into subtrees to give up part-way down
+void parallel_layout()
+{
+    tree::NodeTree nt;
+    const auto paths = 16;
+    const auto root = nt.createRoot(paths);
+
+    std::vector<tree::NodeID> open;
+
+    /// more than MAX_SPLIT_NODES nodes on the paths in total
+    for (auto alt = 0; alt < paths; ++alt)
+    {
+        auto nid = nt.getChild(root, alt);
+
+        for (auto depth = 0; depth < 1100; ++depth)
+        {
+            nt.promoteNode(nt.getParent(nid), nt.getAlternative(nid), 1, tree::NodeStatus::BRANCH);
+            nid = nt.getChild(nid, 0);
+        }
+
+        open.push_back(nid);
+    }
+
+    std::mt19937 rng(5);
+
+    tree::VisualFlags vf;
+
+    while (nt.nodeCount() < 150000 && !open.empty())
+    {
+        const auto i = rng() % open.size();
+        const auto nid = open[i];
+        open[i] = open.back();
+        open.pop_back();
+
+        static const int kid_counts[] = {0, 1, 2, 2, 2, 3, 5};
+        const auto kids = kid_counts[rng() % 7];
+
+        nt.promoteNode(nt.getParent(nid), nt.getAlternative(nid), kids,
+                       kids > 0 ? tree::NodeStatus::BRANCH : tree::NodeStatus::FAILED, std::string(rng() % 6, 'x'));
+
+        for (auto alt = 0; alt < kids; ++alt)
+        {
+            open.push_back(nt.getChild(nid, alt));
+        }
+
+        if (rng() % 8 == 0)
+            vf.setLabelShown(nid, true);
+
+        if (kids > 0 && rng() % 500 == 0)
+            vf.setHidden(nid, true);
+    }
+
+    for (const auto mode : {tree::LayoutMode::Shapes, tree::LayoutMode::Contours})
+    {
+        tree::Layout serial(mode);
+        tree::LayoutComputer serial_lc(nt, serial, vf);
+        serial_lc.setThreadCount(1);
+        serial_lc.compute();
+
+        tree::Layout parallel(mode);
+        tree::LayoutComputer parallel_lc(nt, parallel, vf);
+        parallel_lc.setThreadCount(4);
+        parallel_lc.compute();
+
+        for (auto i = 0; i < nt.nodeCount(); ++i)
+        {
+            const tree::NodeID nid(i);
+
+            CHECK(parallel.getLayoutDone(nid) == serial.getLayoutDone(nid));
+
+            if (!serial.getLayoutDone(nid))
+                continue;
+
+            CHECK(parallel.getOffset(nid) == serial.getOffset(nid));
+            CHECK(parallel.getHeight(nid) == serial.getHeight(nid));
+            CHECK(parallel.getBoundingBox(nid).left == serial.getBoundingBox(nid).left);
+            CHECK(parallel.getBoundingBox(nid).right == serial.getBoundingBox(nid).right);
+
+            if (mode == tree::LayoutMode::Shapes)
+            {
+                const auto &s1 = *parallel.getShape(nid);
+                const auto &s2 = *serial.getShape(nid);
+
+                for (auto depth = 0; depth < s2.height(); ++depth)
+                {
+                    CHECK(s1[depth].l == s2[depth].l && s1[depth].r == s2[depth].r);
+                }
+            }
+        }
+    }
+}
+
+/// A layout computed in slices (each stopping part-way through the tree)
+/// must end up the same as one computed in a single pass, including
+/// changes made between the slices
+void sliced_layout()
+{
+    tree::NodeTree nt;
+    const auto root = nt.createRoot(2);
+
+    std::mt19937 rng(7);
+    std::vector<tree::NodeID> open{nt.getChild(root, 0), nt.getChild(root, 1)};
+
+    while (nt.nodeCount() < 200000 && !open.empty())
+    {
+        const auto i = rng() % open.size();
+        const auto nid = open[i];
+        open[i] = open.back();
+        open.pop_back();
+
+        const auto kids = static_cast<int>(rng() % 4);
+        nt.promoteNode(nt.getParent(nid), nt.getAlternative(nid), kids,
+                       kids > 0 ? tree::NodeStatus::BRANCH : tree::NodeStatus::FAILED);
+
+        for (auto alt = 0; alt < kids; ++alt)
+        {
+            open.push_back(nt.getChild(nid, alt));
+        }
+    }
+
+    tree::VisualFlags vf;
+
+    tree::Layout sliced;
+    tree::LayoutComputer lc(nt, sliced, vf);
+
+    const auto same_as_single_pass = [&]() {
+        tree::Layout whole;
+        tree::LayoutComputer(nt, whole, vf).compute();
+
+        for (auto i = 0; i < nt.nodeCount(); ++i)
+        {
+            const tree::NodeID nid(i);
+
+            /// (nodes under hidden ones are not laid out)
+            if (!whole.getLayoutDone(nid))
+                continue;
+
+            CHECK(sliced.getOffset(nid) == whole.getOffset(nid));
+            CHECK(sliced.getHeight(nid) == whole.getHeight(nid));
+        }
+
+        const auto published = sliced.published(root);
+        CHECK(published && published->height == whole.getHeight(root));
+        CHECK(published->bb.left == whole.getBoundingBox(root).left);
+    };
+
+    auto slices = 1;
+    while (!lc.compute(std::chrono::milliseconds(0)))
+    {
+        CHECK(lc.hasPendingChanges());
+        CHECK(!sliced.published(root));
+        ++slices;
+    }
+
+    print("layout of {} nodes done in {} slices", nt.nodeCount(), slices);
+
+    CHECK(slices > 1);
+    CHECK(!lc.hasPendingChanges());
+    same_as_single_pass();
+
+    /// labels shown (and a subtree hidden) part-way through a pass
+    for (auto i = 1; i < nt.nodeCount(); i += 97)
+    {
+        vf.setLabelShown(tree::NodeID(i), true);
+        lc.dirtyUpLater(tree::NodeID(i));
+
+        if (i % 5 == 0)
+        {
+            lc.compute(std::chrono::milliseconds(0));
+        }
+    }
+
+    vf.setHidden(nt.getChild(root, 0), true);
+    lc.dirtyUpLater(nt.getChild(root, 0));
+
+    while (!lc.compute(std::chrono::milliseconds(0)))
+    {
+    }
+
+    same_as_single_pass();
+
+    /// a cancel issued before a slice takes the layout stops that slice
+    /// (the view cancels the worker's pass and then lays out itself)
+    vf.setHidden(nt.getChild(root, 0), false);
+    lc.dirtyUpLater(nt.getChild(root, 0));
+
+    lc.cancel();
+    CHECK(!lc.compute(std::chrono::hours(1)));
+    CHECK(!lc.compute(std::chrono::hours(1)));
+
+    /// ... until the work is taken over by a full pass
+    lc.compute();
+    CHECK(!lc.hasPendingChanges());
+    same_as_single_pass();
+
+    /// the cancel does not outlive the take-over
+    vf.setLabelShown(tree::NodeID(1), false);
+    lc.dirtyUpLater(tree::NodeID(1));
+    CHECK(lc.compute(std::chrono::hours(1)));
+    same_as_single_pass();
+}
+
+/// Slices computed while the builder keeps adding nodes and marking them
+/// dirty (as the view does straight from the builder thread): nodes
+/// published after a slice pins the tree must wait for a later slice
+void growing_layout()
+{
+    tree::NodeTree nt;
+    const auto root = nt.createRoot(2);
+
+    tree::VisualFlags vf;
+    tree::Layout layout;
+    tree::LayoutComputer lc(nt, layout, vf);
+
+    std::atomic<bool> building{true};
+
+    std::thread builder([&]() {
+        std::vector<NodeID> open{nt.getChild(root, 0), nt.getChild(root, 1)};
+        std::vector<NodeID> dirtied;
+
+        for (auto b = 0; b < 20000 && !open.empty(); ++b)
+        {
+            dirtied.clear();
+
+            nt.applyBatch([&]() {
+                for (auto i = 0; i < 2 && !open.empty(); ++i)
+                {
+                    const auto nid = open.back();
+                    open.pop_back();
+                    const auto kids = (b + i) % 3 == 0 ? 0 : 2;
+                    nt.promoteNode(nt.getParent(nid), nt.getAlternative(nid), kids,
+                                   kids > 0 ? tree::NodeStatus::BRANCH : tree::NodeStatus::FAILED);
+                    dirtied.push_back(nid);
+
+                    for (auto alt = 0; alt < kids; ++alt)
+                    {
+                        open.insert(open.begin(), nt.getChild(nid, alt));
+                        dirtied.push_back(nt.getChild(nid, alt));
+                    }
+                }
+            });
+
+            lc.dirtyUpLater(dirtied);
+        }
+
+        building = false;
+    });
+
+    auto slices = 0;
+    while (building)
+    {
+        lc.compute(std::chrono::milliseconds(0));
+        ++slices;
+    }
+
+    builder.join();
+
+    lc.compute();
+    CHECK(!lc.hasPendingChanges());
+
+    tree::Layout whole;
+    tree::LayoutComputer(nt, whole, vf).compute();
+
+    for (auto i = 0; i < nt.nodeCount(); ++i)
+    {
+        const tree::NodeID nid(i);
+        CHECK(layout.getOffset(nid) == whole.getOffset(nid));
+        CHECK(layout.getHeight(nid) == whole.getHeight(nid));
+    }
+
+    print("layout of {} nodes kept up in {} slices", nt.nodeCount(), slices);
+}
+
+/// Depths along a long chain (node depth used to be recomputed by
+/// walking up to the root; tree_bench times the same on a longer chain)
+void deep_chain()
+{
+
+    const int n = 10000;
+
+    tree::NodeTree nt;
+    auto nid = nt.createRoot(1);
+
+    for (auto i = 0; i < n; ++i)
+    {
+        nid = nt.promoteNode(nid, 0, 1, tree::NodeStatus::BRANCH);
+    }
+
+    CHECK(nt.nodeCount() == n + 2);
+    CHECK(nt.depth() == n + 2);
+
+    /// every node of the chain (the last one is still undetermined)
+    auto depth = 1;
+    for (auto cur = nt.getRoot(); cur != NodeID::NoNode; ++depth)
+    {
+        CHECK(nt.getDepth(cur) == depth);
+        cur = nt.childrenCount(cur) > 0 ? nt.getChild(cur, 0) : NodeID::NoNode;
+    }
+
+    CHECK(depth == n + 3);
+}
+
+void batched_building()
+{
+
+    tree::NodeTree nt;
+
+    nt.applyBatch([&]() {
+        const auto root = nt.createRoot(2);
+        const auto n1 = nt.promoteNode(root, 0, 2, tree::NodeStatus::BRANCH);
+        nt.promoteNode(n1, 0, 0, tree::NodeStatus::FAILED);
+        nt.promoteNode(n1, 1, 0, tree::NodeStatus::SOLVED);
+        nt.promoteNode(root, 1, 0, tree::NodeStatus::FAILED);
+    });
+
+    CHECK(nt.nodeCount() == 5);
+    CHECK(nt.hasSolvedChildren(nt.getRoot()));
+    CHECK(!nt.isOpen(nt.getRoot()));
+
+    /// the tree mutex is released after the batch
+    CHECK(nt.treeMutex().tryLock());
+    nt.treeMutex().unlock("test");
+
+    /// nodes added by a batch that fails are published all the same
+    auto failed = false;
+    try
+    {
+        nt.applyBatch([&]() {
+            nt.addExtraChild(nt.getRoot());
+            throw tree::invalid_tree();
+        });
+    }
+    catch (const tree::invalid_tree &)
+    {
+        failed = true;
+    }
+
+    CHECK(failed);
+    CHECK(nt.nodeCount() == 6);
+    CHECK(nt.childrenCount(nt.getRoot()) == 3);
+
+    nt.applyBatch([&]() { nt.addExtraChild(nt.getRoot()); });
+    CHECK(nt.nodeCount() == 7);
+}
+
+/// A tree read from a database (parents first) is only published once
+/// all of its nodes are added
+void database_loading()
+{
+    tree::NodeTree nt;
+
+    auto seen_while_loading = -1;
+
+    nt.applyBatch([&]() {
+        nt.db_createRoot(NodeID{0});
+        nt.db_addChild(NodeID{1}, NodeID{0}, 0, tree::NodeStatus::BRANCH);
+        nt.db_addChild(NodeID{2}, NodeID{0}, 1, tree::NodeStatus::FAILED);
+        nt.db_addChild(NodeID{3}, NodeID{1}, 0, tree::NodeStatus::SOLVED);
+
+        std::thread reader([&]() { seen_while_loading = nt.nodeCount(); });
+        reader.join();
+    });
+
+    CHECK(seen_while_loading == 0);
+    CHECK(nt.nodeCount() == 4);
+    CHECK(nt.getChild(NodeID{0}, 1) == NodeID{2});
+    CHECK(nt.getDepth(NodeID{3}) == 3);
+    CHECK(nt.getStatus(NodeID{3}) == tree::NodeStatus::SOLVED);
+
+    /// a node stored before its parent (or out of order) is rejected
+    auto rejected = false;
+    try
+    {
+        nt.applyBatch([&]() { nt.db_addChild(NodeID{5}, NodeID{1}, 1, tree::NodeStatus::FAILED); });
+    }
+    catch (const tree::invalid_tree &)
+    {
+        rejected = true;
+    }
+
+    CHECK(rejected);
+    CHECK(nt.nodeCount() == 4);
+}
+
+/// Count the nodes reachable from the root
+static int count_reachable(const tree::NodeTree &nt)
+{
+    int count = 0;
+    std::vector<NodeID> stack{nt.getRoot()};
+
+    while (!stack.empty())
+    {
+        const auto nid = stack.back();
+        stack.pop_back();
+        ++count;
+
+        for (auto alt = 0; alt < nt.childrenCount(nid); ++alt)
+        {
+            stack.push_back(nt.getChild(nid, alt));
+        }
+    }
+
+    return count;
+}
+
+void snapshot_reads()
+{
+
+    {
+        tree::NodeTree nt;
+        const auto root = nt.createRoot(2);
+
+        tree::SnapshotPin pin(nt);
+        const auto before = nt.snapshot();
+
+        /// a modification from "another thread" (the pin is only seen by this one)
+        nt.promoteNode(root, 0, 3, tree::NodeStatus::BRANCH);
+
+        CHECK(nt.nodeCount() == before.node_count);
+        CHECK(nt.childrenCount(nt.getChild(root, 0)) == 0);
+    }
+
+    /// readers traverse the tree without locking while it grows
+    tree::NodeTree nt;
+    nt.createRoot(2);
+
+    const int n_batches = 200;
+
+    std::thread builder([&]() {
+        std::vector<NodeID> open{NodeID{1}, NodeID{2}};
+
+        for (auto b = 0; b < n_batches; ++b)
+        {
+            nt.applyBatch([&]() {
+                for (auto i = 0; i < 50; ++i)
+                {
+                    const auto nid = open.back();
+                    open.pop_back();
+                    const auto pid = nt.getParent(nid);
+                    nt.promoteNode(pid, nt.getAlternative(nid), 2, tree::NodeStatus::BRANCH);
+                    open.push_back(NodeID{nt.nodeCount() - 1});
+                    open.push_back(NodeID{nt.nodeCount() - 2});
+                }
+            });
+        }
+    });
+
+    int last_count = 0;
+    while (last_count < 3 + n_batches * 50 * 2)
+    {
+        tree::SnapshotPin pin(nt);
+        const auto count = count_reachable(nt);
+        CHECK(count == nt.nodeCount());
+        CHECK(count >= last_count);
+        last_count = count;
+    }
+
+    builder.join();
+}
+
+void lock_statistics()
+{
+
+    utils::lock_stats::reset();
+
+    utils::Mutex mutex;
+
+    for (auto i = 0; i < 3; ++i)
+    {
+        utils::MutexLocker lock(&mutex, "test: lock statistics");
+    }
+
+    /// another thread has to wait while the lock is held for 10ms
+    mutex.lock("test: lock statistics");
+
+    std::thread waiter([&]() {
+        utils::MutexLocker lock(&mutex, "test: lock statistics");
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    mutex.unlock("test: lock statistics");
+    waiter.join();
+
+    const auto stats = utils::lock_stats::collect();
+
+    auto it = std::find_if(stats.begin(), stats.end(), [](const utils::LockSiteStats &s) {
+        return s.site == "test: lock statistics";
+    });
+
+    CHECK(it != stats.end());
+    CHECK(it->acquisitions == 5);
+    CHECK(it->contended == 1);
+    CHECK(it->max_hold >= 10 * 1000 * 1000);
+    CHECK(it->total_wait > 0);
+}
+
+void solver_id_map()
+{
+
+    IdMap map;
+
+    /// two threads reporting their (dense) ids interleaved
+    for (auto i = 0; i < 1000; ++i)
+    {
+        map.addPair({i, 0, 0}, NodeID{2 * i});
+        map.addPair({i, 0, 1}, NodeID{2 * i + 1});
+    }
+
+    /// ids far beyond the dense range and negative ids are kept too
+    map.addPair({1000000, 0, 0}, NodeID{2000});
+    map.addPair({-5, 1, 0}, NodeID{2001});
+
+    CHECK(map.get({0, 0, 0}) == NodeID{0});
+    CHECK(map.get({999, 0, 1}) == NodeID{1999});
+    CHECK(map.get({1000000, 0, 0}) == NodeID{2000});
+    CHECK(map.get({-5, 1, 0}) == NodeID{2001});
+
+    CHECK(map.get({1000, 0, 0}) == NodeID::NoNode);
+    CHECK(map.get({0, 0, 2}) == NodeID::NoNode);
+    CHECK(map.get({0, 1, 0}) == NodeID::NoNode);
+
+    CHECK(map.getUID(NodeID{1999}) == SolverID({999, 0, 1}));
+    CHECK(map.getUID(NodeID{2000}) == SolverID({1000000, 0, 0}));
+    CHECK(map.getUID(NodeID{2002}).nid == -1);
+
+    /// an id first kept aside must still be found once the dense range
+    /// grows past it
+    IdMap grown;
+    grown.addPair({2000, 0, 0}, NodeID{0});
+    for (auto i = 0; i < 2000; ++i)
+    {
+        grown.addPair({i, 0, 0}, NodeID{i + 1});
+    }
+    grown.addPair({2001, 0, 0}, NodeID{2001});
+    grown.addPair({5000, 0, 0}, NodeID{2002});
+
+    CHECK(grown.get({2000, 0, 0}) == NodeID{0});
+    CHECK(grown.get({1999, 0, 0}) == NodeID{2000});
+    CHECK(grown.get({2001, 0, 0}) == NodeID{2001});
+    CHECK(grown.get({5000, 0, 0}) == NodeID{2002});
+    CHECK(grown.get({4999, 0, 0}) == NodeID::NoNode);
+}
+
+void info_scanning()
+{
+
+    SolverData sd;
+
+    sd.setNodeId({7, 0, 0}, NodeID{1});
+    sd.setNodeId({9, 1, 2}, NodeID{2});
+
+    const std::string info = R"({"explanation": {"lits": [1, -2.5e3, "a\"]b"]}, "flag": true,
+        "reasons": [3, 1, "x", 4],
+        "nogoods": [{"nid": 7, "rid": 0, "tid": 0}, {"tid": 2, "nid": 9, "rid": 1, "extra": null},
+                    {"nid": 8, "rid": 0, "tid": 0}, [1, 2]]})";
+
+    sd.processInfo(NodeID{3}, info);
+
+    CHECK(sd.getInfo(NodeID{3}) == info);
+
+    const auto reasons = sd.getContribConstraints(NodeID{3});
+    CHECK(reasons && *reasons == std::vector<int>({3, 1, 4}));
+
+    /// unknown solver ids are left out
+    const auto nogoods = sd.getContribNogoods(NodeID{3});
+    CHECK(nogoods && *nogoods == std::vector<NodeID>({NodeID{1}, NodeID{2}}));
+
+    /// malformed and empty info are not stored
+    sd.processInfo(NodeID{4}, R"({"reasons": [1, 2)");
+    sd.processInfo(NodeID{5}, R"({"reasons": [1]} trailing)");
+    sd.processInfo(NodeID{6}, "{}");
+
+    CHECK(sd.getInfo(NodeID{4}).empty());
+    CHECK(sd.getInfo(NodeID{5}).empty());
+    CHECK(sd.getInfo(NodeID{6}).empty());
+    CHECK(!sd.getContribConstraints(NodeID{4}));
+
+    /// numbers that are not ints are skipped (not truncated)
+    sd.processInfo(NodeID{7}, R"({"reasons": [3, 2.5, 4294967296, -2147483648, 2147483647, -2147483649, 5],
+        "nogoods": [{"nid": 4294967303, "rid": 0, "tid": 0}, {"nid": 9, "rid": 1, "tid": 2}]})");
+
+    const auto reasons7 = sd.getContribConstraints(NodeID{7});
+    CHECK(reasons7 && *reasons7 == std::vector<int>({3, INT_MIN, INT_MAX, 5}));
+
+    const auto nogoods7 = sd.getContribNogoods(NodeID{7});
+    CHECK(nogoods7 && *nogoods7 == std::vector<NodeID>({NodeID{2}}));
+}
+
+void renaming_nogoods()
+{
+
+    const char *paths_file = "renaming_nogoods_test.paths";
+    const char *model_file = "renaming_nogoods_test.mzn";
+
+    {
+        std::ofstream paths(paths_file);
+        paths << "X_INTRODUCED_1_\tx\tm.mzn|3|5|3|10|ca|x;\n";
+        paths << "X_INTRODUCED_22_\tqueens\tm.mzn|4|5|4|10|ca|queens;\n";
+
+        std::ofstream model(model_file);
+        model << "int: n = 8;\n";
+    }
+
+    NameMap nm;
+    const bool ok = nm.initialize(paths_file, model_file);
+
+    std::remove(paths_file);
+    std::remove(model_file);
+
+    CHECK(ok);
+
+    const std::string ng = "X_INTRODUCED_1_>=3 \\/ 2X_INTRODUCED_22_!=_X_INTRODUCED_1_";
+    const std::string expected = "x>=3 \\/ 2queens!=_x";
+
+    CHECK(nm.replaceNames(ng) == expected);
+
+    /// the second call is served from the cache
+    CHECK(nm.replaceNamesCached(ng) == expected);
+    CHECK(nm.replaceNamesCached(ng) == expected);
+
+    /// the least recently used texts are evicted
+    for (auto i = 0; i < 5000; ++i)
+    {
+        nm.replaceNamesCached("X_INTRODUCED_1_ = " + std::to_string(i));
+    }
+
+    CHECK(nm.replaceNamesCached(ng) == expected);
+    CHECK(nm.replaceNamesCached("X_INTRODUCED_1_ = 4999") == "x = 4999");
+}
+
+void loading_paths_file()
+{
+
+    const char *paths_file = "loading_paths_file_test.paths";
+    const char *model_file = "loading_paths_file_test.mzn";
+
+    /// large enough to be split between several threads
+    const int n_symbols = 100000;
+
+    {
+        std::ofstream paths(paths_file);
+        for (auto i = 0; i < n_symbols; ++i)
+        {
+            paths << "X_INTRODUCED_" << i << "_\tvar" << i << "\tm.mzn|" << i + 1
+                  << "|5|" << i + 1 << "|10|ca|var" << i << ";m.mzn|1|1|1|1|id\r\n";
+        }
+        paths << "X_INTRODUCED_0_\tduplicate\tm.mzn|1|1|1|1|ca|x;\n";
+
+        std::ofstream model(model_file);
+        model << "int: n = 8;\n";
+    }
+
+    {
+        NameMap nm;
+        CHECK(nm.initialize(paths_file, model_file));
+
+        /// the first line for an id is used
+        CHECK(nm.replaceNames("X_INTRODUCED_0_") == "var0");
+
+        for (auto i = 0; i < n_symbols; i += 997)
+        {
+            const auto id = "X_INTRODUCED_" + std::to_string(i) + "_";
+            CHECK(nm.replaceNames(id + " < 1") == "var" + std::to_string(i) + " < 1");
+
+            /// the trailing carriage return is not part of the path
+            const auto path = nm.getPath(id);
+            CHECK(path.back() == 'd');
+        }
+
+        CHECK(nm.getPath("unknown").empty());
+    }
+
+    {
+        std::ofstream paths(paths_file);
+        paths << "X_INTRODUCED_0_\tx\tm.mzn|1|1|1|1|ca|x;\n";
+        paths << "X_INTRODUCED_1_\ty\n";
+    }
+
+    NameMap invalid;
+    CHECK(!invalid.initialize(paths_file, model_file));
+
+    {
+        std::ofstream paths(paths_file);
+        paths << "X_INTRODUCED_0_\tx\tm.mzn|4294967297|1|1|1|ca|x;\n";
+    }
+
+    /// a location that does not fit into an int is invalid (not wrapped around)
+    NameMap overflowing;
+    CHECK(!overflowing.initialize(paths_file, model_file));
+
+    std::remove(paths_file);
+    std::remove(model_file);
+}
+
+void framing_ring()
+{
+
+    utils::ByteRing ring(10);
+    CHECK(ring.capacity() == 16);
+
+    auto write = [&ring](const std::string &str) {
+        std::size_t written = 0;
+        while (written < str.size())
+        {
+            std::size_t len;
+            char *dest = ring.writePtr(len);
+            CHECK(len > 0);
+            len = std::min(len, str.size() - written);
+            std::copy(str.begin() + written, str.begin() + written + len, dest);
+            ring.commit(len);
+            written += len;
+        }
+    };
+
+    write("0123456789");
+    ring.consume(6);
+    CHECK(std::string(ring.peek(4), 4) == "6789");
+
+    /// these bytes wrap around the end
+    write("abcdefghij");
+    CHECK(ring.size() == 14 && ring.freeSpace() == 2);
+    CHECK(std::string(ring.peek(10), 10) == "6789abcdef");
+    CHECK(ring.peek(11) == nullptr);
+
+    std::string out(14, ' ');
+    ring.copyOut(&out[0], 14);
+    CHECK(out == "6789abcdefghij");
+
+    /// growing keeps the unread bytes (now contiguous)
+    ring.reserve(20);
+    CHECK(ring.capacity() == 32);
+    CHECK(std::string(ring.peek(14), 14) == "6789abcdefghij");
+
+    /// an emptied buffer starts from the beginning again
+    ring.consume(14);
+    std::size_t len;
+    ring.writePtr(len);
+    CHECK(len == 32);
+}
+
+void spsc_queue()
+{
+
+    utils::SpscQueue<std::string> queue(100);
+    CHECK(queue.capacity() == 128);
+
+    const int count = 200000;
+
+    std::thread producer([&queue]() {
+        for (auto i = 0; i < count; ++i)
+        {
+            std::string *slot;
+            while (!(slot = queue.back()))
+            {
+                std::this_thread::yield();
+            }
+
+            *slot = std::to_string(i);
+            queue.push();
+        }
+    });
+
+    auto expected = 0;
+
+    while (expected < count)
+    {
+        const auto n = queue.size();
+
+        for (auto i = 0; i < n; ++i)
+        {
+            CHECK(queue.at(i) == std::to_string(expected + i));
+        }
+
+        queue.pop(n);
+        expected += n;
+    }
+
+    producer.join();
+
+    CHECK(queue.size() == 0);
+}
+
+void task_pool()
+{
+    utils::TaskPool pool(4);
+    CHECK(pool.threadCount() == 4);
+
+    std::vector<std::atomic<int>> runs(1000);
+
+    /// batches can be run one after another on the same pool
+    for (auto batch = 0; batch < 3; ++batch)
+    {
+        std::vector<utils::TaskPool::Task> tasks;
+
+        for (auto i = 0; i < static_cast<int>(runs.size()); ++i)
+        {
+            tasks.push_back([&runs, i]() {
+                /// uneven tasks: some of them are stolen by idle threads
+                if (i % 100 == 0)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                ++runs[i];
+            });
+        }
+
+        pool.run(std::move(tasks));
+
+        for (const auto &count : runs)
+        {
+            CHECK(count == batch + 1);
+        }
+    }
+}
+
+void capture_replay()
+{
+    const char *capture_file = "test_capture.bin";
+
+    const std::vector<std::string> messages{"start", "", std::string(100000, 'n'), "done"};
+
+    {
+        CaptureWriter writer(capture_file);
+        CHECK(writer.isOpen());
+
+        for (const auto &msg : messages)
+        {
+            writer.write(msg.data(), static_cast<int32_t>(msg.size()));
+        }
+    }
+
+    {
+        CaptureReader reader(capture_file);
+        CHECK(reader.isValid());
+
+        int64_t time_us;
+        int64_t last_time = 0;
+        std::vector<char> frame;
+
+        for (const auto &msg : messages)
+        {
+            CHECK(reader.next(time_us, frame));
+            CHECK(std::string(frame.begin(), frame.end()) == msg);
+            CHECK(time_us >= last_time);
+            last_time = time_us;
+        }
+
+        CHECK(!reader.next(time_us, frame));
+    }
+
+    /// not a capture file
+    {
+        std::ofstream(capture_file) << "CPPCAP?";
+    }
+
+    CHECK(!CaptureReader(capture_file).isValid());
+
+    std::remove(capture_file);
+}
+
+/// nodes from different solver threads arriving before their parents
+void out_of_order_building()
+{
+    Execution ex("out of order", 1, false);
+    TreeBuilder builder(ex);
+
+    auto queue = std::make_shared<NodeQueue>(16);
+    MessageMarshalling marshalling;
+
+    auto push = [&](NodeUID node, NodeUID parent, int alt, int kids, NodeStatus status) {
+        *queue->back() = marshalling.makeNode(node, parent, alt, kids, status);
+        queue->push();
+    };
+
+    /// thread 1 explores the right branch of thread 0's root
+    push({0, 0, 1}, {0, 0, 0}, 1, 2, BRANCH);
+    push({2, 0, 1}, {0, 0, 1}, 1, 0, SOLVED);
+    push({1, 0, 1}, {0, 0, 1}, 0, 0, FAILED);
+    push({0, 0, 0}, {-1, 0, 0}, 0, 2, BRANCH);
+    push({1, 0, 0}, {0, 0, 0}, 0, 0, FAILED);
+    /// the parent of this one never arrives
+    push({5, 0, 2}, {4, 0, 2}, 0, 0, FAILED);
+
+    builder.handleNodes(queue);
+    CHECK(queue->size() == 0);
+
+    const auto &tree = ex.tree();
+    CHECK(tree.nodeCount() == 5);
+
+    const auto root = tree.getRoot();
+    const auto right = tree.getChild(root, 1);
+
+    CHECK(tree.getStatus(tree.getChild(root, 0)) == tree::NodeStatus::FAILED);
+    CHECK(tree.getStatus(right) == tree::NodeStatus::BRANCH);
+    CHECK(tree.getStatus(tree.getChild(right, 0)) == tree::NodeStatus::FAILED);
+    CHECK(tree.getStatus(tree.getChild(right, 1)) == tree::NodeStatus::SOLVED);
+
+    CHECK(ex.solver_data().getNodeId({2, 0, 1}) == tree.getChild(right, 1));
+
+    builder.finishBuilding();
+}
+
+/// shards building the subtrees of several solver threads at the same time
+void sharded_building()
+{
+    const int threads = 4;
+    const int depth = 1000;
+
+    Execution ex("sharded", 1, false);
+    TreeBuilder builder(ex);
+
+    MessageMarshalling marshalling;
+
+    std::vector<std::shared_ptr<NodeQueue>> queues;
+
+    for (auto t = 1; t <= threads; ++t)
+    {
+        queues.push_back(std::make_shared<NodeQueue>(depth, t));
+        auto &queue = *queues.back();
+
+        /// a chain below the root's child number `t - 1`
+        for (auto i = 0; i < depth; ++i)
+        {
+            const NodeUID parent = i == 0 ? NodeUID{0, 0, 0} : NodeUID{i - 1, 0, t};
+            const auto kids = i + 1 < depth ? 1 : 0;
+            *queue.back() = marshalling.makeNode({i, 0, t}, parent, i == 0 ? t - 1 : 0, kids, kids ? BRANCH : SOLVED);
+            queue.push();
+        }
+    }
+
+    std::vector<std::unique_ptr<BuilderShard>> shards;
+    std::vector<std::thread> workers;
+
+    for (auto t = 0; t < threads; ++t)
+    {
+        shards.emplace_back(new BuilderShard(builder));
+    }
+
+    for (auto t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&shards, &queues, t]() {
+            shards[t]->handleNodes(queues[t]);
+        });
+    }
+
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    /// every node is waiting for the root
+    CHECK(ex.tree().nodeCount() == 0);
+
+    auto root_queue = std::make_shared<NodeQueue>(1);
+    *root_queue->back() = marshalling.makeNode({0, 0, 0}, {-1, 0, 0}, 0, threads, BRANCH);
+    root_queue->push();
+    builder.handleNodes(root_queue);
+
+    const auto &tree = ex.tree();
+    CHECK(tree.nodeCount() == 1 + threads * depth);
+    CHECK(tree.depth() == depth + 1);
+
+    for (auto t = 1; t <= threads; ++t)
+    {
+        const auto nid = ex.solver_data().getNodeId({depth - 1, 0, t});
+        CHECK(tree.getStatus(nid) == tree::NodeStatus::SOLVED);
+        CHECK(tree.getDepth(nid) == depth + 1);
+    }
+
+    builder.finishBuilding();
+}
+
+void restart_segments()
+{
+    Execution ex("restarts", 1, true);
+    TreeBuilder builder(ex);
+
+    MessageMarshalling marshalling;
+
+    auto queue = std::make_shared<NodeQueue>(16);
+
+    /// three restarts: a failed node, a branch with a solution and a failure,
+    /// and a (still unexplored) branch
+    *queue->back() = marshalling.makeNode({0, 0, 0}, {-1, 0, 0}, 0, 0, FAILED);
+    queue->push();
+    *queue->back() = marshalling.makeNode({0, 1, 0}, {-1, 1, 0}, 0, 2, BRANCH);
+    queue->push();
+    *queue->back() = marshalling.makeNode({1, 1, 0}, {0, 1, 0}, 0, 0, SOLVED);
+    queue->push();
+    *queue->back() = marshalling.makeNode({2, 1, 0}, {0, 1, 0}, 1, 0, FAILED);
+    queue->push();
+    *queue->back() = marshalling.makeNode({0, 2, 0}, {-1, 2, 0}, 0, 2, BRANCH);
+    queue->push();
+
+    builder.handleNodes(queue);
+
+    auto &tree = ex.tree();
+    CHECK(tree.hasRestarts());
+    CHECK(tree.childrenCount(tree.getRoot()) == 3);
+
+    /// restarts are frozen once the next one begins
+    CHECK(tree.frozenRestartCount() == 2);
+
+    const auto first = tree.restartSummary(0);
+    CHECK(first.nodeCount() == 1 && first.failed == 1 && first.depth == 1);
+
+    const auto second = tree.restartSummary(1);
+    CHECK(second.root == tree.getChild(tree.getRoot(), 1));
+    CHECK(second.nodeCount() == 3 && second.solved == 1 && second.depth == 2);
+
+    const auto last = tree.restartSummary(2);
+    CHECK(last.branch == 1 && last.undetermined == 2);
+
+    /// a node of a frozen restart can arrive late (from another shard)
+    auto late = std::make_shared<NodeQueue>(16);
+
+    *late->back() = marshalling.makeNode({0, 3, 0}, {-1, 3, 0}, 0, 0, FAILED);
+    late->push();
+    *late->back() = marshalling.makeNode({1, 2, 0}, {0, 2, 0}, 0, 0, SOLVED);
+    late->push();
+
+    builder.handleNodes(late);
+
+    CHECK(tree.frozenRestartCount() == 3);
+
+    const auto refreshed = tree.restartSummary(2);
+    CHECK(refreshed.branch == 1 && refreshed.solved == 1 && refreshed.undetermined == 1);
+    CHECK(refreshed.depth == 2);
+
+    builder.finishBuilding();
+    tree.setDone();
+
+    CHECK(tree.frozenRestartCount() == 4);
+    CHECK(tree.restartSummary(2).undetermined == 1);
+    CHECK(tree.restartSummary(3).failed == 1);
 }
 
 void run()
@@ -97,6 +1553,60 @@ void run()
 
     growing_tree();
 
+    interleaved_children();
+
+    wide_children();
+
+    removing_children();
+
+    node_info_bulk();
+
+    interned_labels();
+
+    interned_shapes();
+
+    extent_kernels();
+
+    contour_layout();
+
+    parallel_layout();
+
+    sliced_layout();
+
+    growing_layout();
+
+    deep_chain();
+
+    batched_building();
+
+    database_loading();
+
+    snapshot_reads();
+
+    lock_statistics();
+
+    solver_id_map();
+
+    info_scanning();
+
+    renaming_nogoods();
+
+    loading_paths_file();
+
+    framing_ring();
+
+    spsc_queue();
+
+    task_pool();
+
+    capture_replay();
+
+    out_of_order_building();
+
+    sharded_building();
+
+    restart_segments();
+
     // array_usage();
 }
 
@@ -0,0 +1,253 @@
+#include "contour_layout_cursor.hh"
+#include "layout_cursor.hh"
+
+#include "../layout.hh"
+#include "../node_tree.hh"
+#include "../../config.hh"
+
+/// needed for VisualFlags
+#include "../traditional_view.hh"
+
+#include <algorithm>
+#include <climits>
+#include <vector>
+
+namespace cpprofiler
+{
+namespace tree
+{
+
+ContourWalker::ContourWalker(const NodeTree &tree, const VisualFlags &nf, const Layout &lo, bool debug)
+    : tree_(tree), m_vis_flags(nf), m_layout(lo), debug_mode_(debug) {}
+
+/// Same extents as the top of the node's shape computed by `LayoutCursor`
+ContourWalker::Element ContourWalker::element(NodeID nid) const
+{
+    const bool label_shown = m_vis_flags.isLabelShown(nid);
+
+    if (m_vis_flags.isHidden(nid))
+    {
+        const auto lsize = m_vis_flags.lanternSize(nid);
+
+        if (lsize > -1)
+        {
+            const Extent body{-lantern::HALF_WIDTH, lantern::HALF_WIDTH};
+            const auto top = label_shown ? calculateForSingleNode(nid, tree_, true, true, debug_mode_) : body;
+            return {top, body, lantern_levels(lsize)};
+        }
+
+        if (!label_shown)
+            return {Shape::hidden[0], Shape::hidden[1], 2};
+
+        const auto label = calculateForSingleNode(nid, tree_, true, true, debug_mode_);
+        return {label, label, 2};
+    }
+
+    if (tree_.childrenCount(nid) > 2)
+        return {{-traditional::HALF_MAX_NODE_W, traditional::HALF_MAX_NODE_W}, {}, 1};
+
+    return {calculateForSingleNode(nid, tree_, label_shown, false, debug_mode_), {}, 1};
+}
+
+ContourWalker::ContourPos ContourWalker::contourPos(NodeID nid, int x, int level) const
+{
+    return {nid, x, level, element(nid)};
+}
+
+/// The contour continues within the node's own element, then
+/// through its first (last) child or the thread left at its bottom
+void ContourWalker::descend(ContourPos &pos, bool left) const
+{
+    if (pos.level + 1 < pos.element.levels)
+    {
+        ++pos.level;
+        return;
+    }
+
+    const auto nid = pos.node;
+    const auto nkids = m_vis_flags.isHidden(nid) ? 0 : tree_.childrenCount(nid);
+
+    if (nkids > 0)
+    {
+        const auto kid = tree_.getChild(nid, left ? 0 : nkids - 1);
+        pos = contourPos(kid, pos.x + static_cast<int>(m_layout.getOffset(kid)), 0);
+        return;
+    }
+
+    const auto &links = m_layout.contour(nid);
+    const auto &thread = left ? links.thread_l : links.thread_r;
+    pos = contourPos(thread.node, pos.x + thread.dx, thread.level);
+}
+
+ShapeUniqPtr ContourWalker::shapeOf(NodeID nid) const
+{
+    const auto height = m_layout.getHeight(nid);
+    auto shape = ShapeUniqPtr(new Shape(height));
+
+    auto left = contourPos(nid, 0, 0);
+    auto right = left;
+
+    for (auto depth = 0; depth < height; ++depth)
+    {
+        if (depth > 0)
+        {
+            descend(left, true);
+            descend(right, false);
+        }
+        shape->setExtent(depth, {left.extent().l, right.extent().r});
+    }
+
+    shape->setBoundingBox(m_layout.getBoundingBox(nid));
+
+    return shape;
+}
+
+ContourLayoutCursor::ContourLayoutCursor(NodeID start, const NodeTree &tree, const VisualFlags &nf, Layout &lo, bool debug)
+    : NodeCursor(start, tree), m_layout(lo), tree_(tree), m_vis_flags(nf), walker_(tree, nf, lo, debug) {}
+
+bool ContourLayoutCursor::mayMoveDownwards()
+{
+    return NodeCursor::mayMoveDownwards() && !m_vis_flags.isHidden(cur_node()) &&
+           m_layout.isDirty(cur_node());
+}
+
+/// Children are placed one by one against the right contour of the
+/// siblings on their left; only the levels both have in common are
+/// visited, so the cost is linear in the size of the tree overall
+void ContourLayoutCursor::computeForNode(NodeID nid)
+{
+    const auto el = walker_.element(nid);
+    const auto nkids = m_vis_flags.isHidden(nid) ? 0 : tree_.childrenCount(nid);
+
+    auto &links = m_layout.contour(nid);
+    links.thread_l.node = NodeID::NoNode;
+    links.thread_r.node = NodeID::NoNode;
+
+    if (nkids == 0)
+    {
+        BoundingBox bb{el.top.l, el.top.r};
+
+        if (el.levels > 1)
+        {
+            bb = {std::min(bb.left, el.rest.l), std::max(bb.right, el.rest.r)};
+        }
+
+        links.extreme_l = links.extreme_r = nid;
+        links.extreme_l_x = links.extreme_r_x = 0;
+
+        m_layout.setExtent(nid, bb, el.levels);
+        m_layout.setLayoutDone(nid, true);
+        return;
+    }
+
+    /// threads left at the bottom of the children by a previous layout
+    for (auto alt = 0; alt < nkids; ++alt)
+    {
+        const auto &kid_links = m_layout.contour(tree_.getChild(nid, alt));
+        for (const auto extreme : {kid_links.extreme_l, kid_links.extreme_r})
+        {
+            m_layout.contour(extreme).thread_l.node = NodeID::NoNode;
+            m_layout.contour(extreme).thread_r.node = NodeID::NoNode;
+        }
+    }
+
+    std::vector<int> x_offsets(nkids);
+
+    /// the forest of the children placed so far
+    const auto first = tree_.getChild(nid, 0);
+    auto forest_height = m_layout.getHeight(first);
+    auto forest = m_layout.contour(first);
+
+    for (auto alt = 1; alt < nkids; ++alt)
+    {
+        const auto kid = tree_.getChild(nid, alt);
+        const auto kid_height = m_layout.getHeight(kid);
+        const auto common_depth = std::min(forest_height, kid_height);
+
+        auto right = walker_.contourPos(tree_.getChild(nid, alt - 1), x_offsets[alt - 1], 0);
+        auto left = walker_.contourPos(kid, 0, 0);
+
+        auto max = INT_MIN;
+        for (auto depth = 0; depth < common_depth; ++depth)
+        {
+            if (depth > 0)
+            {
+                walker_.descend(right, false);
+                walker_.descend(left, true);
+            }
+            max = std::max(max, right.extent().r - left.extent().l);
+        }
+
+        auto x = max + layout::min_dist_x;
+
+        /// binary nodes are centered on whole pixels
+        if (nkids == 2)
+            x = 2 * (x / 2);
+
+        x_offsets[alt] = x;
+
+        const auto &kid_links = m_layout.contour(kid);
+
+        if (kid_height < forest_height)
+        {
+            /// the right contour continues in the forest
+            walker_.descend(right, false);
+            m_layout.contour(kid_links.extreme_r).thread_r = {right.node, right.x - (x + kid_links.extreme_r_x), right.level};
+        }
+        else if (kid_height > forest_height)
+        {
+            /// the left contour continues in the new child
+            walker_.descend(left, true);
+            m_layout.contour(forest.extreme_l).thread_l = {left.node, x + left.x - forest.extreme_l_x, left.level};
+
+            forest.extreme_l = kid_links.extreme_l;
+            forest.extreme_l_x = x + kid_links.extreme_l_x;
+            forest_height = kid_height;
+        }
+
+        if (kid_height >= forest_height)
+        {
+            forest.extreme_r = kid_links.extreme_r;
+            forest.extreme_r_x = x + kid_links.extreme_r_x;
+        }
+    }
+
+    /// center the node above its children
+    const auto half_dist = x_offsets.back() / 2;
+
+    BoundingBox bb{el.top.l, el.top.r};
+
+    for (auto alt = 0; alt < nkids; ++alt)
+    {
+        const auto kid = tree_.getChild(nid, alt);
+        const auto offset = x_offsets[alt] - half_dist;
+        m_layout.setChildOffset(kid, offset);
+
+        const auto &kid_bb = m_layout.getBoundingBox(kid);
+        bb = {std::min(bb.left, kid_bb.left + offset), std::max(bb.right, kid_bb.right + offset)};
+    }
+
+    links.extreme_l = forest.extreme_l;
+    links.extreme_r = forest.extreme_r;
+    links.extreme_l_x = forest.extreme_l_x - half_dist;
+    links.extreme_r_x = forest.extreme_r_x - half_dist;
+
+    m_layout.setExtent(nid, bb, forest_height + 1);
+    m_layout.setLayoutDone(nid, true);
+}
+
+void ContourLayoutCursor::processCurrentNode()
+{
+    if (m_layout.isDirty(cur_node()))
+    {
+        computeForNode(cur_node());
+        m_layout.setDirty(cur_node(), false);
+    }
+}
+
+void ContourLayoutCursor::finalize()
+{
+}
+
+} // namespace tree
+} // namespace cpprofiler
@@ -0,0 +1,96 @@
+#ifndef CPPROFILER_TREE_CURSORS_CONTOUR_LAYOUT_CURSOR
+#define CPPROFILER_TREE_CURSORS_CONTOUR_LAYOUT_CURSOR
+
+#include <memory>
+#include "node_cursor.hh"
+#include "../shape.hh"
+
+namespace cpprofiler
+{
+namespace tree
+{
+
+class Layout;
+class VisualFlags;
+
+using ShapeUniqPtr = std::unique_ptr<Shape, ShapeDeleter>;
+
+/// Reads the contours of subtrees laid out in `LayoutMode::Contours`
+class ContourWalker
+{
+    const NodeTree &tree_;
+    const VisualFlags &m_vis_flags;
+    const Layout &m_layout;
+
+    const bool debug_mode_;
+
+  public:
+    /// The outline of a node on its own: the extent of its top level and
+    /// of the remaining levels (hidden nodes and lanterns take several)
+    struct Element
+    {
+        Extent top;
+        Extent rest;
+        int levels;
+
+        const Extent &at(int level) const { return level == 0 ? top : rest; }
+    };
+
+    /// A point on a contour: level `level` of the element of `node` at `x`
+    struct ContourPos
+    {
+        NodeID node;
+        int x;
+        int level;
+        Element element;
+
+        Extent extent() const
+        {
+            const auto &e = element.at(level);
+            return {x + e.l, x + e.r};
+        }
+    };
+
+    ContourWalker(const NodeTree &tree, const VisualFlags &nf, const Layout &lo, bool debug);
+
+    Element element(NodeID nid) const;
+
+    ContourPos contourPos(NodeID nid, int x, int level) const;
+
+    /// Move `pos` one level down the left (right) contour
+    void descend(ContourPos &pos, bool left) const;
+
+    /// The shape of the (laid out) subtree of `nid`, read off its contours
+    ShapeUniqPtr shapeOf(NodeID nid) const;
+};
+
+/// Layout cursor for `LayoutMode::Contours`: instead of a shape per node,
+/// subtrees are placed by walking the left and right contours of their
+/// siblings, which are linked by threads where one subtree is shallower
+/// than another (Reingold-Tilford); the positions are the same as those
+/// computed by `LayoutCursor`
+class ContourLayoutCursor : public NodeCursor
+{
+
+    Layout &m_layout;
+    const NodeTree &tree_;
+    const VisualFlags &m_vis_flags;
+
+    const ContourWalker walker_;
+
+  public:
+    ContourLayoutCursor(NodeID start, const NodeTree &tree, const VisualFlags &nf, Layout &lo, bool debug);
+
+    void computeForNode(NodeID nid);
+
+    bool mayMoveDownwards();
+
+    void processCurrentNode();
+
+    void finalize();
+};
+
+} // namespace tree
+} // namespace cpprofiler
+
+#endif
@@ -9,6 +9,7 @@
 #include "../traditional_view.hh"
 
 #include "../node_drawing.hh"
+#include "contour_layout_cursor.hh"
 
 #include "../node_tree.hh"
 
@@ -99,7 +100,7 @@ static void drawTriangle(QPainter &painter, int x, int y, bool selected, bool ha
     painter.drawConvexPolygon(points, 3);
 }
 
-static void drawShape(QPainter &painter, int x, int y, NodeID nid, const Layout &layout)
+static void drawShape(QPainter &painter, int x, int y, const Shape &shape)
 {
     using namespace traditional;
 
@@ -109,8 +110,6 @@ static void drawShape(QPainter &painter, int x, int y, NodeID nid, const Layout
     painter.setBrush(QColor{0, 0, 0, 50});
     painter.setPen(Qt::NoPen);
 
-    const auto &shape = *layout.getShape(nid);
-
     const int height = shape.height();
     QPointF *points = new QPointF[height * 2];
 
@@ -171,7 +170,8 @@ void DrawingCursor::processCurrentNode()
 
         auto draw_left = !utils::is_right_most_child(tree_, node);
         // painter_.setPen(QPen{Qt::black, 2});
-        const Label &label = debug_mode_ ? std::to_string(node) : tree_.getLabel(node);
+        const Label debug_label = debug_mode_ ? std::to_string(node) : Label{};
+        const Label &label = debug_mode_ ? debug_label : tree_.getLabel(node);
 
         auto fm = painter_.fontMetrics();
         auto label_width = fm.horizontalAdvance(label.c_str());
@@ -197,7 +197,15 @@ void DrawingCursor::processCurrentNode()
 
     if (vis_flags_.isHighlighted(node))
     {
-        drawShape(painter_, cur_x, cur_y, node, layout_);
+        if (layout_.mode() == LayoutMode::Shapes)
+        {
+            drawShape(painter_, cur_x, cur_y, *layout_.getShape(node));
+        }
+        else
+        {
+            const auto shape = ContourWalker(tree_, vis_flags_, layout_, debug_mode_).shapeOf(node);
+            drawShape(painter_, cur_x, cur_y, *shape);
+        }
     }
 
     const auto sel_node = user_data_.getSelectedNode();
@@ -1,5 +1,6 @@
 
 #include "layout_cursor.hh"
+#include "contour_layout_cursor.hh"
 #include "../../config.hh"
 #include "../node_id.hh"
 #include <iostream>
@@ -10,6 +11,7 @@
 #include "../node_tree.hh"
 #include "../structure.hh"
 #include "../shape.hh"
+#include "../extent_kernels.hh"
 #include "../../config.hh"
 #include "../../utils/tree_utils.hh"
 #include "../../utils/debug.hh"
@@ -52,15 +54,7 @@ static int distance_between(const Shape &s1, const Shape &s2)
 {
     const auto common_depth = std::min(s1.height(), s2.height());
 
-    auto max = INT_MIN;
-    for (auto i = 0; i < common_depth; ++i)
-    {
-        auto cur_dist = s1[i].r - s2[i].l;
-        if (cur_dist > max)
-            max = cur_dist;
-    }
-
-    return max + layout::min_dist_x;
+    return extent_kernels::max_difference(s1.rights(), s2.lefts(), common_depth) + layout::min_dist_x;
 }
 
 /// Combine shapes s1 and s2 to form a shape of a shape for the parent node;
@@ -91,22 +85,20 @@ static ShapeUniqPtr combine_shapes(const Shape &s1, const Shape &s2, std::vector
     offsets[1] = half_dist;
 
     /// Calculate extents for levels shared by both shapes
-    for (auto depth = 0; depth < common_depth; ++depth)
-    {
-        (*combined)[depth + 1] = {s1[depth].l - half_dist, s2[depth].r + half_dist};
-    }
+    extent_kernels::shifted_copy(s1.lefts(), -half_dist, combined->lefts() + 1, common_depth);
+    extent_kernels::shifted_copy(s2.rights(), half_dist, combined->rights() + 1, common_depth);
 
     /// Calculate extents for levels where only one subtree has nodes
     if (max_depth != common_depth)
     {
         const auto &longer_shape = depth_left > depth_right ? s1 : s2;
         const int offset = depth_left > depth_right ? -half_dist : half_dist;
+        const auto rest = max_depth - common_depth;
 
-        for (auto depth = common_depth; depth < max_depth; ++depth)
-        {
-            (*combined)[depth + 1] = {longer_shape[depth].l + offset,
-                                      longer_shape[depth].r + offset};
-        }
+        extent_kernels::shifted_copy(longer_shape.lefts() + common_depth, offset,
+                                     combined->lefts() + 1 + common_depth, rest);
+        extent_kernels::shifted_copy(longer_shape.rights() + common_depth, offset,
+                                     combined->rights() + 1 + common_depth, rest);
     }
 
     return std::move(combined);
@@ -139,28 +131,26 @@ static Shape merge_left(const Shape &s1, const Shape &s2, int &dist)
     }
 
     /// Calculate extents for levels shared by both shapes
-    for (auto depth = 0; depth < common_depth; ++depth)
-    {
-        result[depth] = {s1[depth].l, s2[depth].r + distance};
-    }
+    extent_kernels::shifted_copy(s1.lefts(), 0, result.lefts(), common_depth);
+    extent_kernels::shifted_copy(s2.rights(), distance, result.rights(), common_depth);
 
     /// Calculate extents for levels where only one subtree has nodes
     if (max_depth != common_depth)
     {
         const auto &longer_shape = depth_left > depth_right ? s1 : s2;
         const int offset = depth_left > depth_right ? 0 : distance;
+        const auto rest = max_depth - common_depth;
 
-        for (auto depth = common_depth; depth < max_depth; ++depth)
-        {
-            result[depth] = {longer_shape[depth].l + offset,
-                             longer_shape[depth].r + offset};
-        }
+        extent_kernels::shifted_copy(longer_shape.lefts() + common_depth, offset,
+                                     result.lefts() + common_depth, rest);
+        extent_kernels::shifted_copy(longer_shape.rights() + common_depth, offset,
+                                     result.rights() + common_depth, rest);
     }
 
     return result;
 }
 
-static Extent calculateForSingleNode(NodeID nid, const NodeTree &nt, bool label_shown, bool hidden, bool debug)
+Extent calculateForSingleNode(NodeID nid, const NodeTree &nt, bool label_shown, bool hidden, bool debug)
 {
 
     Extent result{-traditional::HALF_MAX_NODE_W, traditional::HALF_MAX_NODE_W};
@@ -175,8 +165,8 @@ static Extent calculateForSingleNode(NodeID nid, const NodeTree &nt, bool label_
         return result;
 
     /// TODO: use font metrics?
-    const auto &label = debug ? std::to_string(nid) : nt.getLabel(nid);
-    auto label_width = label.size() * 9;
+    const auto label_size = debug ? std::to_string(nid).size() : nt.getLabel(nid).size();
+    auto label_width = label_size * 9;
 
     /// Note: this assumes that the default painter used for drawing text
     // QPainter painter;
@@ -211,14 +201,15 @@ inline static void computeForNodeBinary(NodeID nid, Layout &layout, const NodeTr
     std::vector<int> offsets(2);
     auto combined = combine_shapes(s1, s2, offsets);
 
-    (*combined)[0] = calculateForSingleNode(nid, nt, label_shown, false, debug);
+    const auto top = calculateForSingleNode(nid, nt, label_shown, false, debug);
+    combined->setExtent(0, top);
 
     /// Extents for root node changed -> check if bounding box is correct
     const auto &bb = combined->boundingBox();
 
-    if (bb.left > (*combined)[0].l || bb.right < (*combined)[0].r)
+    if (bb.left > top.l || bb.right < top.r)
     {
-        combined->setBoundingBox({std::min(bb.left, (*combined)[0].l), std::max(bb.right, (*combined)[0].r)});
+        combined->setBoundingBox({std::min(bb.left, top.l), std::max(bb.right, top.r)});
     }
 
     layout.setShape(nid, std::move(combined));
@@ -227,100 +218,147 @@ inline static void computeForNodeBinary(NodeID nid, Layout &layout, const NodeTr
     layout.setChildOffset(kid_r, offsets[1]);
 }
 
-inline static std::vector<int> compute_distances(NodeID nid, int nkids, Layout &lo, const NodeTree &tree)
+/// Position at which `shape` can be placed to the right of the sibling
+/// shapes whose combined extents are `skyline`
+static int contour_position(const Skyline &skyline, const Shape &shape)
 {
-    std::vector<int> distances(nkids - 1);
+    if (skyline.empty())
+        return 0;
 
-    for (auto i = 0; i < nkids - 1; ++i)
-    {
-        auto kid_l = tree.getChild(nid, i);
-        auto kid_r = tree.getChild(nid, i + 1);
-        const auto &s1 = *lo.getShape(kid_l);
-        const auto &s2 = *lo.getShape(kid_r);
-        distances[i] = distance_between(s1, s2);
-    }
+    const auto common_depth = std::min(skyline.height(), shape.height());
 
-    return distances;
+    return extent_kernels::max_difference(skyline.rights.data(), shape.lefts(), common_depth) +
+           layout::min_dist_x;
 }
 
-inline static int kids_max_depth(NodeID nid, int nkids, const Layout &lo, const NodeTree &tree)
+/// Add `shape` placed at `x` to `skyline`
+static void merge_into_contour(Skyline &skyline, const Shape &shape, int x)
 {
-    int max_depth = 0;
-    for (auto i = 0; i < nkids; ++i)
+    const auto common_depth = std::min(skyline.height(), shape.height());
+
+    extent_kernels::min_shifted(skyline.lefts.data(), shape.lefts(), x, common_depth);
+    extent_kernels::max_shifted(skyline.rights.data(), shape.rights(), x, common_depth);
+
+    if (shape.height() > common_depth)
     {
-        auto kid = tree.getChild(nid, i);
-        const auto &s1 = *lo.getShape(kid);
-        max_depth = std::max(max_depth, s1.height());
+        skyline.lefts.resize(shape.height());
+        skyline.rights.resize(shape.height());
+
+        const auto rest = shape.height() - common_depth;
+        extent_kernels::shifted_copy(shape.lefts() + common_depth, x, skyline.lefts.data() + common_depth, rest);
+        extent_kernels::shifted_copy(shape.rights() + common_depth, x, skyline.rights.data() + common_depth, rest);
     }
-    return max_depth;
 }
 
-static inline void computeForNodeNary(NodeID nid, int nkids, Layout &layout, const NodeTree &tree, bool debug)
+/// The shape of a node with extents `top` above `skyline` moved by `shift`
+static ShapeUniqPtr shape_above(Extent top, const Skyline &skyline, int shift)
 {
+    const auto depth = skyline.height();
 
-    /// calculate all distances
-    const auto distances = compute_distances(nid, nkids, layout, tree);
+    auto combined = ShapeUniqPtr(new Shape{depth + 1});
 
-    /// distance between the leftmost and the rightmost nodes
-    int max_dist = 0;
-    for (auto distance : distances)
-    {
-        max_dist += distance;
-    }
+    combined->setExtent(0, top);
+    extent_kernels::shifted_copy(skyline.lefts.data(), shift, combined->lefts() + 1, depth);
+    extent_kernels::shifted_copy(skyline.rights.data(), shift, combined->rights() + 1, depth);
 
-    /// calculate the depth of the resulting shape
-    const auto new_depth = kids_max_depth(nid, nkids, layout, tree) + 1;
+    const auto lefts = combined->lefts();
+    const auto rights = combined->rights();
+    combined->setBoundingBox({*std::min_element(lefts, lefts + depth + 1),
+                              *std::max_element(rights, rights + depth + 1)});
 
-    auto combined = ShapeUniqPtr(new Shape{new_depth});
+    return combined;
+}
 
+/// Siblings are placed one by one against the combined extents of those
+/// on their left, so that the cost is linear in the size of their shapes
+/// (a node might have thousands of children)
+static inline void computeForNodeNary(NodeID nid, int nkids, Layout &layout, const NodeTree &tree, bool debug)
+{
+    Skyline skyline;
     std::vector<int> x_offsets(nkids);
-    /// calculate offsets
-    auto cur_x = -max_dist / 2;
-    for (auto i = 0; i < nkids; ++i)
+
+    for (auto alt = 0; alt < nkids; ++alt)
     {
-        const auto kid = tree.getChild(nid, i);
-        layout.setChildOffset(kid, cur_x);
-        x_offsets[i] = cur_x;
-        if (i < nkids - 1) {
-            cur_x += distances[i];
-        }
+        const auto &shape = *layout.getShape(tree.getChild(nid, alt));
+
+        x_offsets[alt] = contour_position(skyline, shape);
+        merge_into_contour(skyline, shape, x_offsets[alt]);
+    }
+
+    /// center the node above its children
+    const auto half_dist = x_offsets.back() / 2;
+
+    for (auto alt = 0; alt < nkids; ++alt)
+    {
+        layout.setChildOffset(tree.getChild(nid, alt), x_offsets[alt] - half_dist);
     }
 
-    /// calculate extents
     /// TODO: does this need to take labels into account?
-    (*combined)[0] = {-traditional::HALF_MAX_NODE_W, traditional::HALF_MAX_NODE_W};
-    for (auto depth = 1; depth < new_depth; ++depth)
+    const Extent top{-traditional::HALF_MAX_NODE_W, traditional::HALF_MAX_NODE_W};
+
+    layout.setShape(nid, shape_above(top, skyline, -half_dist));
+}
+
+const Shape &LayoutCursor::subtreeShape(NodeID nid, ShapeUniqPtr &owned) const
+{
+    if (m_layout.mode() == LayoutMode::Shapes)
+        return *m_layout.getShape(nid);
+
+    owned = ContourWalker(tree_, m_vis_flags, m_layout, debug_mode_).shapeOf(nid);
+    return *owned;
+}
+
+void LayoutCursor::computeForRestarts(NodeID root, int frozen)
+{
+    auto &contour = m_layout.restartContour();
+    const auto nkids = tree_.childrenCount(root);
+
+    /// frozen restarts are placed against the contour once
+    for (; contour.merged < std::min(frozen, nkids); ++contour.merged)
     {
+        const auto kid = tree_.getChild(root, contour.merged);
+        ShapeUniqPtr owned;
+        const auto &shape = subtreeShape(kid, owned);
 
-        auto leftmost_x = INT_MAX;
-        auto rightmost_x = INT_MIN;
-        for (auto alt = 0; alt < nkids; ++alt)
-        {
-            const auto kid = tree.getChild(nid, alt);
-            const auto &shape = *layout.getShape(kid);
-            if (shape.height() > depth - 1)
-            {
-                leftmost_x = std::min(leftmost_x, shape[depth - 1].l + x_offsets[alt]);
-                rightmost_x = std::max(leftmost_x, shape[depth - 1].r + x_offsets[alt]);
-            }
-        }
+        const auto x = contour_position(contour.extents, shape);
+        m_layout.setChildOffset(kid, x);
+        merge_into_contour(contour.extents, shape, x);
+    }
 
-        (*combined)[depth].l = leftmost_x;
-        (*combined)[depth].r = rightmost_x;
+    /// the remaining restarts may still change: place them against a copy
+    auto extents = contour.extents;
+
+    for (auto alt = contour.merged; alt < nkids; ++alt)
+    {
+        const auto kid = tree_.getChild(root, alt);
+        ShapeUniqPtr owned;
+        const auto &shape = subtreeShape(kid, owned);
+
+        const auto x = contour_position(extents, shape);
+        m_layout.setChildOffset(kid, x);
+        merge_into_contour(extents, shape, x);
     }
 
-    /// calculate bounding box
-    int l_bound = INT_MAX;
-    int r_bound = INT_MIN;
-    for (auto depth = 0; depth < new_depth; ++depth)
+    contour.laid_out = nkids;
+
+    const auto top = calculateForSingleNode(root, tree_, m_vis_flags.isLabelShown(root), false, debug_mode_);
+    auto combined = shape_above(top, extents, 0);
+
+    if (m_layout.mode() == LayoutMode::Shapes)
+    {
+        m_layout.setShape(root, std::move(combined));
+    }
+    else
     {
-        l_bound = std::min((*combined)[depth].l, l_bound);
-        r_bound = std::max((*combined)[depth].r, r_bound);
+        m_layout.setExtent(root, combined->boundingBox(), combined->height());
     }
 
-    combined->setBoundingBox({l_bound, r_bound});
+    m_layout.setLayoutDone(root, true);
+}
 
-    layout.setShape(nid, std::move(combined));
+int lantern_levels(int size)
+{
+    return std::ceil((size * lantern::K + lantern::BASE_HEIGHT) / (float)layout::dist_y) + 1;
 }
 
 /// Calculate shape for sized rectangle (lantern); size is between 0 and 127
@@ -329,13 +367,13 @@ static ShapeUniqPtr calc_for_sized_rect(int size)
 
     // using namespace lantern;
 
-    int levels = std::ceil((size * lantern::K + lantern::BASE_HEIGHT) / (float)layout::dist_y) + 1;
+    int levels = lantern_levels(size);
 
     auto shape = ShapeUniqPtr(new Shape(levels));
 
     for (auto i = 0u; i < levels; ++i)
     {
-        (*shape)[i] = {-lantern::HALF_WIDTH, lantern::HALF_WIDTH};
+        shape->setExtent(i, {-lantern::HALF_WIDTH, lantern::HALF_WIDTH});
     }
 
     shape->setBoundingBox({-lantern::HALF_WIDTH, lantern::HALF_WIDTH});
@@ -361,8 +399,9 @@ void LayoutCursor::computeForNode(NodeID nid)
             if (label_shown)
             {
                 /// overriting the first extent in case of a label
-                (*shape)[0] = calculateForSingleNode(nid, tree_, label_shown, true, debug_mode_);
-                shape->setBoundingBox({(*shape)[0].l, (*shape)[0].r});
+                shape->setExtent(0, calculateForSingleNode(nid, tree_, label_shown, true, debug_mode_));
+                shape->setBoundingBox({std::min((*shape)[0].l, -lantern::HALF_WIDTH),
+                                       std::max((*shape)[0].r, lantern::HALF_WIDTH)});
             }
             m_layout.setShape(nid, std::move(shape));
         }
@@ -377,8 +416,8 @@ void LayoutCursor::computeForNode(NodeID nid)
             else
             {
                 auto shape = ShapeUniqPtr{new Shape{2}};
-                (*shape)[0] = calculateForSingleNode(nid, tree_, label_shown, true, debug_mode_);
-                (*shape)[1] = (*shape)[0];
+                shape->setExtent(0, calculateForSingleNode(nid, tree_, label_shown, true, debug_mode_));
+                shape->setExtent(1, (*shape)[0]);
                 shape->setBoundingBox({(*shape)[0].l, (*shape)[0].r});
                 m_layout.setShape(nid, std::move(shape));
             }
@@ -399,7 +438,7 @@ void LayoutCursor::computeForNode(NodeID nid)
             else
             {
                 auto shape = ShapeUniqPtr{new Shape{1}};
-                (*shape)[0] = calculateForSingleNode(nid, tree_, label_shown, false, debug_mode_);
+                shape->setExtent(0, calculateForSingleNode(nid, tree_, label_shown, false, debug_mode_));
 
                 shape->setBoundingBox({(*shape)[0].l, (*shape)[0].r});
                 m_layout.setShape(nid, std::move(shape));
@@ -413,14 +452,14 @@ void LayoutCursor::computeForNode(NodeID nid)
 
             auto shape = ShapeUniqPtr(new Shape(kid_s.height() + 1));
 
-            (*shape)[0] = calculateForSingleNode(nid, tree_, label_shown, false, debug_mode_);
+            shape->setExtent(0, calculateForSingleNode(nid, tree_, label_shown, false, debug_mode_));
 
-            for (auto depth = 0; depth < kid_s.height(); depth++)
-            {
-                (*shape)[depth + 1] = kid_s[depth];
-            }
+            extent_kernels::shifted_copy(kid_s.lefts(), 0, shape->lefts() + 1, kid_s.height());
+            extent_kernels::shifted_copy(kid_s.rights(), 0, shape->rights() + 1, kid_s.height());
 
-            shape->setBoundingBox(kid_s.boundingBox());
+            /// the node's own extents (e.g. its label) may stick out
+            const auto &bb = kid_s.boundingBox();
+            shape->setBoundingBox({std::min(bb.left, (*shape)[0].l), std::max(bb.right, (*shape)[0].r)});
 
             m_layout.setChildOffset(kid, 0);
 
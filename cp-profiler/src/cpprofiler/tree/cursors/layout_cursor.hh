@@ -2,6 +2,7 @@
 #define CPPROFILER_TREE_CURSORS_LAYOUT_CURSOR
 
 #include <vector>
+#include <memory>
 #include <QPainter>
 #include "node_cursor.hh"
 
@@ -12,6 +13,18 @@ namespace tree
 
 class Layout;
 class VisualFlags;
+class Extent;
+class Shape;
+class ShapeDeleter;
+
+using ShapeUniqPtr = std::unique_ptr<Shape, ShapeDeleter>;
+
+/// Extents of node `nid` on its own (without its children), taking
+/// its label into account if `label_shown`
+Extent calculateForSingleNode(NodeID nid, const NodeTree &nt, bool label_shown, bool hidden, bool debug);
+
+/// Number of levels occupied by a lantern of size `size` (between 0 and 127)
+int lantern_levels(int size);
 
 class LayoutCursor : public NodeCursor
 {
@@ -24,12 +37,21 @@ class LayoutCursor : public NodeCursor
 
     const bool debug_mode_;
 
+    /// The shape of the subtree of `nid`; in `LayoutMode::Contours` it is
+    /// built from the subtree's contours and kept in `owned`
+    const Shape &subtreeShape(NodeID nid, ShapeUniqPtr &owned) const;
+
   public:
     // Constructor
     LayoutCursor(NodeID start, const NodeTree &tree, const VisualFlags &nf, Layout &lo, bool debug);
 
     void computeForNode(NodeID nid);
 
+    /// Compute the shape of the root of an execution with restarts (whose
+    /// children, the restarts, must have their shapes computed); restarts
+    /// below `frozen` are merged into the layout's restart contour for good
+    void computeForRestarts(NodeID root, int frozen);
+
     bool mayMoveDownwards();
 
     void processCurrentNode();
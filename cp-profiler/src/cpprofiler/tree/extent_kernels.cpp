@@ -0,0 +1,304 @@
+#include "extent_kernels.hh"
+
+#include <algorithm>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CPPROFILER_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace cpprofiler
+{
+namespace tree
+{
+namespace extent_kernels
+{
+
+static int max_difference_scalar(const int *a, const int *b, int n)
+{
+    auto max = INT_MIN;
+    for (auto i = 0; i < n; ++i)
+    {
+        max = std::max(max, a[i] - b[i]);
+    }
+    return max;
+}
+
+static void shifted_copy_scalar(const int *src, int delta, int *dst, int n)
+{
+    for (auto i = 0; i < n; ++i)
+    {
+        dst[i] = src[i] + delta;
+    }
+}
+
+static void min_shifted_scalar(int *dst, const int *src, int delta, int n)
+{
+    for (auto i = 0; i < n; ++i)
+    {
+        dst[i] = std::min(dst[i], src[i] + delta);
+    }
+}
+
+static void max_shifted_scalar(int *dst, const int *src, int delta, int n)
+{
+    for (auto i = 0; i < n; ++i)
+    {
+        dst[i] = std::max(dst[i], src[i] + delta);
+    }
+}
+
+static int first_mismatch_scalar(const int *a1, const int *a2, const int *b1, const int *b2, int n)
+{
+    auto i = 0;
+    while (i < n && a1[i] == b1[i] && a2[i] == b2[i])
+    {
+        ++i;
+    }
+    return i;
+}
+
+static const Kernels scalar_kernels{max_difference_scalar, shifted_copy_scalar, min_shifted_scalar,
+                                    max_shifted_scalar, first_mismatch_scalar};
+
+#ifdef CPPROFILER_X86_KERNELS
+
+/// Kernels below process 4 (SSE4.1) or 8 (AVX2) extents at a time, using
+/// unaligned loads, and finish the remaining ones with the scalar versions
+
+#define CPPROFILER_LOAD128(p) _mm_loadu_si128(reinterpret_cast<const __m128i *>(p))
+#define CPPROFILER_STORE128(p, v) _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v)
+#define CPPROFILER_LOAD256(p) _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p))
+#define CPPROFILER_STORE256(p, v) _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v)
+
+__attribute__((target("sse4.1"))) static int max_difference_sse41(const int *a, const int *b, int n)
+{
+    auto max = _mm_set1_epi32(INT_MIN);
+
+    auto i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        max = _mm_max_epi32(max, _mm_sub_epi32(CPPROFILER_LOAD128(a + i), CPPROFILER_LOAD128(b + i)));
+    }
+
+    int lanes[4];
+    CPPROFILER_STORE128(lanes, max);
+
+    return std::max({lanes[0], lanes[1], lanes[2], lanes[3], max_difference_scalar(a + i, b + i, n - i)});
+}
+
+__attribute__((target("sse4.1"))) static void shifted_copy_sse41(const int *src, int delta, int *dst, int n)
+{
+    const auto d = _mm_set1_epi32(delta);
+
+    auto i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        CPPROFILER_STORE128(dst + i, _mm_add_epi32(CPPROFILER_LOAD128(src + i), d));
+    }
+
+    shifted_copy_scalar(src + i, delta, dst + i, n - i);
+}
+
+__attribute__((target("sse4.1"))) static void min_shifted_sse41(int *dst, const int *src, int delta, int n)
+{
+    const auto d = _mm_set1_epi32(delta);
+
+    auto i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        const auto shifted = _mm_add_epi32(CPPROFILER_LOAD128(src + i), d);
+        CPPROFILER_STORE128(dst + i, _mm_min_epi32(CPPROFILER_LOAD128(dst + i), shifted));
+    }
+
+    min_shifted_scalar(dst + i, src + i, delta, n - i);
+}
+
+__attribute__((target("sse4.1"))) static void max_shifted_sse41(int *dst, const int *src, int delta, int n)
+{
+    const auto d = _mm_set1_epi32(delta);
+
+    auto i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        const auto shifted = _mm_add_epi32(CPPROFILER_LOAD128(src + i), d);
+        CPPROFILER_STORE128(dst + i, _mm_max_epi32(CPPROFILER_LOAD128(dst + i), shifted));
+    }
+
+    max_shifted_scalar(dst + i, src + i, delta, n - i);
+}
+
+__attribute__((target("sse4.1"))) static int first_mismatch_sse41(const int *a1, const int *a2, const int *b1, const int *b2, int n)
+{
+    auto i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        const auto eq1 = _mm_cmpeq_epi32(CPPROFILER_LOAD128(a1 + i), CPPROFILER_LOAD128(b1 + i));
+        const auto eq2 = _mm_cmpeq_epi32(CPPROFILER_LOAD128(a2 + i), CPPROFILER_LOAD128(b2 + i));
+        const auto mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(eq1, eq2)));
+
+        if (mask != 0xF)
+            return i + __builtin_ctz(~mask);
+    }
+
+    return i + first_mismatch_scalar(a1 + i, a2 + i, b1 + i, b2 + i, n - i);
+}
+
+static const Kernels sse41_kernels{max_difference_sse41, shifted_copy_sse41, min_shifted_sse41,
+                                   max_shifted_sse41, first_mismatch_sse41};
+
+__attribute__((target("avx2"))) static int max_difference_avx2(const int *a, const int *b, int n)
+{
+    auto max = _mm256_set1_epi32(INT_MIN);
+
+    auto i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        max = _mm256_max_epi32(max, _mm256_sub_epi32(CPPROFILER_LOAD256(a + i), CPPROFILER_LOAD256(b + i)));
+    }
+
+    /// reduce the two halves, then the four lanes
+    auto half = _mm_max_epi32(_mm256_castsi256_si128(max), _mm256_extracti128_si256(max, 1));
+
+    int lanes[4];
+    CPPROFILER_STORE128(lanes, half);
+
+    return std::max({lanes[0], lanes[1], lanes[2], lanes[3], max_difference_scalar(a + i, b + i, n - i)});
+}
+
+__attribute__((target("avx2"))) static void shifted_copy_avx2(const int *src, int delta, int *dst, int n)
+{
+    const auto d = _mm256_set1_epi32(delta);
+
+    auto i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        CPPROFILER_STORE256(dst + i, _mm256_add_epi32(CPPROFILER_LOAD256(src + i), d));
+    }
+
+    shifted_copy_scalar(src + i, delta, dst + i, n - i);
+}
+
+__attribute__((target("avx2"))) static void min_shifted_avx2(int *dst, const int *src, int delta, int n)
+{
+    const auto d = _mm256_set1_epi32(delta);
+
+    auto i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const auto shifted = _mm256_add_epi32(CPPROFILER_LOAD256(src + i), d);
+        CPPROFILER_STORE256(dst + i, _mm256_min_epi32(CPPROFILER_LOAD256(dst + i), shifted));
+    }
+
+    min_shifted_scalar(dst + i, src + i, delta, n - i);
+}
+
+__attribute__((target("avx2"))) static void max_shifted_avx2(int *dst, const int *src, int delta, int n)
+{
+    const auto d = _mm256_set1_epi32(delta);
+
+    auto i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const auto shifted = _mm256_add_epi32(CPPROFILER_LOAD256(src + i), d);
+        CPPROFILER_STORE256(dst + i, _mm256_max_epi32(CPPROFILER_LOAD256(dst + i), shifted));
+    }
+
+    max_shifted_scalar(dst + i, src + i, delta, n - i);
+}
+
+__attribute__((target("avx2"))) static int first_mismatch_avx2(const int *a1, const int *a2, const int *b1, const int *b2, int n)
+{
+    auto i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const auto eq1 = _mm256_cmpeq_epi32(CPPROFILER_LOAD256(a1 + i), CPPROFILER_LOAD256(b1 + i));
+        const auto eq2 = _mm256_cmpeq_epi32(CPPROFILER_LOAD256(a2 + i), CPPROFILER_LOAD256(b2 + i));
+        const auto mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(eq1, eq2)));
+
+        if (mask != 0xFF)
+            return i + __builtin_ctz(~mask);
+    }
+
+    return i + first_mismatch_scalar(a1 + i, a2 + i, b1 + i, b2 + i, n - i);
+}
+
+static const Kernels avx2_kernels{max_difference_avx2, shifted_copy_avx2, min_shifted_avx2,
+                                  max_shifted_avx2, first_mismatch_avx2};
+
+#endif
+
+bool supported(Isa isa)
+{
+#ifdef CPPROFILER_X86_KERNELS
+    /// may be called by static initializers (before the CPU is inspected)
+    __builtin_cpu_init();
+
+    switch (isa)
+    {
+    case Isa::AVX2:
+        return __builtin_cpu_supports("avx2");
+    case Isa::SSE41:
+        return __builtin_cpu_supports("sse4.1");
+    case Isa::Scalar:
+        return true;
+    }
+#endif
+    return isa == Isa::Scalar;
+}
+
+Isa best_isa()
+{
+    if (supported(Isa::AVX2))
+        return Isa::AVX2;
+    if (supported(Isa::SSE41))
+        return Isa::SSE41;
+    return Isa::Scalar;
+}
+
+const char *isa_name(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::AVX2:
+        return "avx2";
+    case Isa::SSE41:
+        return "sse4.1";
+    case Isa::Scalar:
+        break;
+    }
+    return "scalar";
+}
+
+static const Kernels *kernels_for(Isa isa)
+{
+#ifdef CPPROFILER_X86_KERNELS
+    if (isa == Isa::AVX2)
+        return &avx2_kernels;
+    if (isa == Isa::SSE41)
+        return &sse41_kernels;
+#endif
+    return &scalar_kernels;
+}
+
+/// the scalar kernels are used until the CPU has been inspected
+const Kernels *detail::active = &scalar_kernels;
+
+static Isa current = Isa::Scalar;
+
+void use_isa(Isa isa)
+{
+    current = supported(isa) ? isa : Isa::Scalar;
+    detail::active = kernels_for(current);
+}
+
+static const bool dispatched = (use_isa(best_isa()), true);
+
+Isa current_isa()
+{
+    return current;
+}
+
+} // namespace extent_kernels
+} // namespace tree
+} // namespace cpprofiler
@@ -0,0 +1,127 @@
+#ifndef CPPROFILER_TREE_EXTENT_KERNELS_HH
+#define CPPROFILER_TREE_EXTENT_KERNELS_HH
+
+#include <climits>
+
+namespace cpprofiler
+{
+namespace tree
+{
+
+/// Loops over the (separately stored) left or right extents of shapes; the
+/// implementation is picked at start-up according to the instruction sets
+/// supported by the CPU (AVX2, SSE4.1 or plain C++)
+namespace extent_kernels
+{
+
+enum class Isa
+{
+    Scalar,
+    SSE41,
+    AVX2
+};
+
+/// Function table of one implementation
+struct Kernels
+{
+    int (*max_difference)(const int *a, const int *b, int n);
+    void (*shifted_copy)(const int *src, int delta, int *dst, int n);
+    void (*min_shifted)(int *dst, const int *src, int delta, int n);
+    void (*max_shifted)(int *dst, const int *src, int delta, int n);
+    int (*first_mismatch)(const int *a1, const int *a2, const int *b1, const int *b2, int n);
+};
+
+/// The best implementation supported by this CPU
+Isa best_isa();
+
+/// Name of `isa` (for diagnostics)
+const char *isa_name(Isa isa);
+
+/// Whether `isa` can be used on this CPU
+bool supported(Isa isa);
+
+/// Select the implementation used from now on (meant for tests and
+/// benchmarks; must not be called while layout is computed)
+void use_isa(Isa isa);
+
+/// The implementation in use
+Isa current_isa();
+
+namespace detail
+{
+extern const Kernels *active;
+
+/// Shorter arrays are not worth a call through the function table
+static constexpr int MIN_VECTOR_SIZE = 8;
+} // namespace detail
+
+/// max(a[i] - b[i]) over i < n (INT_MIN if n is 0)
+inline int max_difference(const int *a, const int *b, int n)
+{
+    if (n >= detail::MIN_VECTOR_SIZE)
+        return detail::active->max_difference(a, b, n);
+
+    auto max = INT_MIN;
+    for (auto i = 0; i < n; ++i)
+    {
+        max = a[i] - b[i] > max ? a[i] - b[i] : max;
+    }
+    return max;
+}
+
+/// dst[i] = src[i] + delta for i < n
+inline void shifted_copy(const int *src, int delta, int *dst, int n)
+{
+    if (n >= detail::MIN_VECTOR_SIZE)
+        return detail::active->shifted_copy(src, delta, dst, n);
+
+    for (auto i = 0; i < n; ++i)
+    {
+        dst[i] = src[i] + delta;
+    }
+}
+
+/// dst[i] = min(dst[i], src[i] + delta) for i < n
+inline void min_shifted(int *dst, const int *src, int delta, int n)
+{
+    if (n >= detail::MIN_VECTOR_SIZE)
+        return detail::active->min_shifted(dst, src, delta, n);
+
+    for (auto i = 0; i < n; ++i)
+    {
+        dst[i] = src[i] + delta < dst[i] ? src[i] + delta : dst[i];
+    }
+}
+
+/// dst[i] = max(dst[i], src[i] + delta) for i < n
+inline void max_shifted(int *dst, const int *src, int delta, int n)
+{
+    if (n >= detail::MIN_VECTOR_SIZE)
+        return detail::active->max_shifted(dst, src, delta, n);
+
+    for (auto i = 0; i < n; ++i)
+    {
+        dst[i] = src[i] + delta > dst[i] ? src[i] + delta : dst[i];
+    }
+}
+
+/// The first i < n such that a1[i] != b1[i] or a2[i] != b2[i] (n if none)
+inline int first_mismatch(const int *a1, const int *a2, const int *b1, const int *b2, int n)
+{
+    if (n >= detail::MIN_VECTOR_SIZE)
+        return detail::active->first_mismatch(a1, a2, b1, b2, n);
+
+    auto i = 0;
+    while (i < n && a1[i] == b1[i] && a2[i] == b2[i])
+    {
+        ++i;
+    }
+    return i;
+}
+
+} // namespace extent_kernels
+
+} // namespace tree
+} // namespace cpprofiler
+
+#endif
@@ -0,0 +1,32 @@
+#include "label_pool.hh"
+
+namespace cpprofiler
+{
+namespace tree
+{
+
+constexpr LabelID LabelPool::EMPTY;
+
+LabelPool::LabelPool()
+{
+    intern(Label{});
+}
+
+LabelID LabelPool::intern(const Label &label)
+{
+    const auto it = ids_.find(&label);
+
+    if (it != ids_.end())
+    {
+        return it->second;
+    }
+
+    const auto id = static_cast<LabelID>(labels_.size());
+    labels_.push_back(label);
+    ids_.insert({&labels_[id], id});
+
+    return id;
+}
+
+} // namespace tree
+} // namespace cpprofiler
@@ -0,0 +1,64 @@
+#ifndef CPPROFILER_TREE_LABEL_POOL_HH
+#define CPPROFILER_TREE_LABEL_POOL_HH
+
+#include <cstdint>
+#include <unordered_map>
+
+#include "../core.hh"
+#include "../utils/chunked_vector.hh"
+
+namespace cpprofiler
+{
+namespace tree
+{
+
+using LabelID = int32_t;
+
+/// Stores every distinct label only once, so that nodes can refer to their
+/// labels by (32-bit) identifiers; equal labels always have equal identifiers.
+/// Labels can be read by other threads while new ones are being added.
+class LabelPool
+{
+
+    struct LabelPtrHash
+    {
+        size_t operator()(const Label *label) const
+        {
+            return std::hash<Label>{}(*label);
+        }
+    };
+
+    struct LabelPtrEqual
+    {
+        bool operator()(const Label *lhs, const Label *rhs) const
+        {
+            return *lhs == *rhs;
+        }
+    };
+
+    /// Distinct labels indexed by their ids (growing keeps references valid)
+    utils::ChunkedVector<Label, 10> labels_;
+
+    /// Mapping from a label (pointing into `labels_`) to its identifier
+    std::unordered_map<const Label *, LabelID, LabelPtrHash, LabelPtrEqual> ids_;
+
+  public:
+    /// The identifier of the empty label
+    static constexpr LabelID EMPTY = 0;
+
+    LabelPool();
+
+    /// Get the identifier of `label`, adding it to the pool if necessary
+    LabelID intern(const Label &label);
+
+    /// Get the label with identifier `id`
+    const Label &get(LabelID id) const { return labels_[id]; }
+
+    /// Get the number of distinct labels
+    int size() const { return labels_.size(); }
+};
+
+} // namespace tree
+} // namespace cpprofiler
+
+#endif
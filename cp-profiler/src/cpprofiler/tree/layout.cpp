@@ -10,9 +10,9 @@ namespace cpprofiler
 namespace tree
 {
 
-void Layout::setShape(NodeID nid, std::unique_ptr<Shape, ShapeDeleter> shape)
+void Layout::setShape(NodeID nid, ShapeUniqPtr shape)
 {
-    shapes_[nid] = std::move(shape);
+    shapes_[nid] = shape_pool_.intern(std::move(shape));
 }
 
 utils::Mutex &Layout::getMutex() const
@@ -20,7 +20,7 @@ utils::Mutex &Layout::getMutex() const
     return layout_;
 }
 
-Layout::Layout()
+Layout::Layout(LayoutMode mode) : mode_(mode)
 {
 }
 
@@ -28,6 +28,9 @@ Layout::~Layout() = default;
 
 int Layout::getHeight(NodeID nid) const
 {
+    if (mode_ == LayoutMode::Contours)
+        return heights_[nid];
+
     return getShape(nid)->height();
 }
 
@@ -46,10 +49,21 @@ bool Layout::getLayoutDone(NodeID nid) const
 void Layout::growDataStructures(int n_nodes)
 {
 
-    if (n_nodes > shapes_.size())
+    if (n_nodes > child_offsets_.size())
     {
         child_offsets_.resize(n_nodes, 0);
-        shapes_.resize(n_nodes);
+
+        if (mode_ == LayoutMode::Shapes)
+        {
+            shapes_.resize(n_nodes);
+        }
+        else
+        {
+            bounding_boxes_.resize(n_nodes);
+            heights_.resize(n_nodes, 0);
+            contours_.resize(n_nodes);
+        }
+
         layout_done_.resize(n_nodes, false);
         /// nodes start as dirty
         dirty_.resize(n_nodes, true);
@@ -9,6 +9,7 @@
 
 #include "../core.hh"
 #include "shape.hh"
+#include "shape_pool.hh"
 
 namespace cpprofiler
 {
@@ -23,23 +24,98 @@ class ShapeDeleter;
 
 using ShapeUniqPtr = std::unique_ptr<Shape, ShapeDeleter>;
 
+/// Combined outline of the frozen restarts of an execution with restarts:
+/// restarts are placed from left to right, with the root above the first one,
+/// so that a frozen restart is positioned once and never revisited
+struct RestartContour
+{
+    /// Number of (leftmost) restarts merged into `extents`
+    int merged = 0;
+    /// Number of restarts laid out at least once
+    int laid_out = 0;
+    /// Extents of the merged restarts by depth (relative to the first restart)
+    Skyline extents;
+};
+
+/// How the outline of a subtree is represented
+enum class LayoutMode
+{
+  /// Every node keeps the extents of its subtree at every depth (a `Shape`),
+  /// which takes memory proportional to the subtree's height
+  Shapes,
+  /// Nodes only keep links along the left and right contours of their subtrees
+  /// (Reingold-Tilford threads), which takes constant memory per node
+  Contours
+};
+
+/// A link from the bottom of a contour to where it continues
+/// (a node `level` levels below the top of its own outline)
+struct ContourThread
+{
+  NodeID node;
+  /// x of `node` relative to the node the thread starts at
+  int dx;
+  int level;
+};
+
+/// Contour information of a node (in `LayoutMode::Contours`)
+struct ContourLinks
+{
+  /// The leftmost and the rightmost of the deepest nodes of the subtree
+  NodeID extreme_l;
+  NodeID extreme_r;
+  /// x of the extremes relative to the node
+  int extreme_l_x;
+  int extreme_r_x;
+  /// Continuation of the left (right) contour of a subtree whose bottom is this node
+  ContourThread thread_l;
+  ContourThread thread_r;
+};
+
+/// Bounding box and height of the tree under a node
+struct TreeExtent
+{
+  BoundingBox bb;
+  int height;
+};
+
 class Layout : public QObject
 {
   Q_OBJECT
 
+  const LayoutMode mode_;
+
   mutable utils::Mutex layout_;
 
+  /// Interned shapes referred to by `shapes_` (must outlive them)
+  ShapePool shape_pool_;
+
   /// TODO: make sure this is always protected by a mutex
-  std::vector<ShapeUniqPtr> shapes_;
+  std::vector<ShapeHandle> shapes_;
 
   /// Relative offset from the parent node along the x axis
   std::vector<double> child_offsets_;
 
-  /// Whether layout for the node and its children is done (indexed by NodeID)
-  std::vector<bool> layout_done_;
+  /// Whether layout for the node and its children is done (indexed by NodeID);
+  /// a byte per node (rather than a bit) so that different threads can
+  /// lay out different subtrees
+  std::vector<char> layout_done_;
 
   /// Whether a node's shape need to be recomputed (indexed by NodeID)
-  std::vector<bool> dirty_;
+  std::vector<char> dirty_;
+
+  /// Outline of the frozen restarts (only used for executions with restarts)
+  RestartContour restart_contour_;
+
+  /// Bounding boxes, heights and contours of subtrees (`LayoutMode::Contours`
+  /// only, where nodes have no shapes)
+  std::vector<BoundingBox> bounding_boxes_;
+  std::vector<int> heights_;
+  std::vector<ContourLinks> contours_;
+
+  /// Extent of the tree as of the last complete layout pass
+  NodeID published_root_ = NodeID::NoNode;
+  TreeExtent published_;
 
 public:
   utils::Mutex &getMutex() const;
@@ -48,12 +124,21 @@ public:
 
   void setLayoutDone(NodeID nid, bool val) { layout_done_[nid] = val; }
 
+  LayoutMode mode() const { return mode_; }
+
   /// Note: a node might not have a shape (nullptr)
-  /// if it was hidden before layout was run
-  const Shape *getShape(NodeID nid) const { return shapes_[nid].get(); }
+  /// if it was hidden before layout was run (or in `LayoutMode::Contours`)
+  const Shape *getShape(NodeID nid) const
+  {
+    return mode_ == LayoutMode::Shapes ? shapes_[nid].get() : nullptr;
+  }
 
+  /// Set the shape of `nid` to the interned copy of `shape`
   void setShape(NodeID nid, ShapeUniqPtr shape);
 
+  /// Number of distinct shapes in the layout
+  int distinctShapes() { return shape_pool_.size(); }
+
   double getOffset(NodeID nid) const { return child_offsets_[nid]; }
 
   /// Get the height of the shape of node `nid`
@@ -73,10 +158,37 @@ public:
   /// Set node `nid` as (dirty) / (not dirty) based on `val`
   void setDirty(NodeID nid, bool val) { dirty_[nid] = val; }
 
-  /// Get bounding box of node `nid`
-  const BoundingBox &getBoundingBox(NodeID nid) const { return getShape(nid)->boundingBox(); }
+  RestartContour &restartContour() { return restart_contour_; }
 
-  Layout();
+  /// Get bounding box of node `nid`
+  const BoundingBox &getBoundingBox(NodeID nid) const
+  {
+    return mode_ == LayoutMode::Shapes ? getShape(nid)->boundingBox() : bounding_boxes_[nid];
+  }
+
+  /// Set the bounding box and the height of node `nid` (`LayoutMode::Contours`)
+  void setExtent(NodeID nid, BoundingBox bb, int height)
+  {
+    bounding_boxes_[nid] = bb;
+    heights_[nid] = height;
+  }
+
+  ContourLinks &contour(NodeID nid) { return contours_[nid]; }
+
+  const ContourLinks &contour(NodeID nid) const { return contours_[nid]; }
+
+  /// Record the extent of the tree under `root` once a layout pass is complete
+  /// (the view is sized by it while the next pass is under way)
+  void publish(NodeID root)
+  {
+    published_root_ = root;
+    published_ = {getBoundingBox(root), getHeight(root)};
+  }
+
+  /// The last extent published for `root` (nullptr if there is none)
+  const TreeExtent *published(NodeID root) const { return published_root_ == root ? &published_ : nullptr; }
+
+  explicit Layout(LayoutMode mode = LayoutMode::Shapes);
   ~Layout();
 
 public slots:
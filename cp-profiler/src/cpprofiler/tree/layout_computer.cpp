@@ -3,10 +3,13 @@
 #include "structure.hh"
 #include "node_tree.hh"
 #include "shape.hh"
+#include "visual_flags.hh"
 #include "../utils/std_ext.hh"
 #include "../utils/perf_helper.hh"
+#include "../utils/task_pool.hh"
 
 #include "cursors/layout_cursor.hh"
+#include "cursors/contour_layout_cursor.hh"
 #include "cursors/nodevisitor.hh"
 
 #include <QMutex>
@@ -19,9 +22,28 @@ namespace cpprofiler
 namespace tree
 {
 
+/// The dirty region is split until there are this many subtrees per thread...
+static constexpr int TASKS_PER_THREAD = 8;
+/// ...or this many nodes have been split (e.g. along a long path)
+static constexpr int MAX_SPLIT_NODES = 1 << 14;
+
+/// Nodes laid out between checks of a pass's deadline
+static constexpr int NODES_PER_CHECK = 256;
+
 LayoutComputer::LayoutComputer(const NodeTree &tree, Layout &layout, const VisualFlags &nf)
-    : m_tree(tree), m_layout(layout), m_vis_flags(nf)
+    : m_tree(tree), m_layout(layout), m_vis_flags(nf),
+      threads_(static_cast<int>(std::max(1u, std::thread::hardware_concurrency())))
+{
+}
+
+LayoutComputer::~LayoutComputer() = default;
+
+void LayoutComputer::setThreadCount(int threads)
 {
+    utils::MutexLocker lock(&m_layout.getMutex(), "layout: thread count");
+
+    threads_ = std::max(1, threads);
+    pool_.reset();
 }
 
 bool LayoutComputer::isDirty(NodeID nid)
@@ -32,16 +54,26 @@ bool LayoutComputer::isDirty(NodeID nid)
 void LayoutComputer::setDirty(NodeID nid)
 {
 
-    utils::MutexLocker lock(&m_layout.getMutex());
+    utils::MutexLocker lock(&m_layout.getMutex(), "layout: set dirty");
+
+    markDirty(nid);
+}
 
+void LayoutComputer::markDirty(NodeID nid)
+{
     m_layout.setDirty(nid, true);
+
+    if (m_tree.hasRestarts() && m_tree.getParent(nid) == m_tree.getRoot())
+    {
+        dirty_restarts_.insert(m_tree.getAlternative(nid));
+    }
 }
 
 void LayoutComputer::dirtyUpUnconditional(NodeID n)
 {
     while (n != NodeID::NoNode)
     {
-        m_layout.setDirty(n, true);
+        markDirty(n);
         n = m_tree.getParent(n);
     }
 }
@@ -50,7 +82,7 @@ void LayoutComputer::dirtyUp(NodeID nid)
 {
     while (nid != NodeID::NoNode && !m_layout.isDirty(nid))
     {
-        m_layout.setDirty(nid, true);
+        markDirty(nid);
         nid = m_tree.getParent(nid);
     }
 }
@@ -60,42 +92,303 @@ void LayoutComputer::dirtyUpLater(NodeID nid)
     // if (m_layout.ready(nid))
     // {
     // print("dirty up {} later", nid);
+    std::lock_guard<std::mutex> lock(du_mutex_);
     du_node_set_.insert(nid);
     // }
 }
 
+void LayoutComputer::dirtyUpLater(const std::vector<NodeID> &nodes)
+{
+    std::lock_guard<std::mutex> lock(du_mutex_);
+    du_node_set_.insert(nodes.begin(), nodes.end());
+}
+
+bool LayoutComputer::hasPendingChanges()
+{
+    {
+        std::lock_guard<std::mutex> lock(du_mutex_);
+        if (!du_node_set_.empty())
+            return true;
+    }
+
+    SnapshotPin pin(m_tree);
+
+    if (m_tree.nodeCount() == 0)
+        return false;
+
+    utils::MutexLocker layout_lock(&m_layout.getMutex(), "layout: pending");
+
+    const auto root = m_tree.getRoot();
+    return !m_layout.ready(root) || m_layout.isDirty(root) || !dirty_restarts_.empty();
+}
+
 bool LayoutComputer::compute()
 {
+    utils::MutexLocker layout_lock(&m_layout.getMutex(), "layout: take over");
+
+    /// a pass cancelled for this one has given up the layout by now
+    cancelled_ = false;
+
+    computeUntil(Clock::time_point::max());
+    return m_tree.nodeCount() > 0;
+}
+
+bool LayoutComputer::compute(std::chrono::milliseconds budget)
+{
+    return computeUntil(Clock::now() + budget);
+}
+
+bool LayoutComputer::expired()
+{
+    if (interrupted_.load(std::memory_order_relaxed))
+        return true;
+
+    if (cancelled_.load(std::memory_order_relaxed) || Clock::now() >= deadline_)
+    {
+        interrupted_ = true;
+        return true;
+    }
+
+    return false;
+}
+
+bool LayoutComputer::computeUntil(Clock::time_point deadline)
+{
+
+    /// take the nodes to dirty up before pinning the tree: a batch is
+    /// published before its nodes are queued here (by the builder thread)
+    std::set<NodeID> du_nodes;
+    {
+        std::lock_guard<std::mutex> lock(du_mutex_);
+        du_nodes.swap(du_node_set_);
+    }
+
+    /// the builder may keep adding nodes: only lay out those published so far
+    SnapshotPin pin(m_tree);
+
+    /// nodes queued outside of a batch may not be published yet: leave
+    /// them (and anything queued for an empty tree) for the next call
+    const auto unpinned = du_nodes.lower_bound(NodeID(m_tree.nodeCount()));
+    if (unpinned != du_nodes.end())
+    {
+        std::lock_guard<std::mutex> lock(du_mutex_);
+        du_node_set_.insert(unpinned, du_nodes.end());
+        du_nodes.erase(unpinned, du_nodes.end());
+    }
 
     /// do nothing if there is no nodes
 
     if (m_tree.nodeCount() == 0)
-        return false;
+        return true;
+
+    utils::MutexLocker layout_lock(&m_layout.getMutex(), "layout: compute");
 
-    /// TODO: come back here (ensure mutexes work correctly)
-    utils::MutexLocker tree_lock(&m_tree.treeMutex());
-    utils::MutexLocker layout_lock(&m_layout.getMutex());
+    deadline_ = deadline;
+    interrupted_ = false;
 
     /// Ensures that sufficient memory is allocated for every node's shape
     m_layout.growDataStructures(m_tree.nodeCount());
 
     // print("to dirty up size: {}", du_node_set_.size());
 
-    for (auto n : du_node_set_)
+    for (auto n : du_nodes)
     {
         dirtyUp(n);
     }
 
-    du_node_set_.clear();
+    const auto root = m_tree.getRoot();
 
-    LayoutCursor lc(m_tree.getRoot(), m_tree, m_vis_flags, m_layout, debug_mode_);
-    PostorderNodeVisitor<LayoutCursor>(lc).run();
+    if (m_tree.hasRestarts() && !m_vis_flags.isHidden(root) && m_tree.childrenCount(root) > 0)
+    {
+        computeRestarts();
+    }
+    else
+    {
+        layoutSubtrees({root});
+    }
 
-    static int counter = 0;
-    // std::cerr << "computed layout " << ++counter   << " times\n";
+    if (interrupted_)
+        return false;
+
+    if (m_layout.getLayoutDone(root))
+    {
+        m_layout.publish(root);
+    }
 
     return true;
 }
 
+void LayoutComputer::computeRestarts()
+{
+    const auto root = m_tree.getRoot();
+    const auto nkids = m_tree.childrenCount(root);
+
+    auto &contour = m_layout.restartContour();
+
+    /// restarts that have never been laid out are dirty too
+    for (auto alt = contour.laid_out; alt < nkids; ++alt)
+    {
+        dirty_restarts_.insert(alt);
+    }
+
+    const auto first_dirty = dirty_restarts_.empty() ? nkids : *dirty_restarts_.begin();
+
+    /// only a restart that was not expected to change any more (e.g. one with
+    /// a subtree hidden by the user) invalidates the contour
+    if (first_dirty < contour.merged)
+    {
+        contour.merged = 0;
+        contour.extents.clear();
+    }
+
+    std::vector<NodeID> restarts;
+
+    for (auto it = dirty_restarts_.begin(); it != dirty_restarts_.end() && *it < nkids; ++it)
+    {
+        restarts.push_back(m_tree.getChild(root, *it));
+    }
+
+    layoutSubtrees(restarts);
+
+    /// the restarts stay dirty until the pass that completes them
+    if (interrupted_)
+        return;
+
+    dirty_restarts_.erase(dirty_restarts_.begin(), dirty_restarts_.lower_bound(nkids));
+
+    if (!m_layout.isDirty(root) && first_dirty == nkids)
+        return;
+
+    LayoutCursor lc(root, m_tree, m_vis_flags, m_layout, debug_mode_);
+    lc.computeForRestarts(root, m_tree.frozenRestartCount());
+    m_layout.setDirty(root, false);
+}
+
+void LayoutComputer::layoutSubtrees(const std::vector<NodeID> &starts)
+{
+    const auto threads = threads_;
+
+    /// nodes above the subtrees to lay out in parallel (parents before children)
+    std::vector<NodeID> upper;
+    std::vector<NodeID> subtrees = starts;
+
+    while (threads > 1 && static_cast<int>(subtrees.size()) < threads * TASKS_PER_THREAD &&
+           static_cast<int>(upper.size()) < MAX_SPLIT_NODES)
+    {
+        std::vector<NodeID> next;
+        auto split = false;
+
+        for (const auto nid : subtrees)
+        {
+            /// same condition as LayoutCursor::mayMoveDownwards
+            if (!m_layout.isDirty(nid) || m_vis_flags.isHidden(nid) || m_tree.childrenCount(nid) == 0)
+            {
+                next.push_back(nid);
+                continue;
+            }
+
+            upper.push_back(nid);
+            split = true;
+
+            const auto kids = m_tree.childrenCount(nid);
+            for (auto alt = 0; alt < kids; ++alt)
+            {
+                const auto kid = m_tree.getChild(nid, alt);
+                if (m_layout.isDirty(kid))
+                {
+                    next.push_back(kid);
+                }
+            }
+        }
+
+        subtrees.swap(next);
+
+        if (!split)
+            break;
+    }
+
+    if (subtrees.size() > 1)
+    {
+        if (!pool_)
+        {
+            pool_.reset(new utils::TaskPool(threads));
+        }
+
+        /// workers must see the same nodes as this thread
+        const auto snapshot = m_tree.snapshot();
+
+        std::vector<utils::TaskPool::Task> tasks;
+        tasks.reserve(subtrees.size());
+
+        for (const auto nid : subtrees)
+        {
+            tasks.push_back([this, nid, snapshot]() {
+                SnapshotPin pin(m_tree, snapshot);
+                layoutSubtree(nid);
+            });
+        }
+
+        pool_->run(std::move(tasks));
+    }
+    else
+    {
+        for (const auto nid : subtrees)
+        {
+            layoutSubtree(nid);
+        }
+    }
+
+    /// the nodes above stay dirty if the pass has to stop
+    if (interrupted_)
+        return;
+
+    /// join the subtrees bottom-up
+    for (auto it = upper.rbegin(); it != upper.rend(); ++it)
+    {
+        computeForNode(*it);
+        m_layout.setDirty(*it, false);
+    }
+}
+
+/// A node is only computed once all of its children are, so a pass that
+/// stops early leaves consistent (if outdated) shapes behind, and the next
+/// pass only descends into the subtrees that are still dirty; at least
+/// `NODES_PER_CHECK` nodes are laid out, so that every pass makes progress
+template <typename Cursor>
+void LayoutComputer::runCursor(const Cursor &cursor)
+{
+    PostorderNodeVisitor<Cursor> visitor(cursor);
+
+    for (auto count = 1; visitor.next(); ++count)
+    {
+        if (count % NODES_PER_CHECK == 0 && expired())
+            return;
+    }
+}
+
+void LayoutComputer::layoutSubtree(NodeID nid)
+{
+    if (m_layout.mode() == LayoutMode::Contours)
+    {
+        runCursor(ContourLayoutCursor(nid, m_tree, m_vis_flags, m_layout, debug_mode_));
+    }
+    else
+    {
+        runCursor(LayoutCursor(nid, m_tree, m_vis_flags, m_layout, debug_mode_));
+    }
+}
+
+void LayoutComputer::computeForNode(NodeID nid)
+{
+    if (m_layout.mode() == LayoutMode::Contours)
+    {
+        ContourLayoutCursor(nid, m_tree, m_vis_flags, m_layout, debug_mode_).computeForNode(nid);
+    }
+    else
+    {
+        LayoutCursor(nid, m_tree, m_vis_flags, m_layout, debug_mode_).computeForNode(nid);
+    }
+}
+
 } // namespace tree
 } // namespace cpprofiler
\ No newline at end of file
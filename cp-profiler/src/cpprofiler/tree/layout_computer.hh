@@ -5,11 +5,20 @@ class QMutex;
 
 #include "node_id.hh"
 
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <vector>
 
 namespace cpprofiler
 {
+namespace utils
+{
+class TaskPool;
+} // namespace utils
+
 namespace tree
 {
 
@@ -29,26 +38,100 @@ class LayoutComputer
     bool debug_mode_ = false;
 
     /// Nodes to dirty up right before next layout update
+    /// (added to by the builder's thread too, hence the mutex)
     std::set<NodeID> du_node_set_;
+    std::mutex du_mutex_;
+
+    /// Restarts (positions under the root) made dirty since the last update
+    std::set<int> dirty_restarts_;
+
+    /// Set node `nid` as dirty, noting it if it is a restart
+    void markDirty(NodeID nid);
 
     void dirtyUp(NodeID nid);
 
+    /// Number of threads laying out independent subtrees
+    int threads_;
+
+    /// Threads laying out independent subtrees (created when first needed)
+    std::unique_ptr<utils::TaskPool> pool_;
+
+    using Clock = std::chrono::steady_clock;
+
+    /// When the pass in progress has to stop
+    Clock::time_point deadline_;
+
+    /// Set by `cancel`, cleared once a full pass (`compute()`) holds the layout
+    std::atomic<bool> cancelled_{false};
+
+    /// Whether the pass in progress has run out of time (or been cancelled)
+    std::atomic<bool> interrupted_{false};
+
+    /// Check (and note) whether the pass in progress has to stop
+    bool expired();
+
+    /// Lay out the dirty part of the tree until `deadline`; returns
+    /// whether the layout is complete
+    bool computeUntil(Clock::time_point deadline);
+
+    /// Lay out the dirty restarts, then the root
+    /// (for executions with restarts)
+    void computeRestarts();
+
+    /// Lay out the dirty parts of the subtrees under `starts` (which must not
+    /// overlap): the top of the dirty region is split into subtrees that are
+    /// laid out in parallel, and the nodes above them are done last
+    void layoutSubtrees(const std::vector<NodeID> &starts);
+
+    /// Lay out the dirty part of the subtree under `nid` on the calling thread
+    /// (with the cursor for the layout's mode)
+    void layoutSubtree(NodeID nid);
+
+    /// Run `cursor` over its subtree in postorder, stopping early if the
+    /// pass expires (nodes not reached stay dirty)
+    template <typename Cursor>
+    void runCursor(const Cursor &cursor);
+
+    /// Compute the layout of `nid` from those of its children
+    void computeForNode(NodeID nid);
+
   public:
     LayoutComputer(const NodeTree &tree, Layout &layout, const VisualFlags &nf);
 
+    ~LayoutComputer();
+
     /// compute the layout and return where any work was required
+    /// (taking over from a cancelled pass)
     bool compute();
 
+    /// Lay out for at most `budget`, leaving what is not done yet dirty
+    /// for the next call (which starts over from the root, picking up nodes
+    /// dirtied in between); returns whether the layout is complete
+    bool compute(std::chrono::milliseconds budget);
+
+    /// Make the pass in progress (on another thread) stop as soon as possible;
+    /// slices started before the next `compute()` stop straight away too
+    void cancel() { cancelled_ = true; }
+
+    /// Whether nodes have been dirtied since the last complete pass
+    bool hasPendingChanges();
+
     /// Mark node's ancestors as dirty without stopping at an already dirty node
     void dirtyUpUnconditional(NodeID nid);
 
     void dirtyUpLater(NodeID nid);
 
+    /// Same as `dirtyUpLater` for every node in `nodes`
+    void dirtyUpLater(const std::vector<NodeID> &nodes);
+
     bool isDirty(NodeID nid);
 
     void setDirty(NodeID nid);
 
     void setDebugMode(bool val) { debug_mode_ = val; }
+
+    /// Lay out on `threads` threads (one per core by default)
+    void setThreadCount(int threads);
 };
 
 } // namespace tree
@@ -0,0 +1,81 @@
+#include "layout_worker.hh"
+#include "layout_computer.hh"
+
+namespace cpprofiler
+{
+namespace tree
+{
+
+constexpr std::chrono::milliseconds LayoutWorker::SLICE;
+
+LayoutWorker::LayoutWorker(LayoutComputer &lc) : layout_computer_(lc) {}
+
+LayoutWorker::~LayoutWorker()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+
+    layout_computer_.cancel();
+    wake_.notify_one();
+
+    wait();
+}
+
+void LayoutWorker::requestUpdate()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        requested_ = true;
+    }
+
+    wake_.notify_one();
+}
+
+bool LayoutWorker::isIdle()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !requested_ && !busy_;
+}
+
+void LayoutWorker::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true)
+    {
+        wake_.wait(lock, [this]() { return requested_ || stop_; });
+
+        if (stop_)
+            return;
+
+        requested_ = false;
+        busy_ = true;
+        lock.unlock();
+
+        auto complete = layout_computer_.compute(SLICE);
+
+        while (!complete)
+        {
+            /// the mutex is not fair: give the view a chance to take it
+            QThread::msleep(1);
+
+            {
+                std::lock_guard<std::mutex> stop_lock(mutex_);
+                if (stop_)
+                    return;
+            }
+
+            complete = layout_computer_.compute(SLICE);
+        }
+
+        emit layoutUpdated();
+
+        lock.lock();
+        busy_ = false;
+    }
+}
+
+} // namespace tree
+} // namespace cpprofiler
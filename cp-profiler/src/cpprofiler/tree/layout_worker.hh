@@ -0,0 +1,62 @@
+#ifndef CPPROFILER_TREE_LAYOUT_WORKER_HH
+#define CPPROFILER_TREE_LAYOUT_WORKER_HH
+
+#include <QThread>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace cpprofiler
+{
+namespace tree
+{
+
+class LayoutComputer;
+
+/// Keeps the layout up to date off the GUI thread: a pass is made of slices
+/// of bounded duration, between which the layout mutex is released (so that
+/// the view can paint) and nodes dirtied in the meantime are picked up
+class LayoutWorker : public QThread
+{
+    Q_OBJECT
+
+    LayoutComputer &layout_computer_;
+
+    std::mutex mutex_;
+    /// Signals a requested pass (or that the worker is being stopped)
+    std::condition_variable wake_;
+
+    bool requested_ = false;
+    /// Whether a pass is under way
+    bool busy_ = false;
+    bool stop_ = false;
+
+    void run() override;
+
+  public:
+    /// Longest time the layout is held by the worker at once
+    static constexpr std::chrono::milliseconds SLICE{20};
+
+    explicit LayoutWorker(LayoutComputer &lc);
+
+    /// Stops (cancelling the pass in progress) and waits for the thread
+    ~LayoutWorker();
+
+    /// Start a pass unless one is under way (which picks up
+    /// the changes anyway)
+    void requestUpdate();
+
+    /// Whether no pass is under way or requested
+    bool isIdle();
+
+  signals:
+
+    /// A pass has completed (emitted from the worker's thread)
+    void layoutUpdated();
+};
+
+} // namespace tree
+} // namespace cpprofiler
+
+#endif
@@ -1,5 +1,7 @@
 #include "node_info.hh"
 #include "node.hh"
+#include <algorithm>
+#include <cstring>
 #include <QDebug>
 
 namespace cpprofiler
@@ -7,85 +9,132 @@ namespace cpprofiler
 namespace tree
 {
 
-constexpr NumFlagLoc STATUS = {0, 4};
+/// Bulk operations read entries as the bytes they are made of
+static_assert(sizeof(utils::RelaxedAtomicValue<uint8_t>) == 1 && ATOMIC_CHAR_LOCK_FREE == 2,
+              "node info entries must be plain bytes");
 
-void NodeInfoEntry::setFlag(NodeFlag flag, bool value)
-{
-    m_bitset[static_cast<int>(flag)] = value;
-}
+/// A byte pattern repeated in every byte of a 64-bit word
+static constexpr uint64_t BYTES_01 = 0x0101010101010101ULL;
 
-bool NodeInfoEntry::getFlag(NodeFlag flag) const
+/// Load 8 consecutive entries as a single word
+static inline uint64_t load_word(const uint8_t *ptr)
 {
-    return m_bitset[static_cast<int>(flag)];
+    uint64_t word;
+    std::memcpy(&word, ptr, sizeof(word));
+    return word;
 }
 
-void NodeInfoEntry::setNumericFlag(NumFlagLoc loc, int value)
+/// For every byte of `word`, set its bit 7 iff the byte's status equals `status`
+static inline uint64_t match_status(uint64_t word, uint8_t status, uint8_t status_mask)
 {
-    uint32_t mask = (1 << loc.len) - 1;
-    uint32_t clearmask = ~(mask << loc.pos);
-    m_bitset &= std::bitset<4>(clearmask);
-    m_bitset |= (value & mask) << loc.pos;
+    /// bytes whose status matches become 0x00 (otherwise 0x01..0x0F)
+    const uint64_t diff = (word ^ (status * BYTES_01)) & (status_mask * BYTES_01);
+    /// adding 0x7F sets bit 7 of non-zero bytes (no carry across bytes)
+    return ~(diff + 0x7F * BYTES_01) & (0x80 * BYTES_01);
 }
 
-int NodeInfoEntry::getNumericFlag(NumFlagLoc loc) const
-{
-    uint32_t mask = (1 << loc.len) - 1;
-    return ((m_bitset >> loc.pos) & std::bitset<4>(mask)).to_ulong();
-}
-
-} // namespace tree
-} // namespace cpprofiler
-
-namespace cpprofiler
-{
-namespace tree
-{
-
 NodeStatus NodeInfo::getStatus(NodeID nid) const
 {
-    utils::MutexLocker lock(&m_mutex, "node info");
-    if (static_cast<int>(nid) >= m_flags.size())
-        throw;
-    return static_cast<NodeStatus>(m_flags[nid].getNumericFlag(STATUS));
+    return static_cast<NodeStatus>(m_info[nid].load() & STATUS_MASK);
 }
 
 void NodeInfo::setStatus(NodeID nid, NodeStatus status)
 {
-    utils::MutexLocker lock(&m_mutex, "node info");
-    if (static_cast<int>(nid) >= m_flags.size())
-        throw;
-    m_flags[nid].setNumericFlag(STATUS, static_cast<int>(status));
+    auto &entry = m_info[nid];
+    entry.store((entry.load() & ~STATUS_MASK) | (static_cast<uint8_t>(status) & STATUS_MASK));
 }
 
 void NodeInfo::addEntry(NodeID nid)
 {
-    utils::MutexLocker lock(&m_mutex, "node info");
-    if (nid != m_flags.size())
+    if (nid != m_info.size())
         throw;
-    m_flags.push_back({});
-    m_has_solved_children.push_back(false);
-    m_has_open_children.push_back(true);
+    /// nodes start open and without solutions below
+    m_info.push_back(Entry(HAS_OPEN));
+}
+
+void NodeInfo::setBit(NodeID nid, uint8_t bit, bool val)
+{
+    /// (no other thread changes the entry in the meantime)
+    auto &entry = m_info[nid];
+
+    if (val)
+    {
+        entry.store(entry.load() | bit);
+    }
+    else
+    {
+        entry.store(entry.load() & ~bit);
+    }
 }
 
 void NodeInfo::setHasSolvedChildren(NodeID nid, bool val)
 {
-    m_has_solved_children[nid] = val;
+    setBit(nid, HAS_SOLVED, val);
 }
 
 bool NodeInfo::hasSolvedChildren(NodeID nid) const
 {
-    return m_has_solved_children[nid];
+    return (m_info[nid].load() & HAS_SOLVED) != 0;
 }
 
 void NodeInfo::setHasOpenChildren(NodeID nid, bool val)
 {
-    m_has_open_children[nid] = val;
+    setBit(nid, HAS_OPEN, val);
 }
 
 bool NodeInfo::hasOpenChildren(NodeID nid) const
 {
-    return m_has_open_children[nid];
+    return (m_info[nid].load() & HAS_OPEN) != 0;
+}
+
+template <typename F>
+void NodeInfo::forEachRun(int begin, int end, F &&f) const
+{
+    for (auto pos = begin; pos < end;)
+    {
+        const auto n = std::min(end - pos, m_info.contiguousFrom(pos));
+        f(reinterpret_cast<const uint8_t *>(&m_info[pos]), pos, n);
+        pos += n;
+    }
+}
+
+std::vector<NodeID> NodeInfo::nodesWithStatus(NodeStatus status) const
+{
+    const auto s = static_cast<uint8_t>(status);
+
+    std::vector<NodeID> result;
+
+    forEachRun(0, m_info.size(), [&](const uint8_t *data, int first, int n) {
+        int i = 0;
+
+        for (; i + 8 <= n; i += 8)
+        {
+            auto matched = match_status(load_word(data + i), s, STATUS_MASK);
+
+            /// skip 8 nodes at a time if none of them match
+            if (matched == 0)
+                continue;
+
+            for (auto j = 0; j < 8; ++j)
+            {
+                if ((data[i + j] & STATUS_MASK) == s)
+                {
+                    result.push_back(NodeID{first + i + j});
+                }
+            }
+        }
+
+        for (; i < n; ++i)
+        {
+            if ((data[i] & STATUS_MASK) == s)
+            {
+                result.push_back(NodeID{first + i});
+            }
+        }
+    });
+
+    return result;
 }
 
 } // namespace tree
-} // namespace cpprofiler
\ No newline at end of file
+} // namespace cpprofiler
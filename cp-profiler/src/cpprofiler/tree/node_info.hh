@@ -3,10 +3,11 @@
 
 #include "../core.hh"
 
-#include <bitset>
+#include <cstdint>
 #include <vector>
-#include <QMutex>
 #include "node_id.hh"
+#include "../utils/atomic_value.hh"
+#include "../utils/chunked_vector.hh"
 
 namespace cpprofiler
 {
@@ -15,40 +16,31 @@ namespace tree
 
 enum class NodeStatus;
 
-enum class NodeFlag
-{
-
-};
-
-struct NumFlagLoc
-{
-    int pos;
-    int len;
-};
-
-class NodeInfoEntry
+/// Per-node status and flags packed into one byte per node:
+/// bits 0-3 hold the status, bit 4 -- "has solved children",
+/// bit 5 -- "has open children", bits 6-7 are free for future flags.
+/// Entries are only appended, so other threads can read entries of
+/// published nodes while the builder adds more; a reader may observe
+/// a node's status or flags changing (each byte is a relaxed atomic).
+/// Entries are only changed by one thread at a time (holding the tree
+/// mutex).
+class NodeInfo
 {
 
-  private:
-    std::bitset<4> m_bitset;
+    static constexpr uint8_t STATUS_MASK = 0x0F;
+    static constexpr uint8_t HAS_SOLVED = 1 << 4;
+    static constexpr uint8_t HAS_OPEN = 1 << 5;
 
-  public:
-    void setFlag(NodeFlag flag, bool value);
-    bool getFlag(NodeFlag flag) const;
-
-    void setNumericFlag(NumFlagLoc loc, int value);
-    int getNumericFlag(NumFlagLoc loc) const;
-};
-
-class NodeInfo
-{
+    using Entry = utils::RelaxedAtomicValue<uint8_t>;
 
-    mutable utils::Mutex m_mutex;
+    utils::ChunkedVector<Entry> m_info;
 
-    std::vector<NodeInfoEntry> m_flags;
+    void setBit(NodeID nid, uint8_t bit, bool val);
 
-    std::vector<bool> m_has_solved_children;
-    std::vector<bool> m_has_open_children;
+    /// Call `f(data, first, n)` for every contiguous run of entries
+    /// `data[0..n)` (of nodes `first`, `first + 1`...) covering [begin, end)
+    template <typename F>
+    void forEachRun(int begin, int end, F &&f) const;
 
   public:
     NodeStatus getStatus(NodeID nid) const;
@@ -61,9 +53,15 @@ class NodeInfo
 
     void setHasOpenChildren(NodeID nid, bool val);
     bool hasOpenChildren(NodeID nid) const;
+
+    /// ************ Bulk operation (processing 8 nodes at a time) ************
+    /// (entries are read as plain bytes: the tree mutex must be held)
+
+    /// Return all nodes with status `status` (in the order of their ids)
+    std::vector<NodeID> nodesWithStatus(NodeStatus status) const;
 };
 
 } // namespace tree
 } // namespace cpprofiler
 
-#endif
\ No newline at end of file
+#endif
@@ -3,9 +3,9 @@
 #include "structure.hh"
 #include "node_info.hh"
 #include "../solver_data.hh"
-#include "../utils/tree_utils.hh"
 #include "../name_map.hh"
 #include <QDebug>
+#include <algorithm>
 #include <cassert>
 
 namespace cpprofiler
@@ -13,9 +13,41 @@ namespace cpprofiler
 namespace tree
 {
 
-NodeTree::NodeTree() : structure_{new Structure()}, node_info_(new NodeInfo)
+namespace
+{
+struct Pin
+{
+    const NodeTree *tree;
+    TreeSnapshot snapshot;
+};
+
+/// Marks the tree being modified by the current thread, which sees all of its nodes
+constexpr int LIVE_NODE_COUNT = -1;
+
+/// Snapshots pinned by the current thread (innermost last)
+thread_local std::vector<Pin> pinned_snapshots;
+} // namespace
+
+SnapshotPin::SnapshotPin(const NodeTree &tree)
+{
+    pinned_snapshots.push_back({&tree, tree.snapshot()});
+}
+
+SnapshotPin::SnapshotPin(const NodeTree &tree, TreeSnapshot snapshot)
+{
+    pinned_snapshots.push_back({&tree, snapshot});
+}
+
+SnapshotPin::~SnapshotPin()
+{
+    pinned_snapshots.pop_back();
+}
+
+NodeTree::NodeTree()
+    : structure_{new Structure()}, node_info_(new NodeInfo), snapshot_(TreeSnapshot{0, 0})
 {
     qRegisterMetaType<NodeID>();
+    qRegisterMetaType<std::vector<NodeID>>();
 }
 
 NodeTree::~NodeTree() = default;
@@ -27,13 +59,148 @@ void NodeTree::setSolverData(std::shared_ptr<SolverData> sd)
 
 void NodeTree::setNameMap(std::shared_ptr<const NameMap> nm)
 {
+    utils::MutexLocker tree_lock(&treeMutex(), "name map");
+
     name_map_ = nm;
+    renamed_count_ = 0;
+
+    if (name_map_)
+    {
+        renameLabels();
+    }
+}
+
+void NodeTree::renameLabels()
+{
+    const auto count = label_pool_.size();
+
+    for (auto id = renamed_count_.load(); id < count; ++id)
+    {
+        auto renamed = name_map_->replaceNames(label_pool_.get(id));
+
+        if (id < renamed_labels_.size())
+        {
+            renamed_labels_[id] = std::move(renamed);
+        }
+        else
+        {
+            renamed_labels_.push_back(renamed);
+        }
+    }
+
+    renamed_count_ = count;
+}
+
+TreeSnapshot NodeTree::snapshot() const
+{
+    for (auto it = pinned_snapshots.rbegin(); it != pinned_snapshots.rend(); ++it)
+    {
+        if (it->tree == this)
+        {
+            if (it->snapshot.node_count == LIVE_NODE_COUNT)
+            {
+                return {structure_->nodeCount(), snapshot_.load().epoch};
+            }
+
+            return it->snapshot;
+        }
+    }
+
+    return snapshot_;
+}
+
+void NodeTree::publish()
+{
+    const TreeSnapshot last = snapshot_;
+    snapshot_ = TreeSnapshot{structure_->nodeCount(), last.epoch + 1};
+}
+
+void NodeTree::notifyChildrenChanged(NodeID nid)
+{
+    if (in_batch_)
+    {
+        batch_dirtied_.push_back(nid);
+        return;
+    }
+
+    emit childrenStructureChanged(nid);
+}
+
+void NodeTree::notifyStructureUpdated()
+{
+    if (in_batch_)
+    {
+        batch_updated_ = true;
+        return;
+    }
+
+    publish();
+    emit structureUpdated();
+}
+
+void NodeTree::applyBatch(const std::function<void()> &mutate)
+{
+    utils::MutexLocker tree_lock(&treeMutex(), "builder: batch");
+
+    in_batch_ = true;
+    batch_updated_ = false;
+    batch_dirtied_.clear();
+
+    /// queries made by `mutate` see the nodes it adds
+    pinned_snapshots.push_back({this, {LIVE_NODE_COUNT, 0}});
+
+    try
+    {
+        mutate();
+    }
+    catch (...)
+    {
+        /// whatever the batch did before failing is part of the tree
+        endBatch();
+        throw;
+    }
+
+    endBatch();
+}
+
+void NodeTree::endBatch()
+{
+    pinned_snapshots.pop_back();
+    in_batch_ = false;
+
+    publish();
+
+    std::sort(batch_dirtied_.begin(), batch_dirtied_.end());
+    batch_dirtied_.erase(std::unique(batch_dirtied_.begin(), batch_dirtied_.end()),
+                         batch_dirtied_.end());
+
+    if (!batch_dirtied_.empty())
+    {
+        emit batchApplied(batch_dirtied_);
+    }
+
+    if (batch_updated_)
+    {
+        emit structureUpdated();
+    }
 }
 
 void NodeTree::addEntry(NodeID nid)
 {
     node_info_->addEntry(nid);
-    labels_.push_back({});
+    labels_.push_back(LabelPool::EMPTY);
+
+    if (has_restarts_)
+    {
+        const auto pid = structure_->getParent(nid);
+
+        if (pid == NodeID::NoNode)
+            node_restarts_.push_back(-1);
+        else if (pid == structure_->getRoot())
+            node_restarts_.push_back(structure_->getAlternative(nid));
+        else
+            node_restarts_.push_back(node_restarts_[pid]);
+    }
 }
 
 const NodeInfo &NodeTree::node_info() const
@@ -46,7 +213,7 @@ NodeInfo &NodeTree::node_info()
     return *node_info_;
 }
 
-void NodeTree::promoteNode(NodeID nid, int kids, tree::NodeStatus status, Label label)
+void NodeTree::promoteNode(NodeID nid, int kids, tree::NodeStatus status, const Label &label)
 {
 
     /// find parent and kid's position
@@ -56,7 +223,7 @@ void NodeTree::promoteNode(NodeID nid, int kids, tree::NodeStatus status, Label
     promoteNode(pid, alt, kids, status, label);
 }
 
-NodeID NodeTree::createRoot(int kids, Label label)
+NodeID NodeTree::createRoot(int kids, const Label &label)
 {
     auto nid = structure_->createRoot(kids);
     addEntry(nid);
@@ -77,13 +244,145 @@ NodeID NodeTree::createRoot(int kids, Label label)
 
     node_stats_.add_undetermined(kids);
 
-    emit structureUpdated();
+    notifyStructureUpdated();
 
     return nid;
 }
 
+NodeID NodeTree::createRestartRoot()
+{
+    has_restarts_ = true;
+    return createRoot(0, "root");
+}
+
+NodeID NodeTree::addRestart(int kids, NodeStatus status, const Label &label)
+{
+    const auto root = getRoot();
+    const auto restart = childrenCount(root);
+
+    freezeRestarts(restart);
+
+    addExtraChild(root);
+    return promoteNode(root, restart, kids, status, label);
+}
+
+void NodeTree::setDone()
+{
+    if (has_restarts_)
+    {
+        utils::MutexLocker tree_lock(&treeMutex(), "tree: done");
+        freezeRestarts(structure_->childrenCount(getRoot()));
+        publish();
+    }
+
+    is_done_ = true;
+}
+
+RestartSummary NodeTree::summarise(NodeID nid) const
+{
+    RestartSummary summary;
+    summary.root = nid;
+
+    std::vector<std::pair<NodeID, int>> stack{{nid, 1}};
+
+    while (!stack.empty())
+    {
+        const auto cur = stack.back();
+        stack.pop_back();
+
+        summary.depth = std::max(summary.depth, cur.second);
+
+        switch (getStatus(cur.first))
+        {
+        case NodeStatus::BRANCH:
+            ++summary.branch;
+            break;
+        case NodeStatus::FAILED:
+            ++summary.failed;
+            break;
+        case NodeStatus::SOLVED:
+            ++summary.solved;
+            break;
+        case NodeStatus::SKIPPED:
+            ++summary.skipped;
+            break;
+        case NodeStatus::UNDETERMINED:
+            ++summary.undetermined;
+            break;
+        default:
+            break;
+        }
+
+        const auto kids = childrenCount(cur.first);
+        for (auto alt = 0; alt < kids; ++alt)
+        {
+            stack.push_back({getChild(cur.first, alt), cur.second + 1});
+        }
+    }
+
+    return summary;
+}
+
+void NodeTree::freezeRestarts(int count)
+{
+    const auto root = getRoot();
+
+    /// each restart is traversed once, when the next one begins
+    for (auto restart = restart_summaries_.size(); restart < count; ++restart)
+    {
+        auto summary = summarise(structure_->getChild(root, restart));
+        summary.frozen_at = structure_->nodeCount();
+        restart_summaries_.push_back(summary);
+        restart_changed_.push_back(false);
+
+        if (isOpen(summary.root))
+        {
+            ++open_frozen_restarts_;
+        }
+    }
+
+    frozen_restarts_ = restart_summaries_.size();
+}
+
+void NodeTree::restartChanged(NodeID nid)
+{
+    const auto restart = node_restarts_[nid];
+
+    /// a restart that is not frozen yet is summarised on demand anyway
+    if (restart < 0 || restart >= restart_summaries_.size())
+        return;
+
+    /// (set before the node is published, see `restartSummary`)
+    restart_changed_[restart] = true;
+}
+
+int NodeTree::frozenRestartCount() const
+{
+    /// restarts frozen after the snapshot seen by this thread do not count
+    const auto node_count = nodeCount();
+
+    auto count = frozen_restarts_.load();
+    while (count > 0 && restart_summaries_[count - 1].frozen_at > node_count)
+    {
+        --count;
+    }
+
+    return count;
+}
+
+RestartSummary NodeTree::restartSummary(int restart) const
+{
+    /// a reader whose snapshot includes a late node sees the restart changed
+    if (restart < frozenRestartCount() && !restart_changed_[restart])
+    {
+        return restart_summaries_[restart];
+    }
+
+    return summarise(getChild(getRoot(), restart));
+}
+
 /// Note that this form does not create children
-void NodeTree::db_createRoot(NodeID nid, Label label)
+void NodeTree::db_createRoot(NodeID nid, const Label &label)
 {
 
     structure_->db_createRoot(nid);
@@ -93,6 +392,8 @@ void NodeTree::db_createRoot(NodeID nid, Label label)
     node_stats_.inform_depth(1);
     node_stats_.add_branch(1);
     node_info_->setStatus(nid, NodeStatus::BRANCH);
+
+    notifyStructureUpdated();
 }
 
 static bool is_closing(NodeStatus status)
@@ -103,7 +404,7 @@ static bool is_closing(NodeStatus status)
 }
 
 /// Note: alt is unnecessary here
-void NodeTree::db_addChild(NodeID nid, NodeID pid, int alt, NodeStatus status, Label label)
+void NodeTree::db_addChild(NodeID nid, NodeID pid, int alt, NodeStatus status, const Label &label)
 {
     structure_->db_addChild(nid, pid, alt);
     addEntry(nid);
@@ -111,10 +412,9 @@ void NodeTree::db_addChild(NodeID nid, NodeID pid, int alt, NodeStatus status, L
     node_info_->setStatus(nid, status);
     setLabel(nid, label);
 
-    emit childrenStructureChanged(pid);
+    notifyChildrenChanged(pid);
 
-    auto cur_depth = utils::calculate_depth(*this, nid);
-    node_stats_.inform_depth(cur_depth);
+    node_stats_.inform_depth(getDepth(nid));
 
     node_stats_.addNode(status);
 
@@ -123,7 +423,7 @@ void NodeTree::db_addChild(NodeID nid, NodeID pid, int alt, NodeStatus status, L
     if (status == NodeStatus::SOLVED)
         notifyAncestors(nid);
 
-    emit structureUpdated();
+    notifyStructureUpdated();
 }
 
 void NodeTree::addExtraChild(NodeID pid)
@@ -131,15 +431,20 @@ void NodeTree::addExtraChild(NodeID pid)
     const auto nid = structure_->addExtraChild(pid);
     addEntry(nid);
 
+    if (has_restarts_)
+    {
+        restartChanged(nid);
+    }
+
     node_info_->setStatus(nid, NodeStatus::UNDETERMINED);
     node_stats_.add_undetermined(1);
 
-    emit childrenStructureChanged(pid);
+    notifyChildrenChanged(pid);
 
-    emit structureUpdated();
+    notifyStructureUpdated();
 }
 
-NodeID NodeTree::promoteNode(NodeID parent_id, int alt, int kids, tree::NodeStatus status, Label label)
+NodeID NodeTree::promoteNode(NodeID parent_id, int alt, int kids, tree::NodeStatus status, const Label &label)
 {
 
     NodeID nid;
@@ -155,6 +460,11 @@ NodeID NodeTree::promoteNode(NodeID parent_id, int alt, int kids, tree::NodeStat
         nid = structure_->getChild(parent_id, alt);
     }
 
+    if (has_restarts_)
+    {
+        restartChanged(nid);
+    }
+
     node_info_->setStatus(nid, status);
     setLabel(nid, label);
     // setLabel(nid, std::to_string(nid));
@@ -162,7 +472,7 @@ NodeID NodeTree::promoteNode(NodeID parent_id, int alt, int kids, tree::NodeStat
     if (kids > 0)
     {
         structure_->addChildren(nid, kids);
-        emit childrenStructureChanged(nid); /// updates dirty status for nodes
+        notifyChildrenChanged(nid); /// updates dirty status for nodes
 
         for (auto i = 0; i < kids; ++i)
         {
@@ -173,8 +483,7 @@ NodeID NodeTree::promoteNode(NodeID parent_id, int alt, int kids, tree::NodeStat
 
         node_stats_.add_undetermined(kids);
 
-        auto cur_depth = utils::calculate_depth(*this, nid);
-        node_stats_.inform_depth(cur_depth + 1);
+        node_stats_.inform_depth(getDepth(nid) + 1);
     }
 
     node_stats_.subtract_undetermined(1);
@@ -186,20 +495,20 @@ NodeID NodeTree::promoteNode(NodeID parent_id, int alt, int kids, tree::NodeStat
     if (is_closing(status))
         closeNode(nid);
 
-    if (childrenCount(nid) != kids)
+    if (structure_->childrenCount(nid) != kids)
     {
         print("error: replacing existing node");
     }
     // assert( childrenCount(nid) == kids );
 
-    emit structureUpdated();
+    notifyStructureUpdated();
 
     return nid;
 }
 
 int NodeTree::nodeCount() const
 {
-    return structure_->nodeCount();
+    return snapshot().node_count;
 }
 
 NodeID NodeTree::getParent(NodeID nid) const
@@ -239,7 +548,7 @@ NodeStatus NodeTree::getStatus(NodeID nid) const
 
 int NodeTree::getNumberOfSiblings(NodeID nid) const
 {
-    return structure_->getNumberOfSiblings(nid);
+    return childrenCount(getParent(nid));
 }
 
 int NodeTree::depth() const
@@ -254,12 +563,18 @@ int NodeTree::getAlternative(NodeID nid) const
 
 int NodeTree::childrenCount(NodeID nid) const
 {
-    return structure_->childrenCount(nid);
+    return structure_->childrenCount(nid, nodeCount());
+}
+
+int NodeTree::getDepth(NodeID nid) const
+{
+    return structure_->getDepth(nid);
 }
 
 void NodeTree::notifyAncestors(NodeID nid)
 {
-    while (nid != NodeID::NoNode)
+    /// ancestors of a node that has solved children are already notified
+    while (nid != NodeID::NoNode && !node_info_->hasSolvedChildren(nid))
     {
         node_info_->setHasSolvedChildren(nid, true);
         nid = getParent(nid);
@@ -271,24 +586,41 @@ void NodeTree::setHasOpenChildren(NodeID nid, bool val)
     node_info_->setHasOpenChildren(nid, val);
 }
 
-const Label NodeTree::getLabel(NodeID nid) const
+const Label &NodeTree::getLabel(NodeID nid) const
 {
     // return std::to_string(nid);
 
     // auto uid = solver_data_->getSolverID(nid);
     // return uid.toString();
 
-    auto &orig = labels_.at(nid);
-    if (name_map_)
+    const auto id = labels_[nid];
+
+    if (id < renamed_count_)
     {
-        return name_map_->replaceNames(orig);
+        return renamed_labels_[id];
     }
-    return orig;
+
+    return label_pool_.get(id);
+}
+
+LabelID NodeTree::getLabelId(NodeID nid) const
+{
+    return labels_[nid];
+}
+
+const LabelPool &NodeTree::labelPool() const
+{
+    return label_pool_;
 }
 
-const Nogood &NodeTree::getNogood(NodeID nid) const
+Nogood NodeTree::getNogood(NodeID nid) const
 {
-    return solver_data_->getNogood(nid);
+    const auto &ng = solver_data_->getNogood(nid);
+
+    if (!name_map_ || ng.original().empty())
+        return ng;
+
+    return Nogood(ng.original(), name_map_->replaceNamesCached(ng.original()));
 }
 
 bool NodeTree::hasSolvedChildren(NodeID nid) const
@@ -307,14 +639,22 @@ bool NodeTree::isOpen(NodeID nid) const
             hasOpenChildren(nid));
 }
 
+double NodeTree::bytesPerNode() const
+{
+    return structure_->bytesPerNode();
+}
+
 void NodeTree::onChildClosed(NodeID nid)
 {
 
-    bool allClosed = true;
+    /// frozen restarts are accounted for by `open_frozen_restarts_`
+    const auto first = (has_restarts_ && nid == getRoot()) ? restart_summaries_.size() : 0;
+
+    bool allClosed = (first == 0 || open_frozen_restarts_ == 0);
 
-    for (auto i = childrenCount(nid); i--;)
+    for (auto i = structure_->childrenCount(nid); allClosed && i-- > first;)
     {
-        auto kid = getChild(nid, i);
+        auto kid = structure_->getChild(nid, i);
         if (isOpen(kid))
         {
             allClosed = false;
@@ -335,8 +675,15 @@ void NodeTree::onChildClosed(NodeID nid)
 
 void NodeTree::closeNode(NodeID nid)
 {
-    setHasOpenChildren(nid, false);
     auto pid = getParent(nid);
+
+    if (has_restarts_ && pid == getRoot() && hasOpenChildren(nid) &&
+        getAlternative(nid) < restart_summaries_.size())
+    {
+        --open_frozen_restarts_;
+    }
+
+    setHasOpenChildren(nid, false);
     if (pid != NodeID::NoNode)
     {
         onChildClosed(pid);
@@ -345,24 +692,33 @@ void NodeTree::closeNode(NodeID nid)
 
 void NodeTree::setLabel(NodeID nid, const Label &label)
 {
-    labels_[nid] = label;
+    labels_[nid] = label_pool_.intern(label);
+
+    if (name_map_)
+    {
+        renameLabels();
+    }
 }
 
 void NodeTree::removeNode(NodeID nid)
 {
 
+    utils::MutexLocker tree_lock(&treeMutex(), "tree: remove node");
+
     const auto pid = getParent(nid);
     if (pid == NodeID::NoNode)
         return;
 
+    if (has_restarts_)
+    {
+        restartChanged(pid);
+    }
+
     const auto alt = getAlternative(nid);
     /// should this really remove the node?
     structure_->removeChild(pid, alt);
-}
 
-void NodeTree::db_initialize(int size)
-{
-    structure_->db_initialize(size);
+    publish();
 }
 
 } // namespace tree
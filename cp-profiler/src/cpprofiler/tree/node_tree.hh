@@ -2,12 +2,16 @@
 #define CPPROFILER_TREE_NODE_TREE_HH
 
 #include <QObject>
+#include <functional>
 #include <memory>
 #include <string>
 #include <stack>
 #include "node_id.hh"
 #include "node.hh"
+#include "label_pool.hh"
 #include "../core.hh"
+#include "../utils/chunked_vector.hh"
+#include "../utils/atomic_value.hh"
 
 #include "node_stats.hh"
 
@@ -27,8 +31,43 @@ class NodeInfo;
 
 static Label emptyLabel = {};
 
+/// A state of the tree published by the builder: nodes with ids below
+/// `node_count` can be read without locking while the builder keeps adding
+/// nodes; `epoch` increases with every publication (including removals)
+struct TreeSnapshot
+{
+    int node_count;
+    int epoch;
+};
+
+/// In an execution with restarts every restart is a subtree under the
+/// (artificial) root; a restart is frozen once the next one begins (or the
+/// tree is done), at which point its summary is recorded. Nodes can still
+/// arrive late in a frozen restart (sent by solver threads handled by other
+/// builder shards), after which its summary is recomputed when requested
+struct RestartSummary
+{
+    /// The restart's top node (a child of the root)
+    NodeID root;
+    int branch = 0;
+    int failed = 0;
+    int solved = 0;
+    int skipped = 0;
+    int undetermined = 0;
+    /// Depth of the restart's subtree (its top node has depth 1)
+    int depth = 0;
+    /// Number of nodes in the tree when the restart was frozen
+    int frozen_at = 0;
+
+    int nodeCount() const { return branch + failed + solved + skipped + undetermined; }
+};
+
 /// Node tree encapsulates tree structure, node statistics (number of nodes etc.),
 /// status for nodes (node_info_), labels
+///
+/// Queries reflect the last published snapshot: modifications become visible
+/// to readers at the end of each modifier or, for `applyBatch`, at the end of
+/// the batch. Readers do not need the tree mutex, which only serialises writers.
 class NodeTree : public QObject
 {
     Q_OBJECT
@@ -40,14 +79,61 @@ class NodeTree : public QObject
     std::shared_ptr<const NameMap> name_map_;
     /// Contains a mapping from node ids to their original solver ids (triplets)
     std::shared_ptr<SolverData> solver_data_;
-    /// Nodes' labels
-    std::vector<Label> labels_;
+    /// Distinct labels of the tree
+    LabelPool label_pool_;
+    /// Nodes' labels (as identifiers in `label_pool_`)
+    utils::ChunkedVector<LabelID> labels_;
+    /// Labels with nice names (indexed by label id) if a name map is set
+    utils::ChunkedVector<Label, 10> renamed_labels_;
+    /// Number of labels in `renamed_labels_`
+    utils::AtomicValue<int> renamed_count_;
+    /// The latest published state of the tree
+    utils::AtomicValue<TreeSnapshot> snapshot_;
     /// Count of different types of nodes, tree depth
     NodeStats node_stats_;
 
+    /// Whether the tree's root is an artificial node grouping restarts
+    bool has_restarts_ = false;
+    /// Summaries of the frozen restarts (indexed by restart)
+    utils::ChunkedVector<RestartSummary> restart_summaries_;
+    /// Number of summaries in `restart_summaries_` readers may access
+    utils::AtomicValue<int> frozen_restarts_;
+    /// Whether a frozen restart has changed since it was summarised
+    /// (indexed by restart)
+    utils::ChunkedVector<utils::AtomicValue<bool>> restart_changed_;
+    /// The restart of every node (-1 for the root); only kept in executions
+    /// with restarts
+    utils::ChunkedVector<int> node_restarts_;
+    /// Number of frozen restarts that are still open (so that closing
+    /// a restart does not require visiting all of the root's children)
+    int open_frozen_restarts_ = 0;
+
     /// Indicates whether the tree is fully built
     bool is_done_ = false;
 
+    /// Whether change notifications are being collected (see `applyBatch`)
+    bool in_batch_ = false;
+    /// Whether the structure changed during the current batch
+    bool batch_updated_ = false;
+    /// Nodes whose children changed during the current batch
+    std::vector<NodeID> batch_dirtied_;
+
+    /// Make all modifications so far visible to readers
+    void publish();
+
+    /// Leave the batch started by `applyBatch`: publish its modifications
+    /// and emit the notifications collected (also if the batch failed)
+    void endBatch();
+
+    /// Apply the name map to every label added since the last call
+    void renameLabels();
+
+    /// Emit `childrenStructureChanged` (or record it if in a batch)
+    void notifyChildrenChanged(NodeID nid);
+
+    /// Emit `structureUpdated` (or record it if in a batch)
+    void notifyStructureUpdated();
+
     /// Ensure all relevant data structures contain this node
     void addEntry(NodeID nid);
 
@@ -60,6 +146,15 @@ class NodeTree : public QObject
     /// Set closed and notify ancestors
     void closeNode(NodeID nid);
 
+    /// Compute the summary of the subtree under `nid`
+    RestartSummary summarise(NodeID nid) const;
+
+    /// Freeze (and summarise) all restarts up to (not including) `count`
+    void freezeRestarts(int count);
+
+    /// Note that the restart of `nid` has changed (if it is frozen)
+    void restartChanged(NodeID nid);
+
   public:
     NodeTree();
     ~NodeTree();
@@ -75,22 +170,44 @@ class NodeTree : public QObject
 
     void setSolverData(std::shared_ptr<SolverData> sd);
 
+    /// Set the name map used for labels (expected before the tree is displayed)
     void setNameMap(std::shared_ptr<const NameMap> nm);
 
-    void setDone() { is_done_ = true; }
+    /// Get the state of the tree seen by the calling thread: the snapshot
+    /// pinned by a `SnapshotPin` if any, otherwise the latest published one
+    TreeSnapshot snapshot() const;
+
+    /// Mark the tree as fully built (freezing the last restart if any)
+    void setDone();
 
     bool isDone() const { return is_done_; }
 
     /// *************************** Tree Modifiers ***************************
 
-    NodeID createRoot(int kids, Label label = emptyLabel);
+    /// Apply `mutate` (a sequence of modifications) under a single acquisition
+    /// of the tree mutex; instead of signalling every change, a single
+    /// `batchApplied` followed by `structureUpdated` is emitted at the end
+    /// (also if `mutate` throws: the exception is passed on afterwards)
+    void applyBatch(const std::function<void()> &mutate);
+
+    NodeID createRoot(int kids, const Label &label = emptyLabel);
+
+    /// Create the artificial root of an execution with restarts; must be
+    /// called before the tree is shared with other threads
+    NodeID createRestartRoot();
+
+    /// Start a new restart (a new child of the root) and turn it into a node
+    /// with `kids` children; the previous restarts are frozen. Restarts are
+    /// numbered by the tree: solvers do not always send correct restart ids
+    /// (e.g. Chuffed doesn't do that)
+    NodeID addRestart(int kids, NodeStatus status, const Label & = emptyLabel);
 
     /// turn a white node into some other node
-    void promoteNode(NodeID nid, int kids, NodeStatus status, Label = emptyLabel);
+    void promoteNode(NodeID nid, int kids, NodeStatus status, const Label & = emptyLabel);
 
     /// TODO: rename it to resetNode
     /// Turn undet node into a real one, updating stats and emitting signals
-    NodeID promoteNode(NodeID parent_id, int alt, int kids, NodeStatus status, Label = emptyLabel);
+    NodeID promoteNode(NodeID parent_id, int alt, int kids, NodeStatus status, const Label & = emptyLabel);
 
     void addExtraChild(NodeID pid);
 
@@ -122,6 +239,9 @@ class NodeTree : public QObject
     /// Get the total number of children of node `pid`
     int childrenCount(NodeID nid) const;
 
+    /// Get the depth of node `nid` (the root has depth 1)
+    int getDepth(NodeID nid) const;
+
     /// Get the child of node `pid` at position `alt`
     NodeID getChild(NodeID nid, int alt) const;
 
@@ -131,11 +251,18 @@ class NodeTree : public QObject
     /// Get the status of node `nid`
     NodeStatus getStatus(NodeID nid) const;
 
-    /// Get the label of node `nid`
-    const Label getLabel(NodeID nid) const;
+    /// Get the label of node `nid` (with nice names if a name map is set)
+    const Label &getLabel(NodeID nid) const;
+
+    /// Get the identifier of the label of node `nid`; nodes with equal
+    /// (original) labels have equal identifiers
+    LabelID getLabelId(NodeID nid) const;
+
+    /// Get the pool of distinct labels used by the tree
+    const LabelPool &labelPool() const;
 
-    /// Get the nogood of node `nid`
-    const Nogood &getNogood(NodeID nid) const;
+    /// Get the nogood of node `nid` (renamed using the name map if there is one)
+    Nogood getNogood(NodeID nid) const;
 
     /// Check if the node `nid` has solved children (ancestors?)
     bool hasSolvedChildren(NodeID nid) const;
@@ -146,13 +273,27 @@ class NodeTree : public QObject
     /// Check if the node `nid` is open or has open children
     bool isOpen(NodeID nid) const;
 
-    /// ************ Building a tree from a database ************
+    /// Whether the tree's root groups restarts (see `createRestartRoot`)
+    bool hasRestarts() const { return has_restarts_; }
+
+    /// Number of restarts whose subtrees will not change anymore; these
+    /// are always the leftmost children of the root
+    int frozenRestartCount() const;
+
+    /// Summary of the restart at position `restart` (computed on demand
+    /// for restarts that are not yet frozen or have changed since)
+    RestartSummary restartSummary(int restart) const;
+
+    /// Average memory used by the tree structure per node (in bytes)
+    double bytesPerNode() const;
 
-    void db_initialize(int size);
+    /// ************ Building a tree from a database ************
+    /// (nodes are added in the order of their ids, inside one `applyBatch`
+    /// so that the tree is published once it is complete)
 
-    void db_createRoot(NodeID nid, Label label = emptyLabel);
+    void db_createRoot(NodeID nid, const Label &label = emptyLabel);
 
-    void db_addChild(NodeID nid, NodeID pid, int alt, NodeStatus status, Label = emptyLabel);
+    void db_addChild(NodeID nid, NodeID pid, int alt, NodeStatus status, const Label & = emptyLabel);
 
     /// ********************************************************************
 
@@ -166,11 +307,34 @@ class NodeTree : public QObject
     /// and requires layout update
     void childrenStructureChanged(NodeID nid);
 
+    /// Notifies that a batch of modifications has been applied; `dirtied` contains
+    /// (sorted and without duplicates) every node whose children changed
+    void batchApplied(const std::vector<cpprofiler::tree::NodeID> &dirtied);
+
     /// Notify that all nodes in the subtree have been closed (no undetermined nodes)
     void failedSubtreeClosed(cpprofiler::tree::NodeID nid);
 };
 
+/// While alive, queries made by the current thread on `tree` see the snapshot
+/// that was the latest one when the pin was created, so that a long traversal
+/// (e.g. layout) does not run into nodes published halfway through it
+class SnapshotPin
+{
+  public:
+    explicit SnapshotPin(const NodeTree &tree);
+
+    /// Pin `snapshot` (e.g. the one pinned by a thread that hands work to the
+    /// current one) rather than the latest one
+    SnapshotPin(const NodeTree &tree, TreeSnapshot snapshot);
+    ~SnapshotPin();
+
+    SnapshotPin(const SnapshotPin &) = delete;
+    SnapshotPin &operator=(const SnapshotPin &) = delete;
+};
+
 } // namespace tree
 } // namespace cpprofiler
 
+Q_DECLARE_METATYPE(std::vector<cpprofiler::tree::NodeID>)
+
 #endif
\ No newline at end of file
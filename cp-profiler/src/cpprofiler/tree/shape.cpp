@@ -1,6 +1,7 @@
 #include "shape.hh"
 #include "../config.hh"
 #include <QDebug>
+#include <algorithm>
 #include <ostream>
 
 namespace cpprofiler
@@ -8,15 +9,39 @@ namespace cpprofiler
 namespace tree
 {
 
-Shape::Shape(int height) : extents_(height) {}
+Shape::Shape(int height) : height_(height), extents_(new int[2 * height]) {}
+
+Shape::Shape(std::initializer_list<Extent> init_list, const BoundingBox &bb)
+    : Shape(static_cast<int>(init_list.size()))
+{
+    auto depth = 0;
+    for (const auto &extent : init_list)
+    {
+        setExtent(depth++, extent);
+    }
+    bb_ = bb;
+}
+
+Shape::Shape(const Shape &other) : Shape(other.height_)
+{
+    std::copy(other.extents_, other.extents_ + 2 * height_, extents_);
+    bb_ = other.bb_;
+}
+
+Shape::Shape(Shape &&other) noexcept
+    : height_(other.height_), extents_(other.extents_), bb_(other.bb_)
+{
+    other.height_ = 0;
+    other.extents_ = nullptr;
+}
 
 std::ostream &operator<<(std::ostream &os, const cpprofiler::tree::Shape &s)
 {
     os << "{ height: " << s.height() << ", [ ";
 
-    for (auto i = 0; i < s.extents_.size(); ++i)
+    for (auto i = 0; i < s.height(); ++i)
     {
-        os << "{" << s.extents_[i].l << ":" << s.extents_[i].r << "} ";
+        os << "{" << s[i].l << ":" << s[i].r << "} ";
     }
 
     return os << "]}";
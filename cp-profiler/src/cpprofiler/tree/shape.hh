@@ -1,9 +1,9 @@
 #ifndef CPPROFILER_TREE_SHAPE
 #define CPPROFILER_TREE_SHAPE
 
-#include "../utils/array.hh"
 #include <ostream>
 #include <initializer_list>
+#include <vector>
 
 namespace cpprofiler
 {
@@ -36,12 +36,16 @@ struct BoundingBox
     }
 };
 
-/// Subtree's shape (outline) represented by extents on each depth level
+/// Subtree's shape (outline) represented by extents on each depth level;
+/// left and right extents are stored in separate arrays, so that loops over
+/// them can be vectorised (see `extent_kernels`)
 class Shape
 {
 
-    /// Shape's extents
-    utils::Array<Extent> extents_;
+    int height_;
+
+    /// Left extents followed by right extents (`2 * height_` values)
+    int *extents_;
 
     /// Shapes's bounding box
     BoundingBox bb_;
@@ -53,17 +57,36 @@ class Shape
     explicit Shape(int height);
 
     /// Create a shape using initializer list and a pre-computed bounding box
-    Shape(std::initializer_list<Extent> init_list, const BoundingBox &bb)
-        : extents_{init_list}, bb_{bb} {}
+    Shape(std::initializer_list<Extent> init_list, const BoundingBox &bb);
+
+    Shape(const Shape &other);
+
+    Shape(Shape &&other) noexcept;
+
+    Shape &operator=(const Shape &) = delete;
+
+    ~Shape() { delete[] extents_; }
 
     /// Get the depth/height of the shape
-    int height() const { return extents_.size(); }
+    int height() const { return height_; }
 
     /// Get the extent at `depth`
-    Extent &operator[](int depth) { return extents_[depth]; }
+    Extent operator[](int depth) const { return {extents_[depth], extents_[height_ + depth]}; }
 
-    /// Get the extent at `depth`
-    const Extent &operator[](int depth) const { return extents_[depth]; }
+    /// Set the extent at `depth`
+    void setExtent(int depth, Extent extent)
+    {
+        extents_[depth] = extent.l;
+        extents_[height_ + depth] = extent.r;
+    }
+
+    /// Left extents (indexed by depth)
+    int *lefts() { return extents_; }
+    const int *lefts() const { return extents_; }
+
+    /// Right extents (indexed by depth)
+    int *rights() { return extents_ + height_; }
+    const int *rights() const { return extents_ + height_; }
 
     /// Set bounding box
     void setBoundingBox(BoundingBox bb) { bb_ = bb; }
@@ -77,6 +100,24 @@ class Shape
     static Shape hidden;
 };
 
+/// Combined extents of a row of sibling subtrees by depth, stored like
+/// those of `Shape` (siblings are placed against it one after another)
+struct Skyline
+{
+    std::vector<int> lefts;
+    std::vector<int> rights;
+
+    int height() const { return static_cast<int>(lefts.size()); }
+
+    bool empty() const { return lefts.empty(); }
+
+    void clear()
+    {
+        lefts.clear();
+        rights.clear();
+    }
+};
+
 class ShapeDeleter
 {
   public:
@@ -0,0 +1,197 @@
+#include "shape_pool.hh"
+#include "extent_kernels.hh"
+
+#include <functional>
+#include <new>
+#include <utility>
+
+namespace cpprofiler
+{
+namespace tree
+{
+
+constexpr int ShapePool::SHARDS;
+constexpr int ShapePool::BLOCK_ENTRIES;
+
+ShapeHandle &ShapeHandle::operator=(ShapeHandle &&other) noexcept
+{
+    if (this != &other)
+    {
+        reset();
+        entry_ = other.entry_;
+        other.entry_ = nullptr;
+    }
+    return *this;
+}
+
+void ShapeHandle::reset()
+{
+    if (entry_)
+    {
+        entry_->pool->release(entry_);
+        entry_ = nullptr;
+    }
+}
+
+std::size_t ShapePool::hashOf(const Shape &shape)
+{
+    std::size_t hash = std::hash<int>()(shape.height());
+
+    const auto combine = [&hash](int value) {
+        hash ^= std::hash<int>()(value) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    };
+
+    for (auto depth = 0; depth < shape.height(); ++depth)
+    {
+        combine(shape.lefts()[depth]);
+        combine(shape.rights()[depth]);
+    }
+
+    combine(shape.boundingBox().left);
+    combine(shape.boundingBox().right);
+
+    return hash;
+}
+
+bool ShapePool::equal(const Shape &s1, const Shape &s2)
+{
+    if (s1.height() != s2.height())
+        return false;
+
+    if (s1.boundingBox().left != s2.boundingBox().left || s1.boundingBox().right != s2.boundingBox().right)
+        return false;
+
+    return extent_kernels::first_mismatch(s1.lefts(), s1.rights(), s2.lefts(), s2.rights(), s1.height()) ==
+           s1.height();
+}
+
+ShapeEntry *ShapePool::allocate(Shard &shard)
+{
+    if (shard.free)
+    {
+        auto entry = shard.free;
+        shard.free = entry->next;
+        return entry;
+    }
+
+    if (shard.block_used == BLOCK_ENTRIES)
+    {
+        shard.blocks.emplace_back(new EntryStorage[BLOCK_ENTRIES]);
+        shard.block_used = 0;
+    }
+
+    return reinterpret_cast<ShapeEntry *>(&shard.blocks.back()[shard.block_used++]);
+}
+
+/// Double the number of buckets (keeping about one entry per bucket)
+void ShapePool::rehash(Shard &shard)
+{
+    std::vector<ShapeEntry *> buckets(std::max<std::size_t>(64, shard.buckets.size() * 2), nullptr);
+
+    for (auto entry : shard.buckets)
+    {
+        while (entry)
+        {
+            auto next = entry->next;
+            auto &bucket = buckets[entry->hash / SHARDS % buckets.size()];
+            entry->next = bucket;
+            bucket = entry;
+            entry = next;
+        }
+    }
+
+    shard.buckets.swap(buckets);
+}
+
+ShapeHandle ShapePool::intern(ShapeUniqPtr shape)
+{
+    const auto hash = hashOf(*shape);
+    auto &shard = this->shard(hash);
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    if (!shard.buckets.empty())
+    {
+        for (auto entry = shard.buckets[hash / SHARDS % shard.buckets.size()]; entry; entry = entry->next)
+        {
+            if (entry->hash == hash && equal(entry->shape, *shape))
+            {
+                ++entry->refs;
+                return ShapeHandle(entry);
+            }
+        }
+    }
+
+    if (shard.count >= static_cast<int>(shard.buckets.size()))
+    {
+        rehash(shard);
+    }
+
+    auto entry = allocate(shard);
+
+    /// the shared leaf and hidden shapes must stay intact
+    const bool owned = shape.get() != &Shape::leaf && shape.get() != &Shape::hidden;
+    new (&entry->shape) Shape(owned ? std::move(*shape) : *shape);
+
+    entry->refs = 1;
+    entry->hash = hash;
+    entry->pool = this;
+
+    auto &bucket = shard.buckets[hash / SHARDS % shard.buckets.size()];
+    entry->next = bucket;
+    bucket = entry;
+    ++shard.count;
+
+    return ShapeHandle(entry);
+}
+
+void ShapePool::release(ShapeEntry *entry)
+{
+    auto &shard = this->shard(entry->hash);
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    if (--entry->refs > 0)
+        return;
+
+    auto *link = &shard.buckets[entry->hash / SHARDS % shard.buckets.size()];
+    while (*link != entry)
+    {
+        link = &(*link)->next;
+    }
+    *link = entry->next;
+    --shard.count;
+
+    entry->shape.~Shape();
+    entry->next = shard.free;
+    shard.free = entry;
+}
+
+int ShapePool::size()
+{
+    auto total = 0;
+    for (auto &shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total += shard.count;
+    }
+    return total;
+}
+
+/// Handles must not outlive the pool: any entries left are destroyed here
+ShapePool::~ShapePool()
+{
+    for (auto &shard : shards_)
+    {
+        for (auto entry : shard.buckets)
+        {
+            for (; entry; entry = entry->next)
+            {
+                entry->shape.~Shape();
+            }
+        }
+    }
+}
+
+} // namespace tree
+} // namespace cpprofiler
@@ -0,0 +1,120 @@
+#ifndef CPPROFILER_TREE_SHAPE_POOL_HH
+#define CPPROFILER_TREE_SHAPE_POOL_HH
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#include "shape.hh"
+
+namespace cpprofiler
+{
+namespace tree
+{
+
+using ShapeUniqPtr = std::unique_ptr<Shape, ShapeDeleter>;
+
+class ShapePool;
+
+/// An interned shape with the number of handles referring to it
+struct ShapeEntry
+{
+    Shape shape;
+    /// Only changed with the entry's shard locked
+    int refs;
+    std::size_t hash;
+    /// Next entry in the same bucket (or in the free list)
+    ShapeEntry *next;
+    ShapePool *pool;
+};
+
+/// A reference to an interned shape; subtrees with the same outline share
+/// one shape, so handles to equal shapes point to the same object
+class ShapeHandle
+{
+    ShapeEntry *entry_ = nullptr;
+
+    friend class ShapePool;
+
+    explicit ShapeHandle(ShapeEntry *entry) : entry_(entry) {}
+
+  public:
+    ShapeHandle() = default;
+
+    ShapeHandle(ShapeHandle &&other) noexcept : entry_(other.entry_) { other.entry_ = nullptr; }
+
+    ShapeHandle &operator=(ShapeHandle &&other) noexcept;
+
+    ShapeHandle(const ShapeHandle &) = delete;
+    ShapeHandle &operator=(const ShapeHandle &) = delete;
+
+    ~ShapeHandle() { reset(); }
+
+    /// Release the shape (freed once no other handle refers to it)
+    void reset();
+
+    const Shape *get() const { return entry_ ? &entry_->shape : nullptr; }
+};
+
+/// Interning table for the shapes of a layout: shapes are looked up by a
+/// hash of their extents, and entries are allocated in blocks and reused
+/// once their last handle is released. The table is split into shards
+/// (each with its own lock) so that subtrees laid out by different
+/// threads rarely wait for each other
+class ShapePool
+{
+    static constexpr int SHARDS = 16;
+    static constexpr int BLOCK_ENTRIES = 1024;
+
+    using EntryStorage = std::aligned_storage<sizeof(ShapeEntry), alignof(ShapeEntry)>::type;
+
+    struct Shard
+    {
+        std::mutex mutex;
+        std::vector<ShapeEntry *> buckets;
+        int count = 0;
+        /// Released entries (linked via `next`)
+        ShapeEntry *free = nullptr;
+        std::vector<std::unique_ptr<EntryStorage[]>> blocks;
+        /// Entries used in the last block
+        int block_used = BLOCK_ENTRIES;
+    };
+
+    Shard shards_[SHARDS];
+
+    friend class ShapeHandle;
+
+    static std::size_t hashOf(const Shape &shape);
+
+    static bool equal(const Shape &s1, const Shape &s2);
+
+    Shard &shard(std::size_t hash) { return shards_[hash % SHARDS]; }
+
+    ShapeEntry *allocate(Shard &shard);
+
+    void rehash(Shard &shard);
+
+    /// Drop a reference to `entry`, freeing it if it was the last one
+    void release(ShapeEntry *entry);
+
+  public:
+    ShapePool() = default;
+    ~ShapePool();
+
+    ShapePool(const ShapePool &) = delete;
+    ShapePool &operator=(const ShapePool &) = delete;
+
+    /// A handle to the interned shape equal to `shape` (which is taken over
+    /// if no such shape exists yet)
+    ShapeHandle intern(ShapeUniqPtr shape);
+
+    /// Number of distinct shapes currently interned
+    int size();
+};
+
+} // namespace tree
+} // namespace cpprofiler
+
+#endif
@@ -15,7 +15,6 @@ namespace tree
 
 Structure::Structure()
 {
-    nodes_.reserve(100);
 }
 
 Mutex &Structure::getMutex() const
@@ -25,85 +24,220 @@ Mutex &Structure::getMutex() const
 
 NodeID Structure::createRoot(int kids)
 {
-    if (nodes_.size() > 0)
+    if (nodeCount() > 0)
     {
         throw invalid_tree();
     }
 
-    const auto root_nid = createNode(NodeID::NoNode, kids);
+    const auto root_nid = createNode(NodeID::NoNode, -1);
 
     /// create white nodes for children nodes
-    for (auto i = 0; i < kids; ++i)
-    {
-        createChild(root_nid, i, 0);
-    }
+    addChildren(root_nid, kids);
 
     return root_nid;
 }
 
-NodeID Structure::createNode(NodeID pid, int kids)
+NodeID Structure::createNode(NodeID pid, int alt)
 {
-    const auto nid = NodeID{static_cast<int>(nodes_.size())};
-    nodes_.push_back(std::unique_ptr<Node>{new Node(pid, kids)});
+    const auto nid = NodeID{nodeCount()};
+    parent_.push_back(pid);
+    alt_.push_back(alt);
+    kids_.push_back(0);
+    depth_.push_back(pid == NodeID::NoNode ? 1 : depth_[pid] + 1);
+    first_kid_.push_back(0);
     return nid;
 }
 
-void Structure::db_createNode(NodeID nid, NodeID pid, int kids)
+int Structure::allocKids(int n)
 {
-    nodes_[nid] = std::unique_ptr<Node>{new Node(pid, kids)};
+    /// the entry before a block holds its capacity
+    const auto offset = kid_arena_.size() + 1;
+    kid_arena_.resize(offset + n);
+    kid_arena_[offset - 1] = NodeID{n};
+    return offset;
 }
 
-NodeID Structure::createChild(NodeID pid, int alt, int kids)
+int Structure::moveKidsToArena(NodeID pid, int n)
 {
-    const auto nid = createNode(pid, kids);
-    nodes_[pid]->setChild(nid, alt);
-    return nid;
+    const int kids = kids_[pid];
+
+    /// grow geometrically so that a node gaining children one at a time
+    /// (e.g. the root of an execution with restarts) is not copied every time
+    const auto offset = allocKids(std::max(n, 2 * kids));
+
+    for (auto alt = 0; alt < kids; ++alt)
+    {
+        kid_arena_[offset + alt] = getChild(pid, alt);
+    }
+
+    first_kid_[pid] = -(offset + 1);
+    return offset;
 }
 
-NodeID Structure::addExtraChild(NodeID pid)
+void Structure::appendChild(NodeID pid, NodeID nid)
 {
+    const int kids = kids_[pid];
+    const int first = first_kid_[pid];
 
-    const auto alt = childrenCount(pid);
+    if (kids == 0)
+    {
+        first_kid_[pid] = nid;
+    }
+    else if (first >= 0)
+    {
+        /// children are no longer consecutive nodes
+        if (first + kids != nid)
+        {
+            const auto offset = moveKidsToArena(pid, kids + 1);
+            kid_arena_[offset + kids] = nid;
+        }
+    }
+    else
+    {
+        auto offset = -first - 1;
+        const int capacity = kid_arena_[offset - 1];
+
+        if (kids == capacity)
+        {
+            /// only the last block in the arena can grow in place
+            if (offset + kids == kid_arena_.size())
+            {
+                kid_arena_.push_back(nid);
+                kid_arena_[offset - 1] = NodeID{capacity + 1};
+            }
+            else
+            {
+                offset = moveKidsToArena(pid, kids + 1);
+                kid_arena_[offset + kids] = nid;
+            }
+        }
+        else
+        {
+            kid_arena_[offset + kids] = nid;
+        }
+    }
 
-    /// make room for another child
-    nodes_[pid]->addChild();
+    kids_[pid] = kids + 1;
+}
 
-    auto kid = createChild(pid, alt, 0);
+NodeID Structure::addExtraChild(NodeID pid)
+{
+    const auto alt = childrenCount(pid);
+
+    const auto kid = createNode(pid, alt);
+    appendChild(pid, kid);
     return kid;
 }
 
 void Structure::addChildren(NodeID nid, int kids)
 {
-    if (nodes_[nid]->childrenCount() > 0)
+    if (kids_[nid] > 0)
         throw;
 
-    nodes_[nid]->setNumberOfChildren(kids);
+    if (kids == 0)
+        return;
+
+    const auto first = nodeCount();
 
     for (auto i = 0; i < kids; ++i)
     {
-        createChild(nid, i, 0);
+        createNode(nid, i);
     }
+
+    /// a reader that sees the new number of children also sees the first one
+    first_kid_[nid] = first;
+    kids_[nid] = kids;
 }
 
 /// Remove `alt` child of `pid`
 void Structure::removeChild(NodeID pid, int alt)
 {
-    nodes_[pid]->removeChild(alt);
+    const int kids = kids_[pid];
+
+    if (alt < 0 || alt >= kids)
+        throw no_child();
+
+    /// the remaining children go to a fresh block, so the old list stays
+    /// intact for readers that loaded it (or the old number of children)
+    const auto offset = allocKids(kids);
+
+    for (auto i = 0, pos = 0; i < kids; ++i)
+    {
+        if (i != alt)
+        {
+            kid_arena_[offset + pos++] = getChild(pid, i);
+        }
+    }
+
+    /// the spare entry is only read by readers that loaded the old number
+    /// of children; with the capacity set below, it is never overwritten
+    kid_arena_[offset + kids - 1] = getChild(pid, kids - 1);
+    kid_arena_[offset - 1] = NodeID{kids - 1};
+
+    kids_[pid] = kids - 1;
+    first_kid_[pid] = -(offset + 1);
+
+    /// siblings on the right have moved one position to the left
+    for (auto i = alt; i < kids - 1; ++i)
+    {
+        alt_[getChild(pid, i)] = i;
+    }
 }
 
 NodeID Structure::getChild(NodeID pid, int alt) const
 {
-    return nodes_[pid]->getChild(alt);
+    if (alt >= kids_[pid])
+    {
+        throw no_child();
+    }
+
+    const int first = first_kid_[pid];
+
+    if (first >= 0)
+    {
+        return NodeID{first + alt};
+    }
+
+    return kid_arena_[-first - 1 + alt];
 }
 
 NodeID Structure::getParent(NodeID nid) const
 {
-    return nodes_[nid]->getParent();
+    return parent_[nid];
 }
 
 int Structure::childrenCount(NodeID pid) const
 {
-    return nodes_[pid]->childrenCount();
+    return kids_[pid];
+}
+
+int Structure::childrenCount(NodeID pid, int node_count) const
+{
+    int kids = kids_[pid];
+
+    if (kids == 0)
+        return 0;
+
+    const int first = first_kid_[pid];
+
+    if (first >= 0)
+    {
+        /// consecutive children are created (and published) together
+        return first < node_count ? kids : 0;
+    }
+
+    /// children in the arena are appended with increasing ids
+    while (kids > 0 && kid_arena_[-first - 1 + kids - 1] >= node_count)
+    {
+        --kids;
+    }
+
+    return kids;
+}
+
+int Structure::getDepth(NodeID nid) const
+{
+    return depth_[nid];
 }
 
 int Structure::getNumberOfSiblings(NodeID nid) const
@@ -119,48 +253,55 @@ NodeID Structure::getRoot() const
 
 int Structure::getAlternative(NodeID nid) const
 {
-    auto parent_nid = getParent(nid);
-
-    if (parent_nid == NodeID::NoNode)
+    if (getParent(nid) == NodeID::NoNode)
         return -1;
 
-    for (auto i = 0; i < childrenCount(parent_nid); ++i)
-    {
-        if (getChild(parent_nid, i) == nid)
-        {
-            return i;
-        }
-    }
-    throw;
-    return -1;
+    return alt_[nid];
 }
 
 int Structure::nodeCount() const
 {
-    return nodes_.size();
+    return parent_.size();
 }
 
-void Structure::db_initialize(int size)
+void Structure::db_createRoot(NodeID nid)
 {
-    nodes_.resize(size);
+    if (nid != nodeCount())
+    {
+        throw invalid_tree();
+    }
+
+    createNode(NodeID::NoNode, -1);
 }
 
-void Structure::db_createRoot(NodeID nid)
+/// Note: children are expected to arrive in the order of their alternatives
+void Structure::db_addChild(NodeID nid, NodeID pid, int alt)
 {
-    db_createNode(nid, NodeID::NoNode, 0);
+    if (nid != nodeCount() || pid >= nid)
+    {
+        throw invalid_tree();
+    }
+
+    createNode(pid, alt);
+    appendChild(pid, nid);
 }
 
-void Structure::db_createChild(NodeID nid, NodeID pid, int alt)
+std::size_t Structure::bytesUsed() const
 {
-    db_createNode(nid, pid, 0);
-    nodes_[pid]->setChild(nid, alt);
+    return parent_.bytesAllocated() + alt_.bytesAllocated() +
+           kids_.bytesAllocated() + depth_.bytesAllocated() + first_kid_.bytesAllocated() +
+           kid_arena_.bytesAllocated();
 }
 
-void Structure::db_addChild(NodeID nid, NodeID pid, int alt)
+double Structure::bytesPerNode() const
 {
-    nodes_[pid]->addChild();
-    db_createChild(nid, pid, alt);
+    const auto count = nodeCount();
+
+    if (count == 0)
+        return 0;
+
+    return static_cast<double>(bytesUsed()) / count;
 }
 
 } // namespace tree
-} // namespace cpprofiler
\ No newline at end of file
+} // namespace cpprofiler
@@ -4,6 +4,8 @@
 #include "node.hh"
 
 #include "../core.hh"
+#include "../utils/chunked_vector.hh"
+#include "../utils/atomic_value.hh"
 
 #include "memory"
 
@@ -26,22 +28,55 @@ class LayoutComputer;
 /// Since it is not aware of statuses, labels etc., it is the caller's responsibility
 /// to ensure that this information is stored elsewhere when, for example, new nodes
 /// are created using Structure's API.
+///
+/// Nodes are stored column-wise (one entry per node in each column). Children
+/// created together (the common case) get consecutive identifiers, so for them
+/// only the first child is recorded; other child lists (e.g. grown one child at
+/// a time by `addExtraChild`) are kept in a shared arena.
+///
+/// Nodes are only ever appended and an existing node only gains children,
+/// so the structure can be read by other threads while one thread builds
+/// it (see `NodeTree::snapshot`); `removeChild` writes a new child list
+/// rather than changing the one readers may be walking.
 class Structure
 {
 
-    /// Protects `nodes_`
+    /// Protects the columns below
     mutable utils::Mutex mutex_;
 
-    /// Nodes that describe the structure of the tree
-    std::vector<std::unique_ptr<Node>> nodes_;
+    /// The parent of every node
+    utils::ChunkedVector<NodeID> parent_;
 
-    /// Allocate memory for a new node and return its Id
-    NodeID createNode(NodeID pid, int kids);
+    /// The position of every node among its siblings
+    /// (changed by `removeChild` while readers may load it)
+    utils::ChunkedVector<utils::AtomicValue<int>> alt_;
 
-    /// Create a new node with `kids` kids and add set it as the `alt`th kid of `pid`
-    NodeID createChild(NodeID pid, int alt, int kids);
+    /// The number of children of every node
+    utils::ChunkedVector<utils::AtomicValue<int>> kids_;
 
-    void db_createNode(NodeID nid, NodeID pid, int kids);
+    /// The depth of every node (the root has depth 1)
+    utils::ChunkedVector<int> depth_;
+
+    /// The first child (if children are consecutive nodes), or
+    /// the arena offset `off` of the child list encoded as `-(off + 1)`
+    utils::ChunkedVector<utils::AtomicValue<int>> first_kid_;
+
+    /// Child lists of nodes whose children are not consecutive; every block
+    /// is preceded by an entry holding its capacity (the number of children
+    /// it can hold before it has to be moved)
+    utils::ChunkedVector<NodeID> kid_arena_;
+
+    /// Append a node with no children and return its Id
+    NodeID createNode(NodeID pid, int alt);
+
+    /// Add `nid` as the right-most child of `pid`
+    void appendChild(NodeID pid, NodeID nid);
+
+    /// Reserve a block of `n` consecutive entries in the arena and return the offset of the first one
+    int allocKids(int n);
+
+    /// Move the child list of `pid` into a fresh arena block with room for at least `n` children
+    int moveKidsToArena(NodeID pid, int n);
 
   public:
     Structure();
@@ -67,6 +102,12 @@ class Structure
     /// Get the total number of children of node `pid`
     int childrenCount(NodeID pid) const;
 
+    /// Get the number of children of node `pid` among the first `node_count` nodes
+    int childrenCount(NodeID pid, int node_count) const;
+
+    /// Get the depth of node `nid`, i.e. the number of nodes on the path from the root
+    int getDepth(NodeID nid) const;
+
     /// Get the total nuber of nodes (including undetermined)
     int nodeCount() const;
 
@@ -81,18 +122,25 @@ class Structure
     /// Add `kids` children to an open node
     void addChildren(NodeID nid, int kids);
 
-    /// Remove `alt` child of `pid`
+    /// Remove `alt` child of `pid` (a concurrent reader sees either
+    /// the old or the new list of children, with either old or new
+    /// alternatives for the siblings that moved)
     void removeChild(NodeID pid, int alt);
 
     /// ************ Building a tree from a database ************
-
-    void db_initialize(int size);
+    /// (nodes are added in the order of their ids, after their parents)
 
     void db_createRoot(NodeID nid);
 
-    void db_createChild(NodeID nid, NodeID pid, int alt);
-
     void db_addChild(NodeID nid, NodeID pid, int alt);
+
+    /// ********************************************************************
+
+    /// Memory allocated for the structure (in bytes)
+    std::size_t bytesUsed() const;
+
+    /// Average memory used per node (in bytes)
+    double bytesPerNode() const;
 };
 
 } // namespace tree
@@ -18,6 +18,7 @@
 #include <QTextEdit>
 #include <QThread>
 #include <QVBoxLayout>
+#include <QJsonDocument>
 
 #include "cursors/nodevisitor.hh"
 #include "cursors/hide_failed_cursor.hh"
@@ -28,6 +29,7 @@
 #include "../user_data.hh"
 #include "../solver_data.hh"
 #include "layout_computer.hh"
+#include "layout_worker.hh"
 #include "../config.hh"
 
 #include "../nogood_dialog.hh"
@@ -40,15 +42,16 @@ namespace cpprofiler
 namespace tree
 {
 
-TraditionalView::TraditionalView(const NodeTree &tree, UserData &ud, SolverData &sd)
+TraditionalView::TraditionalView(const NodeTree &tree, UserData &ud, SolverData &sd, LayoutMode mode)
     : tree_(tree),
       user_data_(ud),
       solver_data_(sd),
       vis_flags_(utils::make_unique<VisualFlags>()),
-      layout_(utils::make_unique<Layout>()),
-      layout_computer_(utils::make_unique<LayoutComputer>(tree, *layout_, *vis_flags_))
+      layout_(utils::make_unique<Layout>(mode)),
+      layout_computer_(utils::make_unique<LayoutComputer>(tree, *layout_, *vis_flags_)),
+      layout_worker_(utils::make_unique<LayoutWorker>(*layout_computer_))
 {
-    utils::DebugMutexLocker tree_lock(&tree_.treeMutex());
+    utils::DebugMutexLocker tree_lock(&tree_.treeMutex(), "view: init");
 
     scroll_area_.reset(new TreeScrollArea(tree_.getRoot(), tree_, user_data_, *layout_, *vis_flags_));
 
@@ -59,7 +62,7 @@ TraditionalView::TraditionalView(const NodeTree &tree, UserData &ud, SolverData
     connect(scroll_area_.get(), &TreeScrollArea::nodeDoubleClicked, this, &TraditionalView::handleDoubleClick);
 
     connect(this, &TraditionalView::needsRedrawing, this, &TraditionalView::redraw);
-    connect(this, &TraditionalView::needsLayoutUpdate, this, &TraditionalView::updateLayout);
+    connect(this, &TraditionalView::needsLayoutUpdate, this, &TraditionalView::requestLayoutUpdate);
 
     connect(&tree, &NodeTree::childrenStructureChanged, [this](NodeID nid) {
         if (nid == NodeID::NoNode)
@@ -70,12 +73,29 @@ TraditionalView::TraditionalView(const NodeTree &tree, UserData &ud, SolverData
         // layout_->setLayoutDone(nid, false);
     });
 
-    auto autoLayoutTimer = new QTimer(this);
+    connect(&tree, &NodeTree::batchApplied, [this](const std::vector<NodeID> &dirtied) {
+        layout_computer_->dirtyUpLater(dirtied);
+    });
+
+    connect(layout_worker_.get(), &LayoutWorker::layoutUpdated, this, [this]() {
+        redraw();
+
+        /// (a pass may have ended before the changes to center after)
+        if (center_pending_ != NodeID::NoNode && !layout_computer_->hasPendingChanges())
+        {
+            centerNode(center_pending_);
+            center_pending_ = NodeID::NoNode;
+        }
+    });
+
+    layout_worker_->start();
+
+    auto_layout_timer_ = new QTimer(this);
+    auto_layout_timer_->setInterval(100);
 
-    connect(autoLayoutTimer, &QTimer::timeout, this, &TraditionalView::autoUpdate);
+    connect(auto_layout_timer_, &QTimer::timeout, this, &TraditionalView::autoUpdate);
 
-    /// stop this timer up when the tree is finished?
-    autoLayoutTimer->start(100);
+    auto_layout_timer_->start();
 }
 
 TraditionalView::~TraditionalView() = default;
@@ -111,7 +131,7 @@ void TraditionalView::navDown()
     if (nid == NodeID::NoNode)
         return;
 
-    utils::DebugMutexLocker tree_lock(&tree_.treeMutex());
+    utils::DebugMutexLocker tree_lock(&tree_.treeMutex(), "view: navigate");
 
     const auto kids = tree_.childrenCount(nid);
 
@@ -131,7 +151,7 @@ void TraditionalView::navDownAlt()
     if (nid == NodeID::NoNode)
         return;
 
-    utils::DebugMutexLocker tree_lock(&tree_.treeMutex());
+    utils::DebugMutexLocker tree_lock(&tree_.treeMutex(), "view: navigate");
 
     const auto kids = tree_.childrenCount(nid);
 
@@ -150,7 +170,7 @@ void TraditionalView::navUp()
     if (nid == NodeID::NoNode)
         return;
 
-    utils::DebugMutexLocker tree_lock(&tree_.treeMutex());
+    utils::DebugMutexLocker tree_lock(&tree_.treeMutex(), "view: navigate");
 
     auto pid = tree_.getParent(nid);
 
@@ -168,7 +188,7 @@ void TraditionalView::navLeft()
     if (nid == NodeID::NoNode)
         return;
 
-    utils::DebugMutexLocker tree_lock(&tree_.treeMutex());
+    utils::DebugMutexLocker tree_lock(&tree_.treeMutex(), "view: navigate");
 
     auto pid = tree_.getParent(nid);
     if (pid == NodeID::NoNode)
@@ -192,7 +212,7 @@ void TraditionalView::navRight()
     if (nid == NodeID::NoNode)
         return;
 
-    utils::DebugMutexLocker tree_lock(&tree_.treeMutex());
+    utils::DebugMutexLocker tree_lock(&tree_.treeMutex(), "view: navigate");
 
     auto pid = tree_.getParent(nid);
 
@@ -214,8 +234,10 @@ void TraditionalView::navRight()
 
 void TraditionalView::setLabelShown(NodeID nid, bool val)
 {
+    utils::DebugMutexLocker layout_lock(&layout_->getMutex(), "view: show label");
+
     vis_flags_->setLabelShown(nid, val);
-    layout_computer_->dirtyUpLater(nid);
+    dirtyUp(nid);
 }
 
 void TraditionalView::toggleShowLabel()
@@ -236,6 +258,8 @@ void TraditionalView::showLabelsDown()
     if (nid == NodeID::NoNode)
         return;
 
+    utils::DebugMutexLocker layout_lock(&layout_->getMutex(), "view: show labels down");
+
     auto val = !vis_flags_->isLabelShown(nid);
 
     utils::pre_order_apply(tree_, nid, [val, this](NodeID nid) {
@@ -261,6 +285,8 @@ void TraditionalView::showLabelsUp()
         return;
     }
 
+    utils::DebugMutexLocker layout_lock(&layout_->getMutex(), "view: show labels up");
+
     auto val = !vis_flags_->isLabelShown(pid);
 
     while (nid != NodeID::NoNode)
@@ -280,8 +306,8 @@ static bool is_leaf(const NodeTree &nt, NodeID nid)
 
 void TraditionalView::hideNode(NodeID n, bool delayed)
 {
-    utils::DebugMutexLocker tree_lock(&tree_.treeMutex());
-    utils::DebugMutexLocker layout_lock(&layout_->getMutex());
+    utils::DebugMutexLocker tree_lock(&tree_.treeMutex(), "view: hide");
+    utils::DebugMutexLocker layout_lock(&layout_->getMutex(), "view: hide");
 
     if (is_leaf(tree_, n))
         return;
@@ -311,10 +337,14 @@ void TraditionalView::toggleHidden()
     if (is_leaf(tree_, nid))
         return;
 
-    auto val = !vis_flags_->isHidden(nid);
-    vis_flags_->setHidden(nid, val);
+    {
+        utils::DebugMutexLocker layout_lock(&layout_->getMutex(), "view: toggle hidden");
+
+        auto val = !vis_flags_->isHidden(nid);
+        vis_flags_->setHidden(nid, val);
 
-    dirtyUp(nid);
+        dirtyUp(nid);
+    }
 
     emit needsLayoutUpdate();
     emit needsRedrawing();
@@ -326,6 +356,8 @@ void TraditionalView::hideFailedAt(NodeID n, bool onlyDirty)
     if (tree_.nodeCount() == 0)
         return;
 
+    utils::DebugMutexLocker layout_lock(&layout_->getMutex(), "view: hide failed");
+
     bool modified = false;
 
     HideFailedCursor hfc(n, tree_, *vis_flags_, *layout_computer_, onlyDirty, modified);
@@ -349,13 +381,23 @@ void TraditionalView::hideFailed(bool onlyDirty)
 
 void TraditionalView::autoUpdate()
 {
-    if (!layout_stale_)
+    if (layout_stale_.exchange(false))
+    {
+        layout_worker_->requestUpdate();
         return;
+    }
+
+    /// nothing changes by itself once the tree is complete and laid out
+    if (!tree_.isDone() || !layout_worker_->isIdle() || layout_computer_->hasPendingChanges())
+        return;
+
+    auto_layout_active_ = false;
+    auto_layout_timer_->stop();
 
-    const auto changed = updateLayout();
-    if (changed)
+    /// in case the layout became stale in the meantime
+    if (layout_stale_ && !auto_layout_active_.exchange(true))
     {
-        emit needsRedrawing();
+        auto_layout_timer_->start();
     }
 }
 
@@ -378,15 +420,19 @@ void TraditionalView::handleDoubleClick()
     }
 
     /// should this happen automatically whenever the layout is changed?
-    centerCurrentNode();
+    centerNodeWhenLaidOut(nid);
 }
 
 void TraditionalView::toggleCollapsePentagon(NodeID nid)
 {
     /// Use the same 'hidden' flag for now
-    auto val = !vis_flags_->isHidden(nid);
-    vis_flags_->setHidden(nid, val);
-    dirtyUp(nid);
+    {
+        utils::DebugMutexLocker layout_lock(&layout_->getMutex(), "view: toggle pentagon");
+
+        auto val = !vis_flags_->isHidden(nid);
+        vis_flags_->setHidden(nid, val);
+        dirtyUp(nid);
+    }
     emit needsLayoutUpdate();
     emit needsRedrawing();
 }
@@ -399,8 +445,8 @@ void TraditionalView::setNodeHidden(NodeID n, bool val)
 
 void TraditionalView::unhideNode(NodeID nid)
 {
-    utils::DebugMutexLocker tree_lock(&tree_.treeMutex());
-    utils::DebugMutexLocker layout_lock(&layout_->getMutex());
+    utils::DebugMutexLocker tree_lock(&tree_.treeMutex(), "view: unhide");
+    utils::DebugMutexLocker layout_lock(&layout_->getMutex(), "view: unhide");
 
     auto hidden = vis_flags_->isHidden(nid);
     if (hidden)
@@ -438,8 +484,8 @@ void TraditionalView::bookmarkCurrentNode()
 
 void TraditionalView::unhideAllAt(NodeID n)
 {
-    utils::DebugMutexLocker tree_lock(&tree_.treeMutex());
-    utils::DebugMutexLocker layout_lock(&layout_->getMutex());
+    utils::DebugMutexLocker tree_lock(&tree_.treeMutex(), "view: unhide all");
+    utils::DebugMutexLocker layout_lock(&layout_->getMutex(), "view: unhide all");
 
     if (n == tree_.getRoot())
     {
@@ -468,29 +514,32 @@ void TraditionalView::unhideAllAt(NodeID n)
         emit needsRedrawing();
     }
 
-    centerCurrentNode();
+    centerNodeWhenLaidOut(node());
 }
 
 void TraditionalView::unhideAll()
 {
-
-    /// faster version for the entire tree
-    if (vis_flags_->hiddenCount() == 0)
     {
-        return;
-    }
+        utils::DebugMutexLocker layout_lock(&layout_->getMutex(), "view: unhide all");
 
-    for (auto n : vis_flags_->hidden_nodes())
-    {
-        dirtyUp(n);
-        layout_->setLayoutDone(n, false);
-    }
+        /// faster version for the entire tree
+        if (vis_flags_->hiddenCount() == 0)
+        {
+            return;
+        }
 
-    vis_flags_->unhideAll();
+        for (auto n : vis_flags_->hidden_nodes())
+        {
+            dirtyUp(n);
+            layout_->setLayoutDone(n, false);
+        }
+
+        vis_flags_->unhideAll();
+    }
 
     emit needsLayoutUpdate();
     emit needsRedrawing();
-    centerNode(tree_.getRoot());
+    centerNodeWhenLaidOut(tree_.getRoot());
 }
 
 void TraditionalView::unhideAllAtCurrent()
@@ -508,8 +557,12 @@ void TraditionalView::toggleHighlighted()
     if (nid == NodeID::NoNode)
         return;
 
-    auto val = !vis_flags_->isHighlighted(nid);
-    vis_flags_->setHighlighted(nid, val);
+    {
+        utils::DebugMutexLocker layout_lock(&layout_->getMutex(), "view: toggle highlighted");
+
+        auto val = !vis_flags_->isHighlighted(nid);
+        vis_flags_->setHighlighted(nid, val);
+    }
 
     emit needsRedrawing();
 }
@@ -543,9 +596,10 @@ static int global_node_x_offset(const NodeTree &tree, const Layout &layout, Node
     return x_off;
 }
 
-/// Does this need any locking?
 void TraditionalView::centerNode(NodeID nid)
 {
+    /// the layout may be being updated by the worker
+    utils::DebugMutexLocker layout_lock(&layout_->getMutex(), "view: center");
 
     const auto x_offset = global_node_x_offset(tree_, *layout_, nid);
 
@@ -554,7 +608,7 @@ void TraditionalView::centerNode(NodeID nid)
 
     const auto value_x = x_offset - bb.left;
 
-    const auto depth = utils::calculate_depth(tree_, nid);
+    const auto depth = tree_.getDepth(nid);
     const auto value_y = depth * layout::dist_y;
 
     scroll_area_->centerPoint(value_x, value_y);
@@ -565,6 +619,12 @@ void TraditionalView::centerCurrentNode()
     centerNode(node());
 }
 
+void TraditionalView::centerNodeWhenLaidOut(NodeID nid)
+{
+    centerNode(nid);
+    center_pending_ = nid;
+}
+
 void TraditionalView::setCurrentNode(NodeID nid)
 {
     user_data_.setSelectedNode(nid);
@@ -577,22 +637,35 @@ void TraditionalView::setAndCenterNode(NodeID nid)
     centerNode(nid);
 }
 
+void TraditionalView::requestLayoutUpdate()
+{
+    /// the worker lays out in slices, so the view stays responsive
+    /// however much of the tree needs a new layout
+    layout_worker_->requestUpdate();
+}
+
 bool TraditionalView::updateLayout()
 {
-    const auto changed = layout_computer_->compute();
-    layout_stale_ = false;
+    /// rather than wait for the worker's slice to end
+    layout_computer_->cancel();
 
-    return changed;
+    return layout_computer_->compute();
 }
 
 void TraditionalView::setLayoutOutdated()
 {
     layout_stale_ = true;
+
+    if (!auto_layout_active_.exchange(true))
+    {
+        QMetaObject::invokeMethod(auto_layout_timer_, "start", Qt::QueuedConnection);
+    }
 }
 
 void TraditionalView::dirtyUp(NodeID nid)
 {
     layout_computer_->dirtyUpLater(nid);
+    setLayoutOutdated();
 }
 
 void TraditionalView::dirtyCurrentNodeUp()
@@ -621,7 +694,7 @@ void TraditionalView::printNodeInfo()
     print("has solved kids: {}, ", tree_.hasSolvedChildren(nid));
     print("has open kids: {}", tree_.hasOpenChildren(nid));
 
-    const auto &ng = tree_.getNogood(nid);
+    const auto ng = tree_.getNogood(nid);
 
     if (ng.has_renamed())
     {
@@ -657,8 +730,8 @@ class TreeHighlighter : public QThread
 
     void run() override
     {
-        utils::DebugMutexLocker t_locker(&tree_.treeMutex());
-        utils::DebugMutexLocker l_locker(&layout_.getMutex());
+        utils::DebugMutexLocker t_locker(&tree_.treeMutex(), "view: node info");
+        utils::DebugMutexLocker l_locker(&layout_.getMutex(), "view: node info");
 
         auto root = tree_.getRoot();
 
@@ -669,8 +742,8 @@ class TreeHighlighter : public QThread
 
 void TraditionalView::revealNode(NodeID n)
 {
-    utils::DebugMutexLocker t_locker(&tree_.treeMutex());
-    utils::DebugMutexLocker l_locker(&layout_->getMutex());
+    utils::DebugMutexLocker t_locker(&tree_.treeMutex(), "view: reveal");
+    utils::DebugMutexLocker l_locker(&layout_->getMutex(), "view: reveal");
 
     layout_computer_->dirtyUpUnconditional(n);
 
@@ -686,6 +759,8 @@ void TraditionalView::revealNode(NodeID n)
 
 void TraditionalView::highlightSubtrees(const std::vector<NodeID> &nodes, bool hide_rest, bool show_outline)
 {
+    utils::DebugMutexLocker layout_lock(&layout_->getMutex(), "view: highlight");
+
     vis_flags_->unhighlightAll();
 
     detail::PerformanceHelper phelper;
@@ -721,10 +796,12 @@ void TraditionalView::highlightSubtrees(const std::vector<NodeID> &nodes, bool h
 /// Lantern Tree Visualisation
 void TraditionalView::hideBySize(int size_limit)
 {
-    utils::DebugMutexLocker tree_lock(&tree_.treeMutex());
+    utils::DebugMutexLocker tree_lock(&tree_.treeMutex(), "view: hide by size");
 
     unhideAll();
 
+    utils::DebugMutexLocker layout_lock(&layout_->getMutex(), "view: hide by size");
+
     vis_flags_->resetLanternSizes();
 
     const int max_lantern = 127;
@@ -771,11 +848,13 @@ void TraditionalView::hideBySize(int size_limit)
     emit needsLayoutUpdate();
     emit needsRedrawing();
 
-    centerCurrentNode();
+    centerNodeWhenLaidOut(node());
 }
 
 void TraditionalView::undoLanterns()
 {
+    utils::DebugMutexLocker layout_lock(&layout_->getMutex(), "view: undo lanterns");
+
     vis_flags_->resetLanternSizes();
 }
 
@@ -792,8 +871,12 @@ void TraditionalView::showNodeInfo() const
     auto info_dialog = new QDialog;
     auto layout = new QVBoxLayout(info_dialog);
 
+    /// info is only decoded in full when it is displayed
+    const auto info = QByteArray::fromStdString(solver_data_.getInfo(cur_nid));
+    const auto json_doc = QJsonDocument::fromJson(info);
+
     QTextEdit* te = new QTextEdit;
-    te->append(solver_data_.getInfo(cur_nid).c_str());
+    te->append(json_doc.isNull() ? QString(info) : QString(json_doc.toJson(QJsonDocument::Indented)));
 
     layout->addWidget(te);
 
@@ -818,7 +901,8 @@ void TraditionalView::showNogoods() const
 
     connect(ng_dialog, &NogoodDialog::nogoodClicked, [this](NodeID nid) {
         const_cast<TraditionalView *>(this)->revealNode(nid);
-        const_cast<TraditionalView *>(this)->setAndCenterNode(nid);
+        const_cast<TraditionalView *>(this)->setCurrentNode(nid);
+        const_cast<TraditionalView *>(this)->centerNodeWhenLaidOut(nid);
         emit nogoodsClicked({nid});
     });
 
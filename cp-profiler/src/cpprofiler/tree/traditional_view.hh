@@ -3,11 +3,14 @@
 
 #include <QWidget>
 
+#include <atomic>
 #include <memory>
 #include <set>
 #include "node_id.hh"
 #include "visual_flags.hh"
 
+class QTimer;
+
 namespace cpprofiler
 {
 class UserData;
@@ -21,6 +24,8 @@ namespace tree
 
 class Layout;
 class LayoutComputer;
+class LayoutWorker;
+enum class LayoutMode;
 class NodeTree;
 class NodeID;
 class Structure;
@@ -49,14 +54,27 @@ class TraditionalView : public QObject
     /// Responsible for keeping the layout up to date
     std::unique_ptr<LayoutComputer> layout_computer_;
 
+    /// Lays out the tree as it grows (stopped before the computer is destroyed)
+    std::unique_ptr<LayoutWorker> layout_worker_;
+
     /// The area the tree is actually drawn onto
     std::unique_ptr<TreeScrollArea> scroll_area_;
 
     /// Whether node ids should be shown instead of true labels (for debugging)
     bool nid_shown_ = false;
 
-    /// Only update layout if it is stale
-    bool layout_stale_ = true;
+    /// Only update layout if it is stale (set from the builder's thread too)
+    std::atomic<bool> layout_stale_{true};
+
+    /// Wakes the layout worker when the layout is stale; stopped once
+    /// the tree is done and laid out
+    QTimer *auto_layout_timer_;
+
+    /// Whether `auto_layout_timer_` is running (or about to be restarted)
+    std::atomic<bool> auto_layout_active_{true};
+
+    /// Node to center again once the worker completes its pass
+    NodeID center_pending_ = NodeID::NoNode;
 
     /// Sets nid as the currently selected node
     void setNode(NodeID nid);
@@ -65,7 +83,8 @@ class TraditionalView : public QObject
     void setNodeHidden(NodeID nid, bool val);
 
   public:
-    TraditionalView(const NodeTree &tree, UserData &ud, SolverData &sd);
+    /// `mode` selects how the layout represents the outlines of subtrees
+    TraditionalView(const NodeTree &tree, UserData &ud, SolverData &sd, LayoutMode mode);
     ~TraditionalView();
 
     /// Returns currently selected node; can be NodeID::NoNode
@@ -90,7 +109,7 @@ class TraditionalView : public QObject
     /// Triggers a redraw that updates scrollarea's viewport (perhaps a direct call would suffice)
     void needsRedrawing();
 
-    /// Triggers unconditional update of the layout
+    /// Triggers an update of the layout (by the worker)
     void needsLayoutUpdate();
 
     /// Notify all views to change their current nodes to `n`
@@ -103,7 +122,7 @@ class TraditionalView : public QObject
     /// Update scrollarea's viewport
     void redraw();
 
-    /// Updates the layout if it is stale (triggered by timer)
+    /// Has the layout updated in the background if it is stale (triggered by timer)
     void autoUpdate();
 
     /// Handle double-click on a node
@@ -118,6 +137,10 @@ class TraditionalView : public QObject
     /// Center currently selected node
     void centerCurrentNode();
 
+    /// Center node `nid` now and again once the layout requested
+    /// alongside has been computed
+    void centerNodeWhenLaidOut(NodeID nid);
+
     /// Set current node to nid
     void setCurrentNode(NodeID nid);
 
@@ -185,11 +208,14 @@ class TraditionalView : public QObject
     /// Highlight/unhighlight subtree
     void toggleHighlighted();
 
-    /// Unconditionally update layout (ignoring if it is "stale")
-    /// returns false if no change was required
+    /// Have the worker update the layout (ignoring if it is "stale")
+    void requestLayoutUpdate();
+
+    /// Unconditionally update layout on the calling thread (ignoring if it
+    /// is "stale"); returns false if no change was required
     bool updateLayout();
 
-    /// Set layout as stale
+    /// Set layout as stale (may be called from any thread)
     void setLayoutOutdated();
 
     /// Print node info for debugging
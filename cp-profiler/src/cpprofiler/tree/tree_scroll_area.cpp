@@ -67,16 +67,22 @@ void TreeScrollArea::paintEvent(QPaintEvent *event)
 
     painter.scale(m_options.scale, m_options.scale);
 
+    /// held for a slice at most by the layout worker
+    utils::MutexLocker layout_lock(&m_layout.getMutex(), "scroll area: paint");
+
     if (!m_layout.ready(m_start_node) || !m_layout.getLayoutDone(m_start_node))
     {
         return;
     }
 
-    auto bb = m_layout.getBoundingBox(m_start_node);
+    /// while a layout pass is under way, the extent of the last complete one
+    const auto published = m_layout.published(m_start_node);
+
+    auto bb = published ? published->bb : m_layout.getBoundingBox(m_start_node);
 
     auto tree_width = bb.right - bb.left;
 
-    auto tree_height = m_layout.getHeight(m_start_node) * layout::dist_y;
+    auto tree_height = (published ? published->height : m_layout.getHeight(m_start_node)) * layout::dist_y;
 
     auto viewport_size = viewport()->size();
 
@@ -102,7 +108,6 @@ void TreeScrollArea::paintEvent(QPaintEvent *event)
     auto x_off = horizontalScrollBar()->value();
     auto y_off = verticalScrollBar()->value();
     painter.translate(-x_off, -y_off);
-    /// TODO: this need to aquire layout mutex
 
     auto half_w = viewport()->width() / 2;
     auto half_h = viewport()->height() / 2;
@@ -133,7 +138,7 @@ void TreeScrollArea::paintEvent(QPaintEvent *event)
 
     // drawGrid(painter, {std::max(tree_width, displayed_width), std::max(tree_height, displayed_height)});
 
-    utils::MutexLocker tree_locker(&m_tree.treeMutex());
+    SnapshotPin pin(m_tree);
 
     DrawingCursor dc(m_start_node, m_tree, m_layout, user_data_, m_vis_flags, painter, start_pos, clip, debug_mode_);
     PreorderNodeVisitor<DrawingCursor>(dc).run();
@@ -181,8 +186,8 @@ void TreeScrollArea::setScale(int val)
 /// Make sure the layout for nodes is done
 NodeID TreeScrollArea::findNodeClicked(int x, int y)
 {
-    utils::MutexLocker tree_lock(&m_tree.treeMutex());
-    utils::MutexLocker layout_lock(&m_layout.getMutex());
+    SnapshotPin pin(m_tree);
+    utils::MutexLocker layout_lock(&m_layout.getMutex(), "scroll area: click");
 
     using namespace traditional;
 
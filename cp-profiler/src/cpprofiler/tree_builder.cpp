@@ -1,14 +1,16 @@
 #include "tree_builder.hh"
 
-#include "../cpp-integration/message.hpp"
-
 #include "utils/perf_helper.hh"
 #include "utils/debug.hh"
+#include "utils/debug_mutex.hh"
 #include "execution.hh"
 
 #include "tree/node_tree.hh"
 #include "name_map.hh"
+#include "settings.hh"
 
+#include <QThread>
+#include <algorithm>
 #include <thread>
 
 namespace cpprofiler
@@ -51,12 +53,112 @@ static std::ostream &operator<<(std::ostream &os, const Message &msg)
     return os;
 }
 
-TreeBuilder::TreeBuilder(Execution &ex) : m_execution(ex)
+constexpr int TreeBuilder::MAX_BATCH_SIZE;
+constexpr int TreeBuilder::MAX_SHARDS;
+
+BuilderShard::BuilderShard(TreeBuilder &builder, QObject *parent)
+    : QObject(parent), m_builder(builder) {}
+
+void BuilderShard::reportDepth(IngestStats &stats, int depth)
+{
+    /// other shards update the same counter: only add the difference
+    stats.queue_depth.fetch_add(depth - m_reported_depth);
+    m_reported_depth = depth;
+}
+
+void BuilderShard::handleNodes(std::shared_ptr<NodeQueue> queue)
+{
+    /// nodes pushed after this point need a new notification
+    /// (pairs with the fence in ReceiverWorker::notifyBuilder)
+    queue->notified.store(false);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    auto &execution = m_builder.m_execution;
+
+    auto &stats = execution.ingestStats();
+
+    if (m_counted_queue != queue.get())
+    {
+        stats.queue_capacity.fetch_add(queue->capacity());
+        m_counted_queue = queue.get();
+    }
+
+    int available;
+
+    while ((available = queue->size()) > 0)
+    {
+        reportDepth(stats, available);
+
+        const auto n = std::min(available, TreeBuilder::MAX_BATCH_SIZE);
+
+        if (static_cast<int>(m_batch_info.size()) < n)
+        {
+            m_batch_info.resize(n);
+        }
+
+        /// scanning info is the bulk of the work and does not need the lock
+        for (auto i = 0; i < n; ++i)
+        {
+            const auto &node = queue->at(i);
+
+            if (node.has_info() && !node.info().empty())
+            {
+                SolverData::scanInfo(node.info(), m_batch_info[i]);
+            }
+        }
+
+        execution.tree().applyBatch([&]() {
+            for (auto i = 0; i < n; ++i)
+            {
+                m_builder.addNode(queue->at(i), m_batch_info[i]);
+            }
+        });
+
+        /// the slots can now be reused by the receiver
+        queue->pop(n);
+    }
+
+    reportDepth(stats, 0);
+}
+
+int TreeBuilder::shardCount(const Settings &s)
+{
+    if (s.builder_shards > 0)
+    {
+        return std::min(s.builder_shards, MAX_SHARDS);
+    }
+
+    const int cores = std::thread::hardware_concurrency();
+    return std::max(1, std::min(cores, MAX_SHARDS));
+}
+
+TreeBuilder::TreeBuilder(Execution &ex, int shards) : m_execution(ex)
 {
     std::cerr << "  TreeBuilder()\n";
+
+    /// the first shard moves to the builder's thread along with the builder
+    m_shards.assign(std::max(shards, 1), nullptr);
+    m_shard_threads.assign(m_shards.size(), nullptr);
+    m_shards[0] = new BuilderShard(*this, this);
+
     startBuilding();
 }
 
+TreeBuilder::~TreeBuilder()
+{
+    for (auto i = 1u; i < m_shard_threads.size(); ++i)
+    {
+        if (!m_shard_threads[i])
+            continue;
+
+        m_shard_threads[i]->quit();
+        m_shard_threads[i]->wait();
+
+        delete m_shards[i];
+        delete m_shard_threads[i];
+    }
+}
+
 void TreeBuilder::startBuilding()
 {
     perfHelper.begin("tree building");
@@ -65,80 +167,178 @@ void TreeBuilder::startBuilding()
 
 void TreeBuilder::finishBuilding()
 {
+    /// nodes passed on to other shards must be in the tree by now
+    for (auto i = 1u; i < m_shards.size(); ++i)
+    {
+        if (m_shards[i])
+        {
+            QMetaObject::invokeMethod(m_shards[i], "sync", Qt::BlockingQueuedConnection);
+        }
+    }
+
+    {
+        utils::MutexLocker tree_lock(&m_execution.tree().treeMutex(), "builder: finish");
+
+        std::size_t orphans = 0;
+
+        for (const auto &pending : m_pending)
+        {
+            orphans += pending.second.size();
+        }
+
+        if (orphans > 0)
+        {
+            print("Builder: {} nodes were dropped (their parents never arrived)", orphans);
+        }
+    }
+
     perfHelper.end();
     print("Builder: done building");
+    print("Builder: tree structure uses {} bytes per node", m_execution.tree().bytesPerNode());
     emit buildingDone();
 }
 
-void TreeBuilder::handleNode(Message *node)
+BuilderShard *TreeBuilder::shardFor(const NodeQueue &queue)
 {
+    const auto idx = queue.shard % m_shards.size();
 
-    std::unique_ptr<Message> node_msg{node};
-    // print("node: {}", *node);
+    if (!m_shards[idx])
+    {
+        auto shard = new BuilderShard(*this);
+        auto thread = new QThread();
 
-    const auto n_uid = node->nodeUID();
-    const auto p_uid = node->parentUID();
+        shard->moveToThread(thread);
+        thread->start();
 
-    auto &tree = m_execution.tree();
+        m_shards[idx] = shard;
+        m_shard_threads[idx] = thread;
+    }
 
-    tree::NodeID pid = tree::NodeID::NoNode;
+    return m_shards[idx];
+}
 
-    if (p_uid.nid != -1)
+void TreeBuilder::handleNodes(std::shared_ptr<NodeQueue> queue)
+{
+    const auto shard = shardFor(*queue);
+
+    if (shard->thread() == thread())
     {
-        /// should solver data be moved to node tree?
-        pid = m_execution.solver_data().getNodeId({p_uid.nid, p_uid.rid, p_uid.tid});
+        shard->handleNodes(queue);
+        return;
     }
 
-    const auto kids = node->kids();
-    const auto alt = node->alt();
-    const auto status = static_cast<tree::NodeStatus>(node->status());
-    const auto &label = node->has_label() ? node->label() : tree::emptyLabel;
+    QMetaObject::invokeMethod(shard, "handleNodes", Qt::QueuedConnection,
+                              Q_ARG(std::shared_ptr<cpprofiler::NodeQueue>, queue));
+}
 
-    NodeID nid;
+NodeID TreeBuilder::addNode(const Message &node, ParsedInfo &info)
+{
+    const auto p_uid = node.parentUID();
+
+    auto &sd = m_execution.solver_data();
 
+    NodeID pid = NodeID::NoNode;
+
+    if (p_uid.nid != -1)
     {
-        utils::MutexLocker tree_lock(&tree.treeMutex(), "builder");
+        const SolverID parent{p_uid.nid, p_uid.rid, p_uid.tid};
+
+        /// should solver data be moved to node tree?
+        pid = sd.getNodeId(parent);
 
         if (pid == NodeID::NoNode)
         {
-
-            if (m_execution.doesRestarts())
-            {
-                tree.addExtraChild(NodeID{0});
-                nid = tree.promoteNode(NodeID{0}, restart_count++, kids, status, label);
-            }
-            else
-            {
-                nid = tree.createRoot(kids);
-            }
+            /// the parent is yet to arrive (from another solver thread)
+            m_pending[parent].push_back({node, std::move(info)});
+            return NodeID::NoNode;
         }
-        else
+    }
+
+    const auto nid = applyNode(node, pid);
+    storeNodeData(nid, node, info);
+
+    if (m_pending.empty())
+        return nid;
+
+    /// add nodes that were waiting for this one (and, in turn, for those)
+    const auto n_uid = node.nodeUID();
+    std::vector<std::pair<SolverID, NodeID>> parents{{{n_uid.nid, n_uid.rid, n_uid.tid}, nid}};
+
+    while (!parents.empty())
+    {
+        const auto parent = parents.back();
+        parents.pop_back();
+
+        const auto it = m_pending.find(parent.first);
+
+        if (it == m_pending.end())
+            continue;
+
+        auto children = std::move(it->second);
+        m_pending.erase(it);
+
+        for (auto &child : children)
         {
-            nid = tree.promoteNode(pid, alt, kids, status, label);
+            const auto child_nid = applyNode(child.msg, parent.second);
+            storeNodeData(child_nid, child.msg, child.info);
+
+            const auto c_uid = child.msg.nodeUID();
+            parents.push_back({{c_uid.nid, c_uid.rid, c_uid.tid}, child_nid});
         }
     }
 
-    m_execution.solver_data().setNodeId({n_uid.nid, n_uid.rid, n_uid.tid}, nid);
+    return nid;
+}
 
-    if (node->has_nogood())
+NodeID TreeBuilder::applyNode(const Message &node, NodeID pid)
+{
+    // print("node: {}", node);
+
+    const auto n_uid = node.nodeUID();
+
+    auto &tree = m_execution.tree();
+
+    const auto kids = node.kids();
+    const auto alt = node.alt();
+    const auto status = static_cast<tree::NodeStatus>(node.status());
+    const auto &label = node.has_label() ? node.label() : tree::emptyLabel;
+
+    NodeID nid;
+
+    if (pid == NodeID::NoNode)
     {
-        const auto nm = m_execution.nameMap();
 
-        if (nm)
+        if (m_execution.doesRestarts())
         {
-            /// Construct a renamed nogood using the name map
-            const auto renamed = m_execution.nameMap()->replaceNames(node->nogood());
-            m_execution.solver_data().setNogood(nid, node->nogood(), renamed);
+            nid = tree.addRestart(kids, status, label);
         }
         else
         {
-            m_execution.solver_data().setNogood(nid, node->nogood());
+            nid = tree.createRoot(kids);
         }
     }
+    else
+    {
+        nid = tree.promoteNode(pid, alt, kids, status, label);
+    }
+
+    /// nodes later in the same batch may refer to this one as their parent
+    m_execution.solver_data().setNodeId({n_uid.nid, n_uid.rid, n_uid.tid}, nid);
+
+    return nid;
+}
+
+void TreeBuilder::storeNodeData(NodeID nid, const Message &node, ParsedInfo &info)
+{
+    if (node.has_nogood())
+    {
+        /// nogoods are renamed when displayed (see NodeTree::getNogood)
+        m_execution.solver_data().setNogood(nid, node.nogood());
+    }
 
-    if (node->has_info() && !node->info().empty())
+    if (node.has_info() && !node.info().empty())
     {
-        m_execution.solver_data().processInfo(nid, node->info());
+        m_execution.solver_data().storeInfo(nid, node.info(), info);
     }
 }
 
@@ -1,36 +1,159 @@
 #pragma once
 
 #include <QObject>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "../cpp-integration/message.hpp"
+#include "solver_data.hh"
+#include "tree/node_id.hh"
+#include "utils/spsc_queue.hh"
+
+class QThread;
 
 namespace cpprofiler
 {
 
-class Message;
 class Execution;
+struct IngestStats;
+class Settings;
+class TreeBuilder;
+
+/// Node messages passed from a receiver to the builder
+class NodeQueue : public utils::SpscQueue<Message>
+{
+  public:
+    NodeQueue(int capacity, int shard = 0)
+        : utils::SpscQueue<Message>(capacity), shard(shard), notified(false) {}
+
+    /// The builder shard draining this queue
+    const int shard;
+
+    /// Whether the builder has been told about new nodes since it last
+    /// started draining the queue
+    std::atomic<bool> notified;
+};
+
+/// Builds the nodes of some of the solver's threads (see `TreeBuilder`)
+class BuilderShard : public QObject
+{
+    Q_OBJECT
+
+    TreeBuilder &m_builder;
+
+    /// Info of the current batch's nodes (scanned before locking the tree)
+    std::vector<ParsedInfo> m_batch_info;
+
+    /// The queue whose capacity the shard has added to the ingest stats
+    const NodeQueue *m_counted_queue = nullptr;
+
+    /// The shard's share of the ingest stats' queue depth
+    int m_reported_depth = 0;
+
+    /// Replace the shard's share of the queue depth with `depth`
+    void reportDepth(IngestStats &stats, int depth);
+
+  public:
+    explicit BuilderShard(TreeBuilder &builder, QObject *parent = nullptr);
 
+  public slots:
+
+    /// Add all nodes waiting in `queue` to the tree, locking the tree
+    /// once per batch of nodes
+    void handleNodes(std::shared_ptr<cpprofiler::NodeQueue> queue);
+
+    /// Return once all nodes passed to the shard so far have been handled
+    void sync() {}
+};
+
+/// Builds the tree of an execution from node messages.
+///
+/// Messages are routed to shards by the solver thread that sent them (see
+/// `shardOf`); every shard drains its own queues on its own thread, scanning
+/// node info in parallel with other shards and only taking the tree lock to
+/// add the nodes. All shards add to the same tree, so adding nodes is still
+/// serialised: shards only help as much as scanning info costs. Since
+/// threads are not synchronised with each other, a node may arrive before
+/// its parent (sent by another thread): such nodes are put aside until the
+/// parent is added.
 class TreeBuilder : public QObject
 {
     Q_OBJECT
 
+    friend class BuilderShard;
+
     Execution &m_execution;
 
-    /// Need to keep track of the number of restarts;
-    /// cannot rely on solvers to send correct restart id
-    /// (e.g. Chuffed doesn't do that)
-    int restart_count = 0;
+    /// maximum number of nodes added to the tree while holding its lock
+    static constexpr int MAX_BATCH_SIZE = 1000;
+
+    /// maximum number of shards (see `shardCount`)
+    static constexpr int MAX_SHARDS = 8;
+
+    /// shard 0 runs on the builder's own thread, others on `m_shard_threads`;
+    /// shards other than 0 (and their threads) are only created once a queue
+    /// is routed to them (null until then)
+    std::vector<BuilderShard *> m_shards;
+
+    std::vector<QThread *> m_shard_threads;
+
+    /// The shard draining `queue` (started on a thread of its own if needed)
+    BuilderShard *shardFor(const NodeQueue &queue);
+
+    /// A node waiting for its parent
+    struct PendingNode
+    {
+        Message msg;
+        ParsedInfo info;
+    };
+
+    /// Nodes waiting for their parents, by parents' solver ids;
+    /// guarded by the tree mutex
+    std::unordered_map<SolverID, std::vector<PendingNode>> m_pending;
+
+    /// Add the node described by `node` (with scanned `info`) and any nodes
+    /// waiting for it to the tree; returns NoNode if the node has to wait
+    /// for its parent instead (the tree must be locked)
+    tree::NodeID addNode(const Message &node, ParsedInfo &info);
+
+    /// Add the node described by `node` to the tree (the tree must be locked
+    /// and its parent must be in the tree already)
+    tree::NodeID applyNode(const Message &node, tree::NodeID pid);
+
+    /// Store the node's nogood and info (the tree must be locked)
+    void storeNodeData(tree::NodeID nid, const Message &node, ParsedInfo &info);
 
   public:
-    TreeBuilder(Execution &ex);
+    /// The builder uses up to `shards` threads (see `shardCount`)
+    explicit TreeBuilder(Execution &ex, int shards = 1);
+
+    ~TreeBuilder();
+
+    /// Number of builder shards to use with settings `s`
+    /// (one per core unless specified, up to `MAX_SHARDS`)
+    static int shardCount(const Settings &s);
+
+    /// The shard that builds nodes of solver thread `tid`
+    static int shardOf(int32_t tid, int shards)
+    {
+        return static_cast<int>(static_cast<uint32_t>(tid) % static_cast<uint32_t>(shards));
+    }
 
     void startBuilding();
 
     void finishBuilding();
 
-    void handleNode(Message *node);
+    /// Pass `queue` on to the shard draining it
+    void handleNodes(std::shared_ptr<cpprofiler::NodeQueue> queue);
 
   signals:
 
     void buildingDone();
 };
 
-} // namespace cpprofiler
\ No newline at end of file
+} // namespace cpprofiler
+
+Q_DECLARE_METATYPE(std::shared_ptr<cpprofiler::NodeQueue>)
\ No newline at end of file
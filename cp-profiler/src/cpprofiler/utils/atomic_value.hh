@@ -0,0 +1,79 @@
+#ifndef CPPROFILER_UTILS_ATOMIC_VALUE_HH
+#define CPPROFILER_UTILS_ATOMIC_VALUE_HH
+
+#include <atomic>
+
+namespace cpprofiler
+{
+namespace utils
+{
+
+/// A copyable wrapper around std::atomic for values that one thread
+/// updates in place while others read them: stores have release and
+/// loads have acquire semantics, so a reader that sees a new value also
+/// sees everything the writer did before storing it
+template <typename T>
+class AtomicValue
+{
+    std::atomic<T> m_value;
+
+  public:
+    AtomicValue(T value = T()) : m_value(value) {}
+
+    AtomicValue(const AtomicValue &other) : m_value(other.load()) {}
+
+    AtomicValue &operator=(const AtomicValue &other)
+    {
+        store(other.load());
+        return *this;
+    }
+
+    AtomicValue &operator=(T value)
+    {
+        store(value);
+        return *this;
+    }
+
+    operator T() const { return load(); }
+
+    T load() const { return m_value.load(std::memory_order_acquire); }
+
+    void store(T value) { m_value.store(value, std::memory_order_release); }
+};
+
+/// Same as `AtomicValue` with relaxed loads and stores, for values read
+/// on their own (a reader is not guaranteed to see anything else the
+/// writer did before storing a value)
+template <typename T>
+class RelaxedAtomicValue
+{
+    std::atomic<T> m_value;
+
+  public:
+    RelaxedAtomicValue(T value = T()) : m_value(value) {}
+
+    RelaxedAtomicValue(const RelaxedAtomicValue &other) : m_value(other.load()) {}
+
+    RelaxedAtomicValue &operator=(const RelaxedAtomicValue &other)
+    {
+        store(other.load());
+        return *this;
+    }
+
+    RelaxedAtomicValue &operator=(T value)
+    {
+        store(value);
+        return *this;
+    }
+
+    operator T() const { return load(); }
+
+    T load() const { return m_value.load(std::memory_order_relaxed); }
+
+    void store(T value) { m_value.store(value, std::memory_order_relaxed); }
+};
+
+} // namespace utils
+} // namespace cpprofiler
+
+#endif
@@ -0,0 +1,43 @@
+#include "byte_arena.hh"
+
+#include <cstring>
+
+namespace cpprofiler
+{
+namespace utils
+{
+
+constexpr std::size_t ByteArena::BLOCK_SIZE;
+
+const char *ByteArena::append(const char *data, std::size_t size)
+{
+    /// strings larger than a quarter block get a block of their own
+    /// so that the free space of the shared block is not wasted
+    if (size > BLOCK_SIZE / 4)
+    {
+        m_blocks.emplace_back(new char[size]);
+        m_bytes += size;
+
+        char *dest = m_blocks.back().get();
+        std::memcpy(dest, data, size);
+        return dest;
+    }
+
+    if (size > m_free_size)
+    {
+        m_blocks.emplace_back(new char[BLOCK_SIZE]);
+        m_bytes += BLOCK_SIZE;
+        m_free = m_blocks.back().get();
+        m_free_size = BLOCK_SIZE;
+    }
+
+    char *dest = m_free;
+    std::memcpy(dest, data, size);
+    m_free += size;
+    m_free_size -= size;
+
+    return dest;
+}
+
+} // namespace utils
+} // namespace cpprofiler
@@ -0,0 +1,43 @@
+#ifndef CPPROFILER_UTILS_BYTE_ARENA_HH
+#define CPPROFILER_UTILS_BYTE_ARENA_HH
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace cpprofiler
+{
+namespace utils
+{
+
+/// Append-only storage for byte strings: copies are packed into large
+/// blocks and stay at the same address until the arena is destroyed
+class ByteArena
+{
+    static constexpr std::size_t BLOCK_SIZE = 1 << 20;
+
+    std::vector<std::unique_ptr<char[]>> m_blocks;
+
+    /// Free space in the last (shared) block
+    char *m_free = nullptr;
+    std::size_t m_free_size = 0;
+
+    std::size_t m_bytes = 0;
+
+  public:
+    ByteArena() = default;
+
+    ByteArena(const ByteArena &) = delete;
+    ByteArena &operator=(const ByteArena &) = delete;
+
+    /// Copy `size` bytes starting at `data` into the arena
+    const char *append(const char *data, std::size_t size);
+
+    /// Number of bytes allocated for the blocks
+    std::size_t bytesAllocated() const { return m_bytes; }
+};
+
+} // namespace utils
+} // namespace cpprofiler
+
+#endif
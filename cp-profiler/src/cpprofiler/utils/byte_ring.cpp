@@ -0,0 +1,80 @@
+#include "byte_ring.hh"
+
+#include <algorithm>
+#include <cstring>
+
+namespace cpprofiler
+{
+namespace utils
+{
+
+static std::size_t round_up_pow2(std::size_t n)
+{
+    std::size_t res = 1;
+    while (res < n)
+        res <<= 1;
+    return res;
+}
+
+ByteRing::ByteRing(std::size_t capacity)
+    : m_capacity(round_up_pow2(std::max<std::size_t>(capacity, 1)))
+{
+    m_data.reset(new char[m_capacity]);
+}
+
+char *ByteRing::writePtr(std::size_t &len)
+{
+    const auto write = (m_read + m_size) & mask();
+
+    /// up to the end of the buffer or to the first unread byte
+    len = std::min(freeSpace(), m_capacity - write);
+
+    return m_data.get() + write;
+}
+
+void ByteRing::commit(std::size_t len)
+{
+    m_size += len;
+}
+
+char *ByteRing::peek(std::size_t len)
+{
+    if (m_read + len > m_capacity)
+        return nullptr;
+
+    return m_data.get() + m_read;
+}
+
+void ByteRing::copyOut(char *dest, std::size_t len) const
+{
+    const auto first = std::min(len, m_capacity - m_read);
+
+    std::memcpy(dest, m_data.get() + m_read, first);
+    std::memcpy(dest + first, m_data.get(), len - first);
+}
+
+void ByteRing::consume(std::size_t len)
+{
+    m_size -= len;
+
+    /// start from the beginning when empty so that frames rarely wrap
+    m_read = m_size == 0 ? 0 : (m_read + len) & mask();
+}
+
+void ByteRing::reserve(std::size_t capacity)
+{
+    if (capacity <= m_capacity)
+        return;
+
+    const auto new_capacity = round_up_pow2(capacity);
+
+    std::unique_ptr<char[]> data{new char[new_capacity]};
+    copyOut(data.get(), m_size);
+
+    m_data = std::move(data);
+    m_capacity = new_capacity;
+    m_read = 0;
+}
+
+} // namespace utils
+} // namespace cpprofiler
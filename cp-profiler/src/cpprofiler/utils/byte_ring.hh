@@ -0,0 +1,68 @@
+#ifndef CPPROFILER_UTILS_BYTE_RING_HH
+#define CPPROFILER_UTILS_BYTE_RING_HH
+
+#include <cstddef>
+#include <memory>
+
+namespace cpprofiler
+{
+namespace utils
+{
+
+/// A circular byte buffer for framing a stream: the producer writes straight
+/// into its free space, the consumer reads from it in place whenever the data
+/// it wants does not wrap around the end of the buffer
+class ByteRing
+{
+    std::unique_ptr<char[]> m_data;
+
+    /// always a power of two
+    std::size_t m_capacity;
+
+    /// position of the first unread byte
+    std::size_t m_read = 0;
+
+    /// number of unread bytes
+    std::size_t m_size = 0;
+
+    std::size_t mask() const { return m_capacity - 1; }
+
+  public:
+    /// `capacity` is rounded up to a power of two
+    explicit ByteRing(std::size_t capacity);
+
+    ByteRing(const ByteRing &) = delete;
+    ByteRing &operator=(const ByteRing &) = delete;
+
+    std::size_t capacity() const { return m_capacity; }
+
+    /// Number of unread bytes
+    std::size_t size() const { return m_size; }
+
+    std::size_t freeSpace() const { return m_capacity - m_size; }
+
+    /// Contiguous free space to write to (call `commit` after writing);
+    /// `len` is 0 if the buffer is full
+    char *writePtr(std::size_t &len);
+
+    /// Make `len` bytes written to `writePtr` readable
+    void commit(std::size_t len);
+
+    /// The first `len` unread bytes if they are stored contiguously,
+    /// nullptr if they wrap around the end of the buffer
+    char *peek(std::size_t len);
+
+    /// Copy the first `len` unread bytes to `dest` (handles wrapping)
+    void copyOut(char *dest, std::size_t len) const;
+
+    /// Discard the first `len` unread bytes
+    void consume(std::size_t len);
+
+    /// Grow to at least `capacity` bytes keeping unread bytes
+    void reserve(std::size_t capacity);
+};
+
+} // namespace utils
+} // namespace cpprofiler
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef CPPROFILER_UTILS_CHUNKED_VECTOR_HH
+#define CPPROFILER_UTILS_CHUNKED_VECTOR_HH
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+namespace cpprofiler
+{
+namespace utils
+{
+
+/// A growable array that stores its elements in fixed-size chunks;
+/// unlike std::vector, growing never copies (or moves) existing elements,
+/// so very large columns do not need a second copy of themselves on resize.
+///
+/// Growing never invalidates existing elements either: while one thread
+/// appends, other threads may read elements below a size published to them
+/// (with release/acquire ordering) without locking.
+template <typename T, int ChunkBits = 14>
+class ChunkedVector
+{
+  public:
+    static constexpr int CHUNK_SIZE = 1 << ChunkBits;
+
+  private:
+    static constexpr int CHUNK_MASK = CHUNK_SIZE - 1;
+
+    /// Storage of all elements
+    std::vector<std::unique_ptr<T[]>> m_chunks;
+
+    /// Pointers to chunks as seen by readers; replaced by a larger copy
+    /// when full, previous copies are kept alive for concurrent readers
+    std::atomic<T **> m_dir;
+
+    /// The current and all previous chunk directories
+    std::vector<std::unique_ptr<T *[]>> m_dirs;
+
+    /// Number of pointers the current directory can hold
+    int m_dir_capacity = 0;
+
+    /// Memory used by all directories
+    std::size_t m_dir_bytes = 0;
+
+    int m_size = 0;
+
+    /// Make sure there is a chunk for position `pos`
+    void reserveFor(int pos);
+
+  public:
+    ChunkedVector();
+
+    ChunkedVector(const ChunkedVector &) = delete;
+    ChunkedVector &operator=(const ChunkedVector &) = delete;
+
+    T &operator[](int pos);
+
+    const T &operator[](int pos) const;
+
+    void push_back(const T &el);
+
+    /// Grow to `size` elements setting new elements to `val`
+    /// (shrinking keeps the allocated chunks)
+    void resize(int size, const T &val = T());
+
+    int size() const;
+
+    /// Number of elements stored contiguously from `pos` to the end of its chunk
+    static int contiguousFrom(int pos) { return CHUNK_SIZE - (pos & CHUNK_MASK); }
+
+    /// Number of bytes allocated for the elements
+    std::size_t bytesAllocated() const;
+};
+
+template <typename T, int ChunkBits>
+ChunkedVector<T, ChunkBits>::ChunkedVector() : m_dir(nullptr)
+{
+}
+
+template <typename T, int ChunkBits>
+void ChunkedVector<T, ChunkBits>::reserveFor(int pos)
+{
+    while ((pos >> ChunkBits) >= static_cast<int>(m_chunks.size()))
+    {
+        const int n_chunks = m_chunks.size();
+        m_chunks.emplace_back(new T[CHUNK_SIZE]);
+
+        if (n_chunks < m_dir_capacity)
+        {
+            /// the slot is not visible to readers until the size is published
+            m_dir.load(std::memory_order_relaxed)[n_chunks] = m_chunks.back().get();
+            continue;
+        }
+
+        m_dir_capacity = m_dir_capacity == 0 ? 4 : 2 * m_dir_capacity;
+
+        std::unique_ptr<T *[]> dir{new T *[m_dir_capacity]};
+        for (auto i = 0; i <= n_chunks; ++i)
+        {
+            dir[i] = m_chunks[i].get();
+        }
+
+        m_dir.store(dir.get(), std::memory_order_release);
+        m_dirs.push_back(std::move(dir));
+        m_dir_bytes += m_dir_capacity * sizeof(T *);
+    }
+}
+
+template <typename T, int ChunkBits>
+T &ChunkedVector<T, ChunkBits>::operator[](int pos)
+{
+    return m_dir.load(std::memory_order_acquire)[pos >> ChunkBits][pos & CHUNK_MASK];
+}
+
+template <typename T, int ChunkBits>
+const T &ChunkedVector<T, ChunkBits>::operator[](int pos) const
+{
+    return m_dir.load(std::memory_order_acquire)[pos >> ChunkBits][pos & CHUNK_MASK];
+}
+
+template <typename T, int ChunkBits>
+void ChunkedVector<T, ChunkBits>::push_back(const T &el)
+{
+    reserveFor(m_size);
+    (*this)[m_size] = el;
+    ++m_size;
+}
+
+template <typename T, int ChunkBits>
+void ChunkedVector<T, ChunkBits>::resize(int size, const T &val)
+{
+    if (size > 0)
+    {
+        reserveFor(size - 1);
+    }
+
+    for (auto i = m_size; i < size; ++i)
+    {
+        (*this)[i] = val;
+    }
+
+    m_size = size;
+}
+
+template <typename T, int ChunkBits>
+int ChunkedVector<T, ChunkBits>::size() const
+{
+    return m_size;
+}
+
+template <typename T, int ChunkBits>
+std::size_t ChunkedVector<T, ChunkBits>::bytesAllocated() const
+{
+    return m_chunks.size() * CHUNK_SIZE * sizeof(T) +
+           m_chunks.capacity() * sizeof(std::unique_ptr<T[]>) + m_dir_bytes;
+}
+
+} // namespace utils
+} // namespace cpprofiler
+
+#endif
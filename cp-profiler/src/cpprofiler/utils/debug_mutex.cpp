@@ -0,0 +1,233 @@
+#include "debug_mutex.hh"
+#include "debug.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <sstream>
+
+namespace cpprofiler
+{
+namespace utils
+{
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+/// Counters of one call site (updated without locking)
+struct SiteCounters
+{
+    std::atomic<const char *> site;
+    std::atomic<uint64_t> acquisitions;
+    std::atomic<uint64_t> contended;
+    std::atomic<uint64_t> total_wait;
+    std::atomic<uint64_t> total_hold;
+    std::atomic<uint64_t> max_hold;
+};
+
+/// Open-addressing table of call sites keyed by the address of their
+/// message; sites beyond its capacity share the last entry
+constexpr int MAX_SITES = 256;
+
+SiteCounters g_sites[MAX_SITES + 1];
+
+const char *OTHER_SITES = "<other>";
+
+SiteCounters &counters_for(const char *site)
+{
+    const auto start = std::hash<const void *>{}(site) % MAX_SITES;
+
+    for (auto probe = 0; probe < MAX_SITES; ++probe)
+    {
+        auto &entry = g_sites[(start + probe) % MAX_SITES];
+
+        const char *cur = entry.site.load(std::memory_order_acquire);
+
+        if (cur == nullptr)
+        {
+            /// claim the empty entry (unless another thread just did)
+            entry.site.compare_exchange_strong(cur, site, std::memory_order_acq_rel);
+            if (cur == nullptr)
+                return entry;
+        }
+
+        if (cur == site)
+            return entry;
+    }
+
+    auto &other = g_sites[MAX_SITES];
+    other.site.store(OTHER_SITES, std::memory_order_relaxed);
+    return other;
+}
+
+uint64_t nanoseconds_since(Clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+void update_max(std::atomic<uint64_t> &max, uint64_t value)
+{
+    auto cur = max.load(std::memory_order_relaxed);
+    while (value > cur && !max.compare_exchange_weak(cur, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+std::string escape_json(const std::string &str)
+{
+    std::string res;
+    for (auto ch : str)
+    {
+        if (ch == '"' || ch == '\\')
+            res += '\\';
+        res += ch;
+    }
+    return res;
+}
+
+} // namespace
+
+void DebugMutex::lock(const char *site)
+{
+    auto &counters = counters_for(site);
+
+    if (!MyMutex::tryLock())
+    {
+        const auto start = Clock::now();
+        MyMutex::lock();
+
+        counters.contended.fetch_add(1, std::memory_order_relaxed);
+        counters.total_wait.fetch_add(nanoseconds_since(start), std::memory_order_relaxed);
+    }
+
+    counters.acquisitions.fetch_add(1, std::memory_order_relaxed);
+
+    if (m_depth++ == 0)
+    {
+        m_site = site;
+        m_locked_at = Clock::now();
+    }
+}
+
+bool DebugMutex::tryLock()
+{
+    if (!MyMutex::tryLock())
+        return false;
+
+    counters_for("").acquisitions.fetch_add(1, std::memory_order_relaxed);
+
+    if (m_depth++ == 0)
+    {
+        m_site = "";
+        m_locked_at = Clock::now();
+    }
+
+    return true;
+}
+
+void DebugMutex::unlock(const char *)
+{
+    if (--m_depth == 0)
+    {
+        auto &counters = counters_for(m_site);
+        const auto held = nanoseconds_since(m_locked_at);
+
+        counters.total_hold.fetch_add(held, std::memory_order_relaxed);
+        update_max(counters.max_hold, held);
+    }
+
+    MyMutex::unlock();
+}
+
+namespace lock_stats
+{
+
+std::vector<LockSiteStats> collect()
+{
+    std::vector<LockSiteStats> result;
+
+    for (const auto &entry : g_sites)
+    {
+        const char *site = entry.site.load(std::memory_order_acquire);
+        if (site == nullptr)
+            continue;
+
+        /// the same message may have different addresses in different files
+        const std::string name = *site == '\0' ? "<unnamed>" : site;
+
+        auto it = std::find_if(result.begin(), result.end(), [&name](const LockSiteStats &s) {
+            return s.site == name;
+        });
+
+        if (it == result.end())
+        {
+            result.push_back({name, 0, 0, 0, 0, 0});
+            it = result.end() - 1;
+        }
+
+        it->acquisitions += entry.acquisitions.load(std::memory_order_relaxed);
+        it->contended += entry.contended.load(std::memory_order_relaxed);
+        it->total_wait += entry.total_wait.load(std::memory_order_relaxed);
+        it->total_hold += entry.total_hold.load(std::memory_order_relaxed);
+        it->max_hold = std::max(it->max_hold, entry.max_hold.load(std::memory_order_relaxed));
+    }
+
+    std::sort(result.begin(), result.end(), [](const LockSiteStats &lhs, const LockSiteStats &rhs) {
+        return lhs.total_wait > rhs.total_wait;
+    });
+
+    return result;
+}
+
+std::string toJson()
+{
+    std::ostringstream oss;
+    oss << "[";
+
+    const auto stats = collect();
+    for (auto i = 0u; i < stats.size(); ++i)
+    {
+        const auto &s = stats[i];
+        if (i > 0)
+            oss << ",";
+        oss << "\n  {\"site\": \"" << escape_json(s.site) << "\""
+            << ", \"acquisitions\": " << s.acquisitions
+            << ", \"contended\": " << s.contended
+            << ", \"total_wait_ns\": " << s.total_wait
+            << ", \"total_hold_ns\": " << s.total_hold
+            << ", \"max_hold_ns\": " << s.max_hold << "}";
+    }
+
+    oss << "\n]\n";
+    return oss.str();
+}
+
+void dump()
+{
+    print("Lock statistics (site: acquisitions, contended, wait ms, hold ms, max hold us):");
+
+    for (const auto &s : collect())
+    {
+        print("  {}: {}, {}, {}, {}, {}", s.site, s.acquisitions, s.contended,
+              s.total_wait / 1000000, s.total_hold / 1000000, s.max_hold / 1000);
+    }
+}
+
+void reset()
+{
+    for (auto &entry : g_sites)
+    {
+        entry.acquisitions.store(0, std::memory_order_relaxed);
+        entry.contended.store(0, std::memory_order_relaxed);
+        entry.total_wait.store(0, std::memory_order_relaxed);
+        entry.total_hold.store(0, std::memory_order_relaxed);
+        entry.max_hold.store(0, std::memory_order_relaxed);
+    }
+}
+
+} // namespace lock_stats
+
+} // namespace utils
+} // namespace cpprofiler
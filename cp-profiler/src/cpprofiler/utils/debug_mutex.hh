@@ -1,4 +1,3 @@
-
 #ifndef CPPROFILER_UTILS_DEBUG_MUTEX_HH
 #define CPPROFILER_UTILS_DEBUG_MUTEX_HH
 
@@ -9,6 +8,11 @@
 #endif
 #include <QDebug>
 
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
 namespace cpprofiler
 {
 namespace utils
@@ -19,31 +23,59 @@ typedef QRecursiveMutex MyMutex;
 #else
 typedef QMutex MyMutex;
 #endif
-class DebugMutex : public MyMutex
+
+/// Lock usage accumulated for one call site (identified by the message
+/// passed to `DebugMutexLocker`); times are in nanoseconds
+struct LockSiteStats
 {
-  public:
-    DebugMutex() {}
+    std::string site;
+    uint64_t acquisitions;
+    /// acquisitions that had to wait for another thread
+    uint64_t contended;
+    uint64_t total_wait;
+    uint64_t total_hold;
+    uint64_t max_hold;
+};
 
-    void lock(std::string msg)
-    {
+namespace lock_stats
+{
 
-        // qDebug() << "(" << msg.c_str() << ") lock";
+/// Statistics of every call site seen so far (sorted by total wait time)
+std::vector<LockSiteStats> collect();
 
-        MyMutex::lock();
-    }
+/// Statistics of every call site as a JSON array
+std::string toJson();
 
-    bool tryLock()
-    {
+/// Print the statistics as a table
+void dump();
 
-        // qDebug() << "try lock";
-        return MyMutex::tryLock();
-    }
+/// Reset all counters
+void reset();
 
-    void unlock(std::string msg)
-    {
-        // qDebug() << "(" << msg.c_str() << ") unlock";
-        MyMutex::unlock();
-    }
+} // namespace lock_stats
+
+/// A mutex that records, per call site, how often it is acquired, how often
+/// and for how long callers wait for it and how long it is held
+class DebugMutex : public MyMutex
+{
+    using Clock = std::chrono::steady_clock;
+
+    /// Call site of the outermost acquisition (only accessed by the owner)
+    const char *m_site = "";
+    /// When the outermost acquisition happened
+    Clock::time_point m_locked_at;
+    /// Number of nested acquisitions by the owner (recursive mutexes)
+    int m_depth = 0;
+
+  public:
+    DebugMutex() {}
+
+    /// `site` must outlive the program (normally a string literal)
+    void lock(const char *site = "");
+
+    bool tryLock();
+
+    void unlock(const char *site = "");
 };
 
 class DebugMutexLocker
@@ -51,17 +83,17 @@ class DebugMutexLocker
 
     DebugMutex *m_mutex;
 
-    std::string m_msg;
+    const char *m_site;
 
   public:
-    DebugMutexLocker(DebugMutex *m, std::string msg = "") : m_mutex(m), m_msg(msg)
+    DebugMutexLocker(DebugMutex *m, const char *site = "") : m_mutex(m), m_site(site)
     {
-        m_mutex->lock(m_msg);
+        m_mutex->lock(m_site);
     }
 
     ~DebugMutexLocker()
     {
-        m_mutex->unlock(m_msg);
+        m_mutex->unlock(m_site);
     }
 };
 
@@ -73,4 +105,4 @@ using MutexLocker = utils::DebugMutexLocker;
 } // namespace utils
 } // namespace cpprofiler
 
-#endif
\ No newline at end of file
+#endif
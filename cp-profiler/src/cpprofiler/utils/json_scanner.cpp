@@ -0,0 +1,246 @@
+#include "json_scanner.hh"
+
+#include <climits>
+
+namespace cpprofiler
+{
+namespace utils
+{
+
+constexpr int JsonScanner::MAX_DEPTH;
+
+bool JsonScanner::fail()
+{
+    m_failed = true;
+    m_pos = m_end;
+    return false;
+}
+
+char JsonScanner::peek()
+{
+    while (m_pos < m_end && (*m_pos == ' ' || *m_pos == '\n' || *m_pos == '\t' || *m_pos == '\r'))
+    {
+        ++m_pos;
+    }
+
+    return m_pos < m_end ? *m_pos : '\0';
+}
+
+bool JsonScanner::consume(char ch)
+{
+    if (m_failed || peek() != ch)
+        return false;
+
+    ++m_pos;
+    return true;
+}
+
+bool JsonScanner::atEnd()
+{
+    return !m_failed && peek() == '\0' && m_pos == m_end;
+}
+
+bool JsonScanner::beginObject()
+{
+    return consume('{');
+}
+
+bool JsonScanner::beginArray()
+{
+    return consume('[');
+}
+
+bool JsonScanner::readStringBody(const char *&str, int &len)
+{
+    const char *begin = m_pos;
+
+    while (m_pos < m_end && *m_pos != '"')
+    {
+        /// the escaped character cannot end the string
+        if (*m_pos == '\\')
+            ++m_pos;
+        ++m_pos;
+    }
+
+    if (m_pos >= m_end)
+        return fail();
+
+    str = begin;
+    len = static_cast<int>(m_pos - begin);
+    ++m_pos;
+
+    return true;
+}
+
+bool JsonScanner::nextMember(const char *&key, int &key_len)
+{
+    if (m_failed)
+        return false;
+
+    if (consume('}'))
+        return false;
+
+    consume(',');
+
+    if (!consume('"'))
+        return fail();
+
+    if (!readStringBody(key, key_len))
+        return false;
+
+    if (!consume(':'))
+        return fail();
+
+    return true;
+}
+
+bool JsonScanner::nextElement()
+{
+    if (m_failed)
+        return false;
+
+    if (consume(']'))
+        return false;
+
+    consume(',');
+
+    /// an element must follow
+    if (peek() == '\0')
+        return fail();
+
+    return true;
+}
+
+bool JsonScanner::skipNumber()
+{
+    const char *begin = m_pos;
+
+    while (m_pos < m_end)
+    {
+        const char ch = *m_pos;
+        if ((ch >= '0' && ch <= '9') || ch == '-' || ch == '+' || ch == '.' || ch == 'e' || ch == 'E')
+        {
+            ++m_pos;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    return m_pos != begin ? true : fail();
+}
+
+bool JsonScanner::skipLiteral(const char *literal)
+{
+    const auto len = std::strlen(literal);
+
+    if (static_cast<std::size_t>(m_end - m_pos) < len || std::memcmp(m_pos, literal, len) != 0)
+        return fail();
+
+    m_pos += len;
+    return true;
+}
+
+bool JsonScanner::readInt(int &value)
+{
+    if (m_failed)
+        return false;
+
+    const char first = peek();
+
+    if (first != '-' && !(first >= '0' && first <= '9'))
+        return false;
+
+    const char *pos = m_pos;
+
+    const bool negative = *pos == '-';
+    if (negative)
+        ++pos;
+
+    /// the magnitude of the most negative int
+    const long long limit = negative ? -static_cast<long long>(INT_MIN) : INT_MAX;
+
+    long long res = 0;
+    const char *digits = pos;
+
+    while (pos < m_end && *pos >= '0' && *pos <= '9')
+    {
+        /// stop accumulating once out of range (the digits are still consumed)
+        if (res <= limit)
+            res = res * 10 + (*pos - '0');
+        ++pos;
+    }
+
+    if (pos == digits)
+        return fail();
+
+    /// a fraction or an exponent makes it a non-integral number; a number
+    /// that is not an int is left for `skipValue`, like any other value
+    if (pos < m_end && (*pos == '.' || *pos == 'e' || *pos == 'E'))
+        return false;
+
+    if (res > limit)
+        return false;
+
+    m_pos = pos;
+    value = static_cast<int>(negative ? -res : res);
+    return true;
+}
+
+bool JsonScanner::skipValue()
+{
+    if (m_failed)
+        return false;
+
+    const char *str;
+    int len;
+
+    switch (peek())
+    {
+    case '{':
+    {
+        if (++m_depth > MAX_DEPTH)
+            return fail();
+
+        ++m_pos;
+        while (nextMember(str, len))
+        {
+            if (!skipValue())
+                return false;
+        }
+
+        --m_depth;
+        return !m_failed;
+    }
+    case '[':
+    {
+        if (++m_depth > MAX_DEPTH)
+            return fail();
+
+        ++m_pos;
+        while (nextElement())
+        {
+            if (!skipValue())
+                return false;
+        }
+
+        --m_depth;
+        return !m_failed;
+    }
+    case '"':
+        ++m_pos;
+        return readStringBody(str, len);
+    case 't':
+        return skipLiteral("true");
+    case 'f':
+        return skipLiteral("false");
+    case 'n':
+        return skipLiteral("null");
+    default:
+        return skipNumber();
+    }
+}
+
+} // namespace utils
+} // namespace cpprofiler
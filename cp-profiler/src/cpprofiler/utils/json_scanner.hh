@@ -0,0 +1,83 @@
+#ifndef CPPROFILER_UTILS_JSON_SCANNER_HH
+#define CPPROFILER_UTILS_JSON_SCANNER_HH
+
+#include <cstring>
+
+namespace cpprofiler
+{
+namespace utils
+{
+
+/// A forward-only reader of JSON text that never allocates: values are read
+/// in place (strings are returned as pointers into the input, escapes not
+/// decoded) and values the caller is not interested in are skipped.
+///
+/// It does not validate the input fully: it stops at the first thing it
+/// cannot read and reports it via `failed()`.
+class JsonScanner
+{
+    const char *m_pos;
+    const char *m_end;
+
+    bool m_failed = false;
+
+    /// Nesting depth of the values being skipped
+    int m_depth = 0;
+
+    static constexpr int MAX_DEPTH = 256;
+
+    /// Skip whitespace and return the next character (0 at the end)
+    char peek();
+
+    /// Consume `ch` if it is the next character
+    bool consume(char ch);
+
+    bool fail();
+
+    /// Read a string (the opening quote already consumed)
+    bool readStringBody(const char *&str, int &len);
+
+    bool skipNumber();
+
+    bool skipLiteral(const char *literal);
+
+  public:
+    JsonScanner(const char *begin, const char *end) : m_pos(begin), m_end(end) {}
+
+    bool failed() const { return m_failed; }
+
+    /// Whether only whitespace is left
+    bool atEnd();
+
+    /// Consume the opening brace of an object if it is the next value
+    bool beginObject();
+
+    /// Consume the opening bracket of an array if it is the next value
+    bool beginArray();
+
+    /// Read the key of the next member of the current object and the colon
+    /// after it; returns false (consuming the closing brace) if there are none
+    bool nextMember(const char *&key, int &key_len);
+
+    /// Move to the next element of the current array; returns false
+    /// (consuming the closing bracket) if there are none
+    bool nextElement();
+
+    /// Read the next value if it is an integer that fits into an int (other
+    /// values, including larger and non-integral numbers, are left for `skipValue`)
+    bool readInt(int &value);
+
+    /// Skip the next value (including everything nested in it)
+    bool skipValue();
+
+    /// Whether a key read by `nextMember` is `name`
+    static bool keyIs(const char *key, int key_len, const char *name)
+    {
+        return static_cast<int>(std::strlen(name)) == key_len && std::memcmp(key, name, key_len) == 0;
+    }
+};
+
+} // namespace utils
+} // namespace cpprofiler
+
+#endif
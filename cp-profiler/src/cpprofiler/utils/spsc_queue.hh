@@ -0,0 +1,95 @@
+#ifndef CPPROFILER_UTILS_SPSC_QUEUE_HH
+#define CPPROFILER_UTILS_SPSC_QUEUE_HH
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace cpprofiler
+{
+namespace utils
+{
+
+/// A bounded queue for exactly one producer thread and one consumer thread
+/// that does not lock. Its slots are allocated once and reused: the producer
+/// fills a slot in place (e.g. by assignment, which reuses the slot's memory)
+/// and the consumer reads it in place before releasing it.
+template <typename T>
+class SpscQueue
+{
+    std::unique_ptr<T[]> m_slots;
+
+    /// always a power of two
+    const int m_capacity;
+
+    /// Number of elements ever pushed (modified by the producer only)
+    std::atomic<uint64_t> m_tail;
+
+    /// keep the two counters on different cache lines
+    char m_padding[64];
+
+    /// Number of elements ever popped (modified by the consumer only)
+    std::atomic<uint64_t> m_head;
+
+    static int roundUp(int capacity)
+    {
+        int res = 1;
+        while (res < capacity)
+            res <<= 1;
+        return res;
+    }
+
+  public:
+    /// `capacity` is rounded up to a power of two
+    explicit SpscQueue(int capacity)
+        : m_slots(new T[roundUp(capacity)]), m_capacity(roundUp(capacity)), m_tail(0), m_head(0)
+    {
+    }
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    int capacity() const { return m_capacity; }
+
+    /// Number of elements in the queue (exact for the consumer,
+    /// a lower bound on the free space for the producer)
+    int size() const
+    {
+        return static_cast<int>(m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire));
+    }
+
+    /// Producer: the slot to fill next, or nullptr if the queue is full;
+    /// the element becomes visible to the consumer on `push`
+    T *back()
+    {
+        const auto tail = m_tail.load(std::memory_order_relaxed);
+
+        if (tail - m_head.load(std::memory_order_acquire) == static_cast<uint64_t>(m_capacity))
+            return nullptr;
+
+        return &m_slots[tail & (m_capacity - 1)];
+    }
+
+    /// Producer: publish the slot returned by `back`
+    void push()
+    {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /// Consumer: the `i`-th element from the front (`i` < `size()`)
+    T &at(int i)
+    {
+        return m_slots[(m_head.load(std::memory_order_relaxed) + i) & (m_capacity - 1)];
+    }
+
+    /// Consumer: release the first `n` elements to the producer
+    void pop(int n)
+    {
+        m_head.store(m_head.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+};
+
+} // namespace utils
+} // namespace cpprofiler
+
+#endif
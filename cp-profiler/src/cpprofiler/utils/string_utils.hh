@@ -1,3 +1,7 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
 #include <vector>
 #include <string>
 
@@ -8,5 +12,38 @@ namespace utils
 
 std::vector<std::string> split(const std::string &str, char delim, bool include_empty = false);
 std::string join(const std::vector<std::string>& strs, char sep);
+
+/// A reference to characters stored elsewhere (e.g. to part of a string),
+/// used to look up std::string keys without constructing a string
+struct StringRef
+{
+    const char *data;
+    std::size_t size;
+
+    StringRef() : data(nullptr), size(0) {}
+    StringRef(const char *data_, std::size_t size_) : data(data_), size(size_) {}
+    StringRef(const std::string &str) : data(str.data()), size(str.size()) {}
+
+    bool operator==(const StringRef &other) const
+    {
+        return size == other.size && (size == 0 || std::memcmp(data, other.data, size) == 0);
+    }
+
+    std::string str() const { return std::string(data, size); }
+};
+
+struct StringRefHash
+{
+    /// FNV-1a
+    std::size_t operator()(const StringRef &str) const
+    {
+        std::size_t hash = 14695981039346656037ULL;
+        for (std::size_t i = 0; i < str.size; ++i)
+        {
+            hash = (hash ^ static_cast<unsigned char>(str.data[i])) * 1099511628211ULL;
+        }
+        return hash;
+    }
+};
 }
 } // namespace cpprofiler
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "task_pool.hh"
+
+#include <algorithm>
+
+namespace cpprofiler
+{
+namespace utils
+{
+
+TaskPool::TaskPool(int threads)
+{
+    const auto count = std::max(1, threads);
+
+    for (auto i = 0; i < count; ++i)
+    {
+        m_queues.emplace_back(new Queue);
+    }
+
+    for (auto i = 1; i < count; ++i)
+    {
+        m_threads.emplace_back(&TaskPool::threadLoop, this, i);
+    }
+}
+
+TaskPool::~TaskPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+
+    m_wake.notify_all();
+
+    for (auto &thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+void TaskPool::run(std::vector<Task> tasks)
+{
+    if (tasks.empty())
+        return;
+
+    m_remaining = static_cast<int>(tasks.size());
+
+    /// deal the tasks out evenly; uneven ones get stolen
+    for (auto i = 0u; i < tasks.size(); ++i)
+    {
+        auto &queue = *m_queues[i % m_queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(tasks[i]));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_batch;
+    }
+
+    m_wake.notify_all();
+
+    work(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]() { return m_remaining == 0; });
+}
+
+bool TaskPool::take(int self, Task &task)
+{
+    const auto count = static_cast<int>(m_queues.size());
+
+    for (auto i = 0; i < count; ++i)
+    {
+        auto &queue = *m_queues[(self + i) % count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (queue.tasks.empty())
+            continue;
+
+        if (i == 0)
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+void TaskPool::work(int self)
+{
+    Task task;
+
+    while (take(self, task))
+    {
+        task();
+        task = nullptr;
+
+        if (--m_remaining == 0)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done.notify_all();
+        }
+    }
+}
+
+void TaskPool::threadLoop(int self)
+{
+    int seen = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&]() { return m_stop || m_batch != seen; });
+
+            if (m_stop)
+                return;
+
+            seen = m_batch;
+        }
+
+        work(self);
+    }
+}
+
+} // namespace utils
+} // namespace cpprofiler
@@ -0,0 +1,81 @@
+#ifndef CPPROFILER_UTILS_TASK_POOL_HH
+#define CPPROFILER_UTILS_TASK_POOL_HH
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cpprofiler
+{
+namespace utils
+{
+
+/// A fixed set of threads that run batches of independent tasks. Every
+/// thread (including the one calling `run`) has its own queue of tasks
+/// and, once it is empty, steals tasks from the other queues, so uneven
+/// tasks still keep all threads busy.
+class TaskPool
+{
+  public:
+    using Task = std::function<void()>;
+
+    /// Create a pool that runs tasks on `threads` threads in total
+    /// (`threads - 1` of them are started by the pool)
+    explicit TaskPool(int threads);
+
+    ~TaskPool();
+
+    TaskPool(const TaskPool &) = delete;
+    TaskPool &operator=(const TaskPool &) = delete;
+
+    /// Number of threads tasks are run on (including the caller of `run`)
+    int threadCount() const { return static_cast<int>(m_queues.size()); }
+
+    /// Run every task in `tasks` and return once all of them are done;
+    /// the calling thread runs tasks too
+    void run(std::vector<Task> tasks);
+
+  private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    /// One queue per thread (the caller of `run` uses the first one)
+    std::vector<std::unique_ptr<Queue>> m_queues;
+
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    /// Signals a new batch (or that the pool is being destroyed)
+    std::condition_variable m_wake;
+    /// Signals that the last task of the batch is done
+    std::condition_variable m_done;
+
+    /// Incremented with every batch
+    int m_batch = 0;
+    bool m_stop = false;
+
+    /// Tasks of the current batch that are not done yet
+    std::atomic<int> m_remaining{0};
+
+    /// Take a task from the back of queue `self`, or steal
+    /// one from the front of another queue
+    bool take(int self, Task &task);
+
+    /// Run tasks until there are none left to take
+    void work(int self);
+
+    void threadLoop(int self);
+};
+
+} // namespace utils
+} // namespace cpprofiler
+
+#endif
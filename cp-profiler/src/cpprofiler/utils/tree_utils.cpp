@@ -28,17 +28,6 @@ int count_descendants(const NodeTree &nt, NodeID nid)
     return count;
 }
 
-int calculate_depth(const NodeTree &nt, NodeID nid)
-{
-    int depth = 0;
-    while (nid != NodeID::NoNode)
-    {
-        nid = nt.getParent(nid);
-        ++depth;
-    }
-    return depth;
-}
-
 std::vector<NodeID> nodes_below(const tree::NodeTree &nt, NodeID nid)
 {
 
@@ -21,9 +21,6 @@ namespace utils
 /// Count all descendants of `n`
 int count_descendants(const tree::NodeTree &nt, NodeID n);
 
-/// Compute the node's depth (the distance to the root)
-int calculate_depth(const tree::NodeTree &nt, NodeID nid);
-
 /// Apply `action` to `root` and to all of its descendants
 void apply_below(const tree::NodeTree &nt, NodeID root, const NodeAction &action);
 
@@ -1,15 +1,39 @@
+#include <cstring>
 #include <iostream>
+#include <memory>
 
 #include <QApplication>
 
 #include "cpprofiler/command_line_parser.hh"
 #include "cpprofiler/conductor.hh"
+#include "cpprofiler/headless_conductor.hh"
 #include "cpprofiler/options.hh"
 
 #include "cpprofiler/tests/tree_test.hh"
 #include "cpprofiler/tests/execution_test.hh"
+#include "cpprofiler/tests/headless_test.hh"
 #include "cpprofiler/utils/debug.hh"
 
+/// Whether option `name` is among the arguments (needed before
+/// the application, and hence the command line parser, exists)
+static bool hasOption(int argc, char *argv[], const char *name)
+{
+    const auto len = std::strlen(name);
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+
+        while (*arg == '-')
+            ++arg;
+
+        if (std::strncmp(arg, name, len) == 0 && (arg[len] == '\0' || arg[len] == '='))
+            return true;
+    }
+
+    return false;
+}
+
 int main(int argc, char *argv[])
 {
 
@@ -19,11 +43,43 @@ int main(int argc, char *argv[])
     QGL::setPreferredPaintEngine(QPaintEngine::OpenGL);
 #endif
 
-    QApplication app(argc, argv);
+    if (hasOption(argc, argv, "run_tests"))
+    {
+        QCoreApplication app(argc, argv);
+
+        tests::tree_test::run();
+        tests::headless_test::run();
+
+        print("tests passed");
+
+        return 0;
+    }
+
+    const bool headless = hasOption(argc, argv, "headless");
+
+    std::unique_ptr<QCoreApplication> app;
+
+    if (!headless)
+    {
+        app.reset(new QApplication(argc, argv));
+    }
+    else if (hasOption(argc, argv, "save_pixel_tree"))
+    {
+        /// the pixel tree is drawn by a (never shown) widget; no display is needed
+        if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+
+        app.reset(new QApplication(argc, argv));
+    }
+    else
+    {
+        app.reset(new QCoreApplication(argc, argv));
+    }
+
     QCoreApplication::setApplicationName("CP-Profiler");
 
     CommandLineParser cl_parser;
-    cl_parser.process(app);
+    cl_parser.process(*app);
 
     Options options;
 
@@ -63,13 +119,34 @@ int main(int argc, char *argv[])
         options.pixel_tree_compression = cs.toInt();
     }
 
+    if (cl_parser.isSet(cl_options::capture))
+    {
+        options.capture_path = cl_parser.value(cl_options::capture).toStdString();
+        print("recording solver messages to: {}", options.capture_path);
+    }
+
+    if (cl_parser.isSet(cl_options::replay))
+    {
+        options.replay_path = cl_parser.value(cl_options::replay).toStdString();
+        options.replay_fast = cl_parser.isSet(cl_options::replay_fast);
+    }
+
+    options.contour_layout = cl_parser.isSet(cl_options::contour_layout);
+
+    if (headless)
+    {
+        HeadlessConductor conductor(std::move(options));
+
+        return app->exec();
+    }
+
     Conductor conductor(std::move(options));
 
     conductor.show();
 
     tests::execution::run(conductor);
 
-    return app.exec();
+    return app->exec();
 }
 
 /// Threads
@@ -0,0 +1,13 @@
+#include <QCoreApplication>
+
+#include "cpprofiler/tests/tree_bench.hh"
+
+int main(int argc, char *argv[])
+{
+
+    QCoreApplication app(argc, argv);
+
+    cpprofiler::tests::tree_bench::run();
+
+    return 0;
+}
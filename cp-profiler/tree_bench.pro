@@ -0,0 +1,12 @@
+TEMPLATE = app
+
+TARGET = tree-bench
+
+QT += widgets network sql
+
+CONFIG += c++11
+
+include(cp-profiler.pri)
+SOURCES += $$PWD/src/main_tree_bench.cpp \
+    $$PWD/src/cpprofiler/tests/tree_bench.cpp
+HEADERS += $$PWD/src/cpprofiler/tests/tree_bench.hh